@@ -5,8 +5,10 @@
 
 #include <addressindex.h>
 
+#include <hash.h>
 #include <primitives/transaction.h>
 #include <script/interpreter.h>
+#include <script/standard.h>
 #include <util.h>
 
 bool ExtractIndexInfo(const CScript *pScript, int &scriptType, std::vector<uint8_t> &hashBytes)
@@ -29,6 +31,50 @@ bool ExtractIndexInfo(const CScript *pScript, int &scriptType, std::vector<uint8
         hashBytes.assign(pScript->begin()+28, pScript->begin()+48);
         scriptType = ADDR_INDT_SCRIPT_ADDRESS;
     }
+    else
+    if (HasIsCoinstakeOp(*pScript))
+    {
+        //other cold stake scripts use their owners address too
+        CScript scriptStake, scriptOwner;
+        if (SplitConditionalCoinstakeScript(*pScript, scriptStake, scriptOwner) && !HasIsCoinstakeOp(scriptOwner))
+            return ExtractIndexInfo(&scriptOwner, scriptType, hashBytes);
+    }
+    else
+    {
+        //the other forms a wallet matches for a key or script use its P2PKH or P2SH address
+        txnouttype whichType;
+        std::vector<std::vector<uint8_t> > vSolutions;
+        if (!Solver(*pScript, whichType, vSolutions))
+            return true;
+
+        switch (whichType)
+        {
+        case TX_PUBKEY:
+        {
+            uint160 hash = Hash160(vSolutions[0].begin(), vSolutions[0].end());
+            hashBytes.assign(hash.begin(), hash.end());
+            scriptType = ADDR_INDT_PUBKEY_ADDRESS;
+            break;
+        }
+        case TX_WITNESS_V0_KEYHASH:
+        case TX_TIMELOCKED_PUBKEYHASH:
+            if (vSolutions[0].size() == 20)
+            {
+                hashBytes = vSolutions[0];
+                scriptType = ADDR_INDT_PUBKEY_ADDRESS;
+            }
+            break;
+        case TX_TIMELOCKED_SCRIPTHASH:
+            if (vSolutions[0].size() == 20)
+            {
+                hashBytes = vSolutions[0];
+                scriptType = ADDR_INDT_SCRIPT_ADDRESS;
+            }
+            break;
+        default:
+            break;
+        }
+    }
 
     return true;
 };
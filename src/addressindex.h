@@ -97,6 +97,36 @@ struct CAddressUnspentValue {
     }
 };
 
+/** Running totals of the address index entries of an address */
+struct CAddressBalanceValue {
+    CAmount balance;
+    CAmount received;
+    int64_t txCount;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(balance);
+        READWRITE(received);
+        READWRITE(txCount);
+    }
+
+    CAddressBalanceValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+        txCount = 0;
+    }
+
+    bool IsNull() const {
+        return (txCount == 0);
+    }
+};
+
 struct CAddressIndexKey {
     unsigned int type;
     uint256 hashBytes;
@@ -300,6 +330,13 @@ struct CMempoolAddressDeltaKeyCompare
     }
 };
 
+/**
+ * Get the address an output script is indexed under, scriptType is ADDR_INDT_UNKNOWN if none.
+ * Pay to pubkey, witness keyhash, timelocked and cold stake scripts are indexed under the P2PKH
+ * or P2SH address of their key or script, the owner's for cold stake, so an address lists every
+ * output a wallet holding its key or script matches. Indexes without the "addressindexkeys" flag
+ * were written before and hold P2PKH, P2SH and P2SH cold stake outputs only.
+ */
 bool ExtractIndexInfo(const CScript *pScript, int &scriptType, std::vector<uint8_t> &hashBytes);
 bool ExtractIndexInfo(const CTxOut *out, int &scriptType, std::vector<uint8_t> &hashBytes, CAmount &nValue, const CScript *&pScript);
 
@@ -4,7 +4,9 @@
 
 #include <bench/bench.h>
 
+#include <crypto/neoscrypt.h>
 #include <crypto/sha256.h>
+#include <crypto/x16r/x16r.h>
 #include <key.h>
 #include <validation.h>
 #include <util.h>
@@ -43,6 +45,8 @@ main(int argc, char** argv)
     }
 
     SHA256AutoDetect();
+    X16RAutoDetect();
+    neoscrypt_batch_autodetect();
     RandomInit();
     ECC_Start();
     SetupEnvironment();
@@ -0,0 +1,77 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <hash.h>
+#include <pos/kernel.h>
+#include <random.h>
+#include <streams.h>
+
+#include <assert.h>
+#include <vector>
+
+/* Number of coins in a large cold staking pool */
+static const int STAKE_CANDIDATES = 20000;
+
+/* Target no kernel meets, so every search hashes the whole pool */
+static const unsigned int UNREACHABLE_BITS = 0x03000001;
+
+struct KernelSearchSetup
+{
+    CBlockIndex index;
+    std::vector<CStakeCandidate> vCandidates;
+
+    KernelSearchSetup()
+    {
+        index.bnStakeModifier = GetRandHash();
+        for (int i = 0; i < STAKE_CANDIDATES; i++) {
+            CStakeCandidate candidate;
+            candidate.prevout = COutPoint(GetRandHash(), i % 4);
+            candidate.nValue = 1000 * COIN;
+            candidate.nBlockFromTime = 1500000000;
+            vCandidates.push_back(candidate);
+        }
+    }
+};
+
+// The kernel hash as serialized through a CDataStream before
+static void KernelHashStream(benchmark::State& state)
+{
+    KernelSearchSetup setup;
+    const CStakeCandidate& candidate = setup.vCandidates[0];
+    uint32_t nTime = 1600000000;
+    uint256 hash;
+    while (state.KeepRunning()) {
+        CDataStream ss(SER_GETHASH, 0);
+        ss << setup.index.bnStakeModifier;
+        ss << candidate.nBlockFromTime << candidate.prevout.hash << candidate.prevout.n << nTime;
+        hash = Hash(ss.begin(), ss.end());
+    }
+    assert(hash == ComputeKernelHash(setup.index.bnStakeModifier, candidate.nBlockFromTime, candidate.prevout, nTime));
+}
+
+static void KernelHashPreimage(benchmark::State& state)
+{
+    KernelSearchSetup setup;
+    const CStakeCandidate& candidate = setup.vCandidates[0];
+    uint32_t nTime = 1600000000;
+    while (state.KeepRunning()) {
+        ComputeKernelHash(setup.index.bnStakeModifier, candidate.nBlockFromTime, candidate.prevout, nTime);
+    }
+}
+
+static void KernelSearchPool(benchmark::State& state)
+{
+    KernelSearchSetup setup;
+    uint32_t nTime = 1600000000;
+    while (state.KeepRunning()) {
+        size_t nKernel = FindStakeKernel(&setup.index, UNREACHABLE_BITS, nTime, setup.vCandidates);
+        assert(nKernel == setup.vCandidates.size());
+    }
+}
+
+BENCHMARK(KernelHashStream, 100 * 1000);
+BENCHMARK(KernelHashPreimage, 100 * 1000);
+BENCHMARK(KernelSearchPool, 20);
@@ -0,0 +1,36 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <crypto/neoscrypt.h>
+
+#include <vector>
+
+/* Number of headers hashed per batch iteration */
+static const size_t HEADER_BATCH = 64;
+
+static void Neoscrypt(benchmark::State& state)
+{
+    unsigned char header[80] = {0};
+    unsigned char hash[32];
+    while (state.KeepRunning()) {
+        neoscrypt(header, hash, 0);
+        header[79]++;
+    }
+}
+
+static void NeoscryptBatch(benchmark::State& state)
+{
+    std::vector<unsigned char> headers(HEADER_BATCH * 80, 0);
+    std::vector<unsigned char> hashes(HEADER_BATCH * 32);
+    for (size_t i = 0; i < HEADER_BATCH; i++)
+        headers[i * 80 + 76] = i;
+    while (state.KeepRunning()) {
+        neoscrypt_batch(headers.data(), hashes.data(), HEADER_BATCH, 0);
+        headers[79]++;
+    }
+}
+
+BENCHMARK(Neoscrypt, 3000);
+BENCHMARK(NeoscryptBatch, 100);
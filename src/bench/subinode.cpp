@@ -0,0 +1,93 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <key.h>
+#include <random.h>
+#include <subinode/subinodeman.h>
+#include <validation.h>
+#include <version.h>
+
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+
+/* Number of subinodes in the ranked list */
+static const int SUBINODE_COUNT = 1000;
+
+/* A list of enabled subinodes and a one block active chain to rank them for */
+struct SubinodeRankSetup
+{
+    uint256 hash;
+    CBlockIndex index;
+    CSubinodeMan man;
+    std::vector<CTxIn> vecVins;
+
+    SubinodeRankSetup()
+    {
+        hash = GetRandHash();
+        index.phashBlock = &hash;
+        index.nHeight = 0;
+        {
+            LOCK(cs_main);
+            chainActive.SetTip(&index);
+        }
+
+        CKey key;
+        key.MakeNewKey(true);
+        CPubKey pubKey = key.GetPubKey();
+        for (int i = 0; i < SUBINODE_COUNT; i++) {
+            CTxIn vin(COutPoint(GetRandHash(), 0));
+            CSubinode mn(CService(), vin, pubKey, pubKey, PROTOCOL_VERSION);
+            man.Add(mn);
+            vecVins.push_back(vin);
+        }
+    }
+
+    ~SubinodeRankSetup()
+    {
+        LOCK(cs_main);
+        chainActive.SetTip(nullptr);
+    }
+};
+
+// Scoring and sorting the whole list, which every rank lookup used to do
+static void SubinodeRankScoreAll(benchmark::State& state)
+{
+    SubinodeRankSetup setup;
+    std::vector<CSubinode> vecSubinodes = setup.man.GetFullSubinodeVector();
+    uint256 blockHash = setup.index.GetBlockPoWHash();
+    while (state.KeepRunning()) {
+        std::vector<std::pair<int64_t, CSubinode*> > vecScores;
+        for (CSubinode& mn : vecSubinodes)
+            vecScores.push_back(std::make_pair(mn.CalculateScore(blockHash).GetCompact(false), &mn));
+        std::sort(vecScores.rbegin(), vecScores.rend());
+    }
+}
+
+// Ranking again after a list change, the scores are still cached
+static void SubinodeRankRebuild(benchmark::State& state)
+{
+    SubinodeRankSetup setup;
+    while (state.KeepRunning()) {
+        setup.man.InvalidateRankCache();
+        int nRank = setup.man.GetSubinodeRank(setup.vecVins[0], 0);
+        assert(nRank >= 1);
+    }
+}
+
+static void SubinodeRankCached(benchmark::State& state)
+{
+    SubinodeRankSetup setup;
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        int nRank = setup.man.GetSubinodeRank(setup.vecVins[i++ % SUBINODE_COUNT], 0);
+        assert(nRank >= 1);
+    }
+}
+
+BENCHMARK(SubinodeRankScoreAll, 50);
+BENCHMARK(SubinodeRankRebuild, 200);
+BENCHMARK(SubinodeRankCached, 100 * 1000);
@@ -0,0 +1,82 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <crypto/x16r/x16r.h>
+#include <uint256.h>
+
+#include <vector>
+
+/* Number of nonces hashed per batch iteration */
+static const size_t NONCE_BATCH = 64;
+
+static void X16RAlgo(benchmark::State& state, int nAlgo)
+{
+    unsigned char buf[64] = {0};
+    while (state.KeepRunning())
+        X16RHashAlgo(nAlgo, buf, sizeof(buf), buf);
+}
+
+static void X16R_Blake_64b(benchmark::State& state) { X16RAlgo(state, 0); }
+static void X16R_Bmw_64b(benchmark::State& state) { X16RAlgo(state, 1); }
+static void X16R_Groestl_64b(benchmark::State& state) { X16RAlgo(state, 2); }
+static void X16R_Jh_64b(benchmark::State& state) { X16RAlgo(state, 3); }
+static void X16R_Keccak_64b(benchmark::State& state) { X16RAlgo(state, 4); }
+static void X16R_Skein_64b(benchmark::State& state) { X16RAlgo(state, 5); }
+static void X16R_Luffa_64b(benchmark::State& state) { X16RAlgo(state, 6); }
+static void X16R_Cubehash_64b(benchmark::State& state) { X16RAlgo(state, 7); }
+static void X16R_Shavite_64b(benchmark::State& state) { X16RAlgo(state, 8); }
+static void X16R_Simd_64b(benchmark::State& state) { X16RAlgo(state, 9); }
+static void X16R_Echo_64b(benchmark::State& state) { X16RAlgo(state, 10); }
+static void X16R_Hamsi_64b(benchmark::State& state) { X16RAlgo(state, 11); }
+static void X16R_Fugue_64b(benchmark::State& state) { X16RAlgo(state, 12); }
+static void X16R_Shabal_64b(benchmark::State& state) { X16RAlgo(state, 13); }
+static void X16R_Whirlpool_64b(benchmark::State& state) { X16RAlgo(state, 14); }
+static void X16R_Sha512_64b(benchmark::State& state) { X16RAlgo(state, 15); }
+
+static void X16R_Header(benchmark::State& state)
+{
+    uint256 prevHash = uint256S("0x0123456789abcdeffedcba987654321000112233445566778899aabbccddeeff");
+    unsigned char header[80] = {0};
+    unsigned char hash[CX16R::OUTPUT_SIZE];
+    while (state.KeepRunning()) {
+        CX16R(prevHash.begin()).Hash(header, sizeof(header), hash);
+        header[79]++;
+    }
+}
+
+static void X16R_HeaderNonceBatch(benchmark::State& state)
+{
+    uint256 prevHash = uint256S("0x0123456789abcdeffedcba987654321000112233445566778899aabbccddeeff");
+    unsigned char prefix[X16R_HEADER_PREFIX_SIZE] = {0};
+    std::vector<uint32_t> nonces(NONCE_BATCH);
+    std::vector<unsigned char> hashes(NONCE_BATCH * CX16R::OUTPUT_SIZE);
+    CX16R hasher(prevHash.begin());
+    hasher.SetHeaderPrefix(prefix);
+    uint32_t nNonce = 0;
+    while (state.KeepRunning()) {
+        for (uint32_t& n : nonces)
+            n = nNonce++;
+        hasher.HashNonces(nonces.data(), nonces.size(), hashes.data());
+    }
+}
+
+BENCHMARK(X16R_Blake_64b, 200 * 1000);
+BENCHMARK(X16R_Bmw_64b, 200 * 1000);
+BENCHMARK(X16R_Groestl_64b, 50 * 1000);
+BENCHMARK(X16R_Jh_64b, 50 * 1000);
+BENCHMARK(X16R_Keccak_64b, 200 * 1000);
+BENCHMARK(X16R_Skein_64b, 200 * 1000);
+BENCHMARK(X16R_Luffa_64b, 100 * 1000);
+BENCHMARK(X16R_Cubehash_64b, 50 * 1000);
+BENCHMARK(X16R_Shavite_64b, 100 * 1000);
+BENCHMARK(X16R_Simd_64b, 50 * 1000);
+BENCHMARK(X16R_Echo_64b, 50 * 1000);
+BENCHMARK(X16R_Hamsi_64b, 50 * 1000);
+BENCHMARK(X16R_Fugue_64b, 50 * 1000);
+BENCHMARK(X16R_Shabal_64b, 200 * 1000);
+BENCHMARK(X16R_Whirlpool_64b, 50 * 1000);
+BENCHMARK(X16R_Sha512_64b, 200 * 1000);
+BENCHMARK(X16R_Header, 5 * 1000);
+BENCHMARK(X16R_HeaderNonceBatch, 100);
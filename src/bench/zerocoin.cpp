@@ -0,0 +1,84 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <libzerocoin/Zerocoin.h>
+#include <zerocoin/zerocoin.h>
+
+#include <assert.h>
+#include <vector>
+
+/* Number of other coins in the accumulator the spent coin is proven to be in */
+static const int ACCUMULATED_COINS = 2;
+
+/* Exponent of the size the accumulator proof raises the QR_N generators to */
+static CBigNum RandomProofExponent()
+{
+    return CBigNum::randBignum(ZCParams->accumulatorParams.accumulatorModulus / 4);
+}
+
+static void ZerocoinPowMod(benchmark::State& state)
+{
+    const libzerocoin::IntegerGroupParams& qrn = ZCParams->accumulatorParams.accumulatorQRNCommitmentGroup;
+    CBigNum e = RandomProofExponent();
+    CBigNum r;
+    while (state.KeepRunning())
+        r = qrn.h.pow_mod(e, ZCParams->accumulatorParams.accumulatorModulus);
+}
+
+static void ZerocoinFixedBasePow(benchmark::State& state)
+{
+    const libzerocoin::IntegerGroupParams& qrn = ZCParams->accumulatorParams.accumulatorQRNCommitmentGroup;
+    CBigNum e = RandomProofExponent();
+    CBigNum r;
+    while (state.KeepRunning())
+        r = qrn.hPow(e);
+    assert(r == qrn.h.pow_mod(e, ZCParams->accumulatorParams.accumulatorModulus));
+}
+
+struct ZerocoinSpendSetup
+{
+    libzerocoin::PrivateCoin coin;
+    libzerocoin::Accumulator accumulator;
+    libzerocoin::AccumulatorWitness witness;
+    libzerocoin::SpendMetaData metaData;
+
+    ZerocoinSpendSetup() :
+        coin(ZCParams, libzerocoin::ZQ_ONE),
+        accumulator(ZCParams, libzerocoin::ZQ_ONE),
+        witness(ZCParams, accumulator, coin.getPublicCoin()),
+        metaData(0, uint256S("0x0123456789abcdeffedcba987654321000112233445566778899aabbccddeeff"))
+    {
+        for (int i = 0; i < ACCUMULATED_COINS; i++) {
+            libzerocoin::PrivateCoin other(ZCParams, libzerocoin::ZQ_ONE);
+            accumulator += other.getPublicCoin();
+            witness.AddElement(other.getPublicCoin());
+        }
+        accumulator += coin.getPublicCoin();
+    }
+};
+
+static void ZerocoinSpendCreate(benchmark::State& state)
+{
+    ZerocoinSpendSetup setup;
+    while (state.KeepRunning()) {
+        libzerocoin::CoinSpend spend(ZCParams, setup.coin, setup.accumulator, setup.witness, setup.metaData);
+    }
+}
+
+static void ZerocoinSpendVerify(benchmark::State& state)
+{
+    ZerocoinSpendSetup setup;
+    libzerocoin::CoinSpend spend(ZCParams, setup.coin, setup.accumulator, setup.witness, setup.metaData);
+    spend.setVersion(setup.coin.getVersion());
+    while (state.KeepRunning()) {
+        bool fValid = spend.Verify(setup.accumulator, setup.metaData);
+        assert(fValid);
+    }
+}
+
+BENCHMARK(ZerocoinPowMod, 50);
+BENCHMARK(ZerocoinFixedBasePow, 50);
+BENCHMARK(ZerocoinSpendCreate, 2);
+BENCHMARK(ZerocoinSpendVerify, 2);
@@ -172,6 +172,47 @@ enum BlockStatus: uint32_t {
     BLOCK_FAILED_MASK        =   BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 
     BLOCK_OPT_WITNESS       =   128, //!< block data in blk*.data was received with a witness-enforcing client
+
+    BLOCK_HAVE_ZEROCOIN     =   256, //!< zerocoin data stored in the block tree database, see CBlockZerocoinData
+};
+
+/**
+ * Zerocoin activity of one block. Most blocks have none, so this is kept out
+ * of CBlockIndex: entries flagged BLOCK_HAVE_ZEROCOIN have their data in the
+ * block tree database, which loads it on demand into an LRU cache.
+ */
+class CBlockZerocoinData
+{
+public:
+    //! Public coin values of mints in this block, ordered by serialized value of public coin
+    //! Maps <denomination,id> to vector of public coins
+    map<pair<int,int>, vector<CBigNum>> mintedPubCoins;
+    //! Accumulator updates. Contains only changes made by mints in this block
+    //! Maps <denomination, id> to <accumulator value (CBigNum), number of such mints in this block>
+    map<pair<int,int>, pair<CBigNum,int>> accumulatorChanges;
+    //! Values of coin serials spent in this block
+    set<CBigNum> spentSerials;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(mintedPubCoins);
+        READWRITE(accumulatorChanges);
+        READWRITE(spentSerials);
+    }
+
+    void SetNull()
+    {
+        mintedPubCoins.clear();
+        accumulatorChanges.clear();
+        spentSerials.clear();
+    }
+
+    bool IsNull() const
+    {
+        return mintedPubCoins.empty() && accumulatorChanges.empty() && spentSerials.empty();
+    }
 };
 
 /** The block chain is a tree shaped structure starting with the
@@ -237,17 +278,6 @@ public:
     //! (memory only) Maximum nTime in the chain up to and including this block.
     unsigned int nTimeMax;
 
-    //! zerocoin specific fields
-    //!
-    //! Public coin values of mints in this block, ordered by serialized value of public coin
-    //! Maps <denomination,id> to vector of public coins
-    map<pair<int,int>, vector<CBigNum>> mintedPubCoins;
-    //! Accumulator updates. Contains only changes made by mints in this block
-    //! Maps <denomination, id> to <accumulator value (CBigNum), number of such mints in this block>
-    map<pair<int,int>, pair<CBigNum,int>> accumulatorChanges;
-    //! Values of coin serials spent in this block
-    set<CBigNum> spentSerials;
-
     void SetNull()
     {
         phashBlock = nullptr;
@@ -274,11 +304,6 @@ public:
         nTime          = 0;
         nBits          = 0;
         nNonce         = 0;
-
-        //Zerocoin params
-        mintedPubCoins.clear();
-        accumulatorChanges.clear();
-        spentSerials.clear();
     }
 
     CBlockIndex()
@@ -443,6 +468,10 @@ class CDiskBlockIndex : public CBlockIndex
 public:
     uint256 hashPrev;
 
+    //! Zerocoin data of records written before it moved out of the block
+    //! index. The fields stay in the record, empty, to keep its layout.
+    CBlockZerocoinData legacyZerocoin;
+
     CDiskBlockIndex() {
         hashPrev = uint256();
     }
@@ -478,9 +507,7 @@ public:
         READWRITE(nNonce);
 
         //Zerocoin params
-        READWRITE(mintedPubCoins);
-        READWRITE(accumulatorChanges);
-        READWRITE(spentSerials);
+        READWRITE(legacyZerocoin);
 
         //POS params
         if(IsProofOfStakeHeightActive(53000)){
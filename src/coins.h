@@ -217,10 +217,6 @@ protected:
 public:
     CCoinsViewCache(CCoinsView *baseIn);
 
-    mutable std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    mutable std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    mutable std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
-
     /**
      * By deleting the copy constructor, we prevent accidentally using it when one intends to create a cache on top of a base cache.
      */
@@ -13,6 +13,21 @@ void neoscrypt_copy(void *dstp, const void *srcp, unsigned int len);
 void neoscrypt_erase(void *dstp, unsigned int len);
 void neoscrypt_xor(void *dstp, const void *srcp, unsigned int len);
 
+void neoscrypt_fastkdf(const unsigned char *password, unsigned int password_len,
+  const unsigned char *salt, unsigned int salt_len, unsigned int N,
+  unsigned char *output, unsigned int output_len);
+
+/* Hashes count 80 byte passwords stored back to back into count 32 byte
+ * outputs. Profile 0 inputs are processed several at a time by the lane
+ * interleaved SIMD implementation selected by neoscrypt_batch_autodetect();
+ * other profiles and any remainder go through neoscrypt() one by one. */
+void neoscrypt_batch(const unsigned char *passwords, unsigned char *outputs,
+  unsigned int count, unsigned int profile);
+
+/* Selects the widest batch implementation the CPU supports and returns its
+ * name. Without this call neoscrypt_batch() uses SSE2 where available. */
+const char *neoscrypt_batch_autodetect(void);
+
 #if defined(ASM) && defined(MINER_4WAY)
 void neoscrypt_4way(const unsigned char *password, unsigned char *output,
   unsigned char *scratchpad);
@@ -0,0 +1,34 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <crypto/neoscrypt_simd.h>
+
+#include <immintrin.h>
+
+namespace neoscrypt_avx2 {
+namespace {
+
+struct AVX2
+{
+    typedef __m256i vec;
+    static const int WAYS = 8;
+    static vec Load(const uint32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void Store(uint32_t* p, vec v) { _mm256_storeu_si256((__m256i*)p, v); }
+    static vec Add(vec a, vec b) { return _mm256_add_epi32(a, b); }
+    static vec Xor(vec a, vec b) { return _mm256_xor_si256(a, b); }
+    template <int n> static vec Rotl(vec v) { return _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - n)); }
+};
+
+} // namespace
+
+void Hash_8way(const unsigned char* passwords, unsigned char* outputs, std::vector<uint32_t>& vScratch)
+{
+    neoscrypt_simd::Engine<AVX2>::Hash(passwords, outputs, vScratch);
+}
+
+} // namespace neoscrypt_avx2
+
+#endif
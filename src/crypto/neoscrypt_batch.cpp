@@ -0,0 +1,117 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/subi-config.h>
+#endif
+
+#include <crypto/neoscrypt.h>
+#include <crypto/neoscrypt_simd.h>
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__amd64__)
+#if defined(ENABLE_AVX2) && !defined(BUILD_SUBI_INTERNAL)
+#include <cpuid.h>
+namespace neoscrypt_avx2
+{
+void Hash_8way(const unsigned char* passwords, unsigned char* outputs, std::vector<uint32_t>& vScratch);
+}
+#endif
+#endif
+
+namespace {
+
+#if defined(__SSE2__)
+struct SSE2
+{
+    typedef __m128i vec;
+    static const int WAYS = 4;
+    static vec Load(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static void Store(uint32_t* p, vec v) { _mm_storeu_si128((__m128i*)p, v); }
+    static vec Add(vec a, vec b) { return _mm_add_epi32(a, b); }
+    static vec Xor(vec a, vec b) { return _mm_xor_si128(a, b); }
+    template <int n> static vec Rotl(vec v) { return _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - n)); }
+};
+
+void Hash_4way_sse2(const unsigned char* passwords, unsigned char* outputs, std::vector<uint32_t>& vScratch)
+{
+    neoscrypt_simd::Engine<SSE2>::Hash(passwords, outputs, vScratch);
+}
+#endif
+
+typedef void (*BatchFn)(const unsigned char* passwords, unsigned char* outputs, std::vector<uint32_t>& vScratch);
+
+#if defined(__SSE2__)
+BatchFn Batch = Hash_4way_sse2;
+unsigned int nBatchWays = 4;
+#else
+BatchFn Batch = nullptr;
+unsigned int nBatchWays = 1;
+#endif
+
+bool SelfTest(BatchFn fn, unsigned int nWays)
+{
+    std::vector<unsigned char> passwords(nWays * neoscrypt_simd::PASSWORD_SIZE), out(nWays * 32);
+    std::vector<uint32_t> vScratch;
+    unsigned char ref[32];
+    for (size_t i = 0; i < passwords.size(); i++)
+        passwords[i] = (unsigned char)(i * 13 + 1);
+    fn(passwords.data(), out.data(), vScratch);
+    for (unsigned int l = 0; l < nWays; l++) {
+        neoscrypt(passwords.data() + l * neoscrypt_simd::PASSWORD_SIZE, ref, 0);
+        if (memcmp(out.data() + l * 32, ref, 32)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void neoscrypt_batch(const unsigned char *passwords, unsigned char *outputs, unsigned int count, unsigned int profile)
+{
+    unsigned int i = 0;
+    if (profile == 0 && Batch && count >= nBatchWays) {
+        std::vector<uint32_t> vScratch;
+        for (; i + nBatchWays <= count; i += nBatchWays)
+            Batch(passwords + i * neoscrypt_simd::PASSWORD_SIZE, outputs + i * neoscrypt_simd::OUTPUT_SIZE, vScratch);
+    }
+    for (; i < count; i++)
+        neoscrypt(passwords + i * neoscrypt_simd::PASSWORD_SIZE, outputs + i * neoscrypt_simd::OUTPUT_SIZE, profile);
+}
+
+const char *neoscrypt_batch_autodetect(void)
+{
+#if defined(__x86_64__) || defined(__amd64__)
+#if defined(ENABLE_AVX2) && !defined(BUILD_SUBI_INTERNAL)
+    uint32_t eax, ebx, ecx, edx;
+    bool fAVX = false;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && ((ecx >> 27) & 1) && ((ecx >> 28) & 1)) {
+        // OSXSAVE and AVX: check that the OS saves the YMM registers
+        uint32_t a, d;
+        __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+        fAVX = (a & 6) == 6;
+    }
+    if (fAVX && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && ((ebx >> 5) & 1)) {
+        assert(SelfTest(neoscrypt_avx2::Hash_8way, 8));
+        Batch = neoscrypt_avx2::Hash_8way;
+        nBatchWays = 8;
+        return "avx2(8way)";
+    }
+#endif
+#endif
+
+#if defined(__SSE2__)
+    assert(SelfTest(Hash_4way_sse2, 4));
+    Batch = Hash_4way_sse2;
+    nBatchWays = 4;
+    return "sse2(4way)";
+#else
+    return "standard";
+#endif
+}
@@ -0,0 +1,180 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// Lane interleaved NeoScrypt core shared by the SSE2 and AVX2 batch
+// implementations. Only the default profile (NeoScrypt(128, 2, 1) with
+// FastKDF-BLAKE2s, Salsa20/20 and ChaCha20/20) is implemented; FastKDF runs
+// per lane through the scalar code since the mixing dominates the cost.
+//
+// A vector traits type T provides:
+//   typedef ... vec;                     // WAYS 32 bit lanes
+//   static const int WAYS;
+//   static vec Load(const uint32_t*);    // unaligned
+//   static void Store(uint32_t*, vec);   // unaligned
+//   static vec Add(vec, vec);
+//   static vec Xor(vec, vec);
+//   template <int n> static vec Rotl(vec);
+
+#ifndef SUBI_CRYPTO_NEOSCRYPT_SIMD_H
+#define SUBI_CRYPTO_NEOSCRYPT_SIMD_H
+
+#include <crypto/neoscrypt.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace neoscrypt_simd {
+
+static const unsigned int N = 128;
+//! 32 bit words per lane in the mixing state (r = 2, four 64 byte blocks)
+static const unsigned int STATE_WORDS = 64;
+static const unsigned int KDF_SIZE = STATE_WORDS * 4;
+static const unsigned int PASSWORD_SIZE = 80;
+static const unsigned int OUTPUT_SIZE = 32;
+
+template <typename T>
+class Engine
+{
+    typedef typename T::vec vec;
+    static const int W = T::WAYS;
+
+    /** Block b of a lane interleaved state. */
+    static uint32_t* Block(uint32_t* s, int b) { return s + 16 * W * b; }
+
+    static void XorBlock(uint32_t* dst, const uint32_t* src)
+    {
+        for (int i = 0; i < 16; i++)
+            T::Store(dst + i * W, T::Xor(T::Load(dst + i * W), T::Load(src + i * W)));
+    }
+
+    static void SwapBlocks(uint32_t* a, uint32_t* b)
+    {
+        uint32_t tmp[16 * W];
+        memcpy(tmp, a, sizeof(tmp));
+        memcpy(a, b, sizeof(tmp));
+        memcpy(b, tmp, sizeof(tmp));
+    }
+
+    static void Salsa(uint32_t* blk)
+    {
+        vec x[16], t;
+        for (int i = 0; i < 16; i++)
+            x[i] = T::Load(blk + i * W);
+
+#define QUARTER(a, b, c, d) \
+        t = T::Add(x[a], x[d]); x[b] = T::Xor(x[b], T::template Rotl<7>(t)); \
+        t = T::Add(x[b], x[a]); x[c] = T::Xor(x[c], T::template Rotl<9>(t)); \
+        t = T::Add(x[c], x[b]); x[d] = T::Xor(x[d], T::template Rotl<13>(t)); \
+        t = T::Add(x[d], x[c]); x[a] = T::Xor(x[a], T::template Rotl<18>(t));
+
+        for (int rounds = 20; rounds; rounds -= 2) {
+            QUARTER( 0,  4,  8, 12);
+            QUARTER( 5,  9, 13,  1);
+            QUARTER(10, 14,  2,  6);
+            QUARTER(15,  3,  7, 11);
+            QUARTER( 0,  1,  2,  3);
+            QUARTER( 5,  6,  7,  4);
+            QUARTER(10, 11,  8,  9);
+            QUARTER(15, 12, 13, 14);
+        }
+#undef QUARTER
+
+        for (int i = 0; i < 16; i++)
+            T::Store(blk + i * W, T::Add(T::Load(blk + i * W), x[i]));
+    }
+
+    static void ChaCha(uint32_t* blk)
+    {
+        vec x[16];
+        for (int i = 0; i < 16; i++)
+            x[i] = T::Load(blk + i * W);
+
+#define QUARTER(a, b, c, d) \
+        x[a] = T::Add(x[a], x[b]); x[d] = T::template Rotl<16>(T::Xor(x[d], x[a])); \
+        x[c] = T::Add(x[c], x[d]); x[b] = T::template Rotl<12>(T::Xor(x[b], x[c])); \
+        x[a] = T::Add(x[a], x[b]); x[d] = T::template Rotl<8>(T::Xor(x[d], x[a])); \
+        x[c] = T::Add(x[c], x[d]); x[b] = T::template Rotl<7>(T::Xor(x[b], x[c]));
+
+        for (int rounds = 20; rounds; rounds -= 2) {
+            QUARTER(0, 4,  8, 12);
+            QUARTER(1, 5,  9, 13);
+            QUARTER(2, 6, 10, 14);
+            QUARTER(3, 7, 11, 15);
+            QUARTER(0, 5, 10, 15);
+            QUARTER(1, 6, 11, 12);
+            QUARTER(2, 7,  8, 13);
+            QUARTER(3, 4,  9, 14);
+        }
+#undef QUARTER
+
+        for (int i = 0; i < 16; i++)
+            T::Store(blk + i * W, T::Add(T::Load(blk + i * W), x[i]));
+    }
+
+    /** neoscrypt_blkmix() for r = 2 */
+    static void BlkMix(uint32_t* s, bool fChaCha)
+    {
+        for (int b = 0; b < 4; b++) {
+            XorBlock(Block(s, b), Block(s, (b + 3) % 4));
+            if (fChaCha)
+                ChaCha(Block(s, b));
+            else
+                Salsa(Block(s, b));
+        }
+        SwapBlocks(Block(s, 1), Block(s, 2));
+    }
+
+    static void SMix(uint32_t* s, uint32_t* v, bool fChaCha)
+    {
+        const size_t nBlockWords = STATE_WORDS * W;
+        for (unsigned int i = 0; i < N; i++) {
+            memcpy(v + i * nBlockWords, s, nBlockWords * sizeof(uint32_t));
+            BlkMix(s, fChaCha);
+        }
+        for (unsigned int i = 0; i < N; i++) {
+            // integerify() picks a different V entry for every lane
+            for (int l = 0; l < W; l++) {
+                const uint32_t* vj = v + (s[48 * W + l] & (N - 1)) * nBlockWords;
+                for (unsigned int w = 0; w < STATE_WORDS; w++)
+                    s[w * W + l] ^= vj[w * W + l];
+            }
+            BlkMix(s, fChaCha);
+        }
+    }
+
+public:
+    static const int WAYS = T::WAYS;
+
+    /** Hash WAYS 80 byte passwords into WAYS 32 byte outputs. */
+    static void Hash(const unsigned char* passwords, unsigned char* outputs, std::vector<uint32_t>& vScratch)
+    {
+        uint32_t kdf[W][STATE_WORDS];
+        uint32_t x[STATE_WORDS * W], z[STATE_WORDS * W];
+        vScratch.resize(N * STATE_WORDS * W);
+
+        for (int l = 0; l < W; l++) {
+            const unsigned char* password = passwords + l * PASSWORD_SIZE;
+            neoscrypt_fastkdf(password, PASSWORD_SIZE, password, PASSWORD_SIZE, 32, (unsigned char*)kdf[l], KDF_SIZE);
+            for (unsigned int w = 0; w < STATE_WORDS; w++)
+                x[w * W + l] = kdf[l][w];
+        }
+
+        // ChaCha first, Salsa second, and XOR them together
+        memcpy(z, x, sizeof(x));
+        SMix(z, vScratch.data(), true);
+        SMix(x, vScratch.data(), false);
+
+        for (int l = 0; l < W; l++) {
+            for (unsigned int w = 0; w < STATE_WORDS; w++)
+                kdf[l][w] = x[w * W + l] ^ z[w * W + l];
+            const unsigned char* password = passwords + l * PASSWORD_SIZE;
+            neoscrypt_fastkdf(password, PASSWORD_SIZE, (unsigned char*)kdf[l], KDF_SIZE, 32, outputs + l * OUTPUT_SIZE, OUTPUT_SIZE);
+        }
+    }
+};
+
+} // namespace neoscrypt_simd
+
+#endif // SUBI_CRYPTO_NEOSCRYPT_SIMD_H
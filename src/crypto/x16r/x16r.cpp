@@ -0,0 +1,194 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/x16r/x16r.h>
+#include <crypto/common.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__amd64__)
+#if defined(ENABLE_AVX2) && !defined(BUILD_SUBI_INTERNAL)
+#include <cpuid.h>
+namespace x16r_avx2
+{
+void Blake512_4way(const unsigned char* in, size_t len, unsigned char* out);
+void Keccak512_4way(const unsigned char* in, size_t len, unsigned char* out);
+}
+#endif
+#endif
+
+namespace {
+
+typedef void (*InitFn)(void*);
+typedef void (*UpdateFn)(void*, const void*, size_t);
+typedef void (*CloseFn)(void*, void*);
+
+struct Algo
+{
+    const char* name;
+    InitFn init;
+    UpdateFn update;
+    CloseFn close;
+};
+
+const Algo ALGOS[X16R_ROUNDS] = {
+    {"blake",     sph_blake512_init,    sph_blake512,    sph_blake512_close},
+    {"bmw",       sph_bmw512_init,      sph_bmw512,      sph_bmw512_close},
+    {"groestl",   sph_groestl512_init,  sph_groestl512,  sph_groestl512_close},
+    {"jh",        sph_jh512_init,       sph_jh512,       sph_jh512_close},
+    {"keccak",    sph_keccak512_init,   sph_keccak512,   sph_keccak512_close},
+    {"skein",     sph_skein512_init,    sph_skein512,    sph_skein512_close},
+    {"luffa",     sph_luffa512_init,    sph_luffa512,    sph_luffa512_close},
+    {"cubehash",  sph_cubehash512_init, sph_cubehash512, sph_cubehash512_close},
+    {"shavite",   sph_shavite512_init,  sph_shavite512,  sph_shavite512_close},
+    {"simd",      sph_simd512_init,     sph_simd512,     sph_simd512_close},
+    {"echo",      sph_echo512_init,     sph_echo512,     sph_echo512_close},
+    {"hamsi",     sph_hamsi512_init,    sph_hamsi512,    sph_hamsi512_close},
+    {"fugue",     sph_fugue512_init,    sph_fugue512,    sph_fugue512_close},
+    {"shabal",    sph_shabal512_init,   sph_shabal512,   sph_shabal512_close},
+    {"whirlpool", sph_whirlpool_init,   sph_whirlpool,   sph_whirlpool_close},
+    {"sha512",    sph_sha512_init,      sph_sha512,      sph_sha512_close},
+};
+
+/** Hashes four equally sized messages stored back to back into four 64 byte digests. */
+typedef void (*Hash4WayFn)(const unsigned char* in, size_t len, unsigned char* out);
+
+//! Multi-way kernels per algorithm, filled in by X16RAutoDetect
+Hash4WayFn Hash4Way[X16R_ROUNDS] = {};
+
+/** Number of messages hashed together by the multi-way kernels. */
+const size_t WAYS = 4;
+
+bool SelfTest(int nAlgo, Hash4WayFn fn)
+{
+    unsigned char msg[WAYS * 200], out[WAYS * 64], ref[64];
+    for (size_t len : {size_t{64}, size_t{80}, size_t{200}}) {
+        for (size_t i = 0; i < WAYS * len; i++)
+            msg[i] = (unsigned char)(i * 7 + nAlgo);
+        fn(msg, len, out);
+        for (size_t l = 0; l < WAYS; l++) {
+            X16RHashAlgo(nAlgo, msg + l * len, len, ref);
+            if (memcmp(out + 64 * l, ref, 64)) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+const char* X16RAlgoName(int nAlgo)
+{
+    return ALGOS[nAlgo].name;
+}
+
+void X16RHashAlgo(int nAlgo, const unsigned char* data, size_t len, unsigned char out[64])
+{
+    X16RContext ctx;
+    const Algo& algo = ALGOS[nAlgo];
+    algo.init(&ctx);
+    algo.update(&ctx, data, len);
+    algo.close(&ctx, out);
+}
+
+CX16R::CX16R(const unsigned char* prevHash) : fPrefixSet(false)
+{
+    // Round i uses nibble 48 + i of the previous block hash, counted from the
+    // most significant end of the little endian uint256 (see GetNibble).
+    for (int i = 0; i < X16R_ROUNDS; i++) {
+        int index = 15 - i;
+        schedule[i] = (index % 2 == 1) ? (prevHash[index / 2] >> 4) : (prevHash[index / 2] & 0x0F);
+    }
+}
+
+void CX16R::Hash(const unsigned char* data, size_t len, unsigned char hash[OUTPUT_SIZE]) const
+{
+    static const unsigned char blank[1] = {0};
+    unsigned char buf[2][64];
+    X16RHashAlgo(schedule[0], len ? data : blank, len, buf[0]);
+    for (int i = 1; i < X16R_ROUNDS; i++)
+        X16RHashAlgo(schedule[i], buf[(i - 1) & 1], 64, buf[i & 1]);
+    memcpy(hash, buf[(X16R_ROUNDS - 1) & 1], OUTPUT_SIZE);
+}
+
+CX16R& CX16R::SetHeaderPrefix(const unsigned char prefixIn[X16R_HEADER_PREFIX_SIZE])
+{
+    memcpy(prefix, prefixIn, X16R_HEADER_PREFIX_SIZE);
+    const Algo& algo = ALGOS[schedule[0]];
+    algo.init(&midstate);
+    algo.update(&midstate, prefix, X16R_HEADER_PREFIX_SIZE);
+    fPrefixSet = true;
+    return *this;
+}
+
+void CX16R::HashNonces(const uint32_t* nonces, size_t count, unsigned char* out) const
+{
+    assert(fPrefixSet);
+    unsigned char buf[2][WAYS * 80];
+    X16RContext ctx;
+
+    for (size_t n = 0; n < count; n += WAYS) {
+        const size_t lanes = std::min(WAYS, count - n);
+        unsigned char* cur = buf[0];
+        unsigned char* next = buf[1];
+
+        // First round: either the full 80 byte headers through a multi-way
+        // kernel, or the cached prefix state plus the 4 nonce bytes.
+        const Algo& first = ALGOS[schedule[0]];
+        if (lanes == WAYS && Hash4Way[schedule[0]]) {
+            for (size_t l = 0; l < WAYS; l++) {
+                memcpy(next + 80 * l, prefix, X16R_HEADER_PREFIX_SIZE);
+                WriteLE32(next + 80 * l + X16R_HEADER_PREFIX_SIZE, nonces[n + l]);
+            }
+            Hash4Way[schedule[0]](next, 80, cur);
+        } else {
+            for (size_t l = 0; l < lanes; l++) {
+                unsigned char nonce[4];
+                WriteLE32(nonce, nonces[n + l]);
+                memcpy(&ctx, &midstate, sizeof(ctx));
+                first.update(&ctx, nonce, sizeof(nonce));
+                first.close(&ctx, cur + 64 * l);
+            }
+        }
+
+        for (int i = 1; i < X16R_ROUNDS; i++) {
+            if (lanes == WAYS && Hash4Way[schedule[i]]) {
+                Hash4Way[schedule[i]](cur, 64, next);
+            } else {
+                for (size_t l = 0; l < lanes; l++)
+                    X16RHashAlgo(schedule[i], cur + 64 * l, 64, next + 64 * l);
+            }
+            std::swap(cur, next);
+        }
+
+        for (size_t l = 0; l < lanes; l++)
+            memcpy(out + (n + l) * OUTPUT_SIZE, cur + 64 * l, OUTPUT_SIZE);
+    }
+}
+
+std::string X16RAutoDetect()
+{
+#if defined(__x86_64__) || defined(__amd64__)
+#if defined(ENABLE_AVX2) && !defined(BUILD_SUBI_INTERNAL)
+    uint32_t eax, ebx, ecx, edx;
+    bool fAVX = false;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && ((ecx >> 27) & 1) && ((ecx >> 28) & 1)) {
+        // OSXSAVE and AVX: check that the OS saves the YMM registers
+        uint32_t a, d;
+        __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+        fAVX = (a & 6) == 6;
+    }
+    if (fAVX && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && ((ebx >> 5) & 1)) {
+        Hash4Way[0] = x16r_avx2::Blake512_4way;
+        Hash4Way[4] = x16r_avx2::Keccak512_4way;
+        assert(SelfTest(0, Hash4Way[0]));
+        assert(SelfTest(4, Hash4Way[4]));
+        return "avx2(4way blake,keccak)";
+    }
+#endif
+#endif
+
+    return "standard";
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef SUBI_CRYPTO_X16R_X16R_H
+#define SUBI_CRYPTO_X16R_X16R_H
+
+#include <crypto/x16r/sph_blake.h>
+#include <crypto/x16r/sph_bmw.h>
+#include <crypto/x16r/sph_groestl.h>
+#include <crypto/x16r/sph_jh.h>
+#include <crypto/x16r/sph_keccak.h>
+#include <crypto/x16r/sph_skein.h>
+#include <crypto/x16r/sph_luffa.h>
+#include <crypto/x16r/sph_cubehash.h>
+#include <crypto/x16r/sph_shavite.h>
+#include <crypto/x16r/sph_simd.h>
+#include <crypto/x16r/sph_echo.h>
+#include <crypto/x16r/sph_hamsi.h>
+#include <crypto/x16r/sph_fugue.h>
+#include <crypto/x16r/sph_shabal.h>
+#include <crypto/x16r/sph_whirlpool.h>
+#include <crypto/x16r/sph_sha2.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+/** Number of chained hash rounds, and of algorithms a round can select. */
+static const int X16R_ROUNDS = 16;
+/** Size of the serialized block header that precedes nNonce. */
+static const size_t X16R_HEADER_PREFIX_SIZE = 76;
+
+/** State of any of the 16 X16R algorithms. */
+union X16RContext
+{
+    sph_blake512_context blake;
+    sph_bmw512_context bmw;
+    sph_groestl512_context groestl;
+    sph_jh512_context jh;
+    sph_keccak512_context keccak;
+    sph_skein512_context skein;
+    sph_luffa512_context luffa;
+    sph_cubehash512_context cubehash;
+    sph_shavite512_context shavite;
+    sph_simd512_context simd;
+    sph_echo512_context echo;
+    sph_hamsi512_context hamsi;
+    sph_fugue512_context fugue;
+    sph_shabal512_context shabal;
+    sph_whirlpool_context whirlpool;
+    sph_sha512_context sha512;
+};
+
+/** Name of X16R algorithm nAlgo (0-15). */
+const char* X16RAlgoName(int nAlgo);
+
+/** Hash a message with the single X16R algorithm nAlgo into a 64 byte digest. */
+void X16RHashAlgo(int nAlgo, const unsigned char* data, size_t len, unsigned char out[64]);
+
+/**
+ * X16R hasher for one previous block hash. The algorithm order is derived
+ * from the previous block hash once at construction and reused for every
+ * message, so miners and validators can hash many headers on the same parent
+ * without redoing the per-round dispatch setup.
+ */
+class CX16R
+{
+private:
+    int schedule[X16R_ROUNDS];
+    //! State of the first round after absorbing the header prefix
+    X16RContext midstate;
+    unsigned char prefix[X16R_HEADER_PREFIX_SIZE];
+    bool fPrefixSet;
+
+public:
+    static const size_t OUTPUT_SIZE = 32;
+
+    /** prevHash is the 32 byte previous block hash in uint256 byte order. */
+    explicit CX16R(const unsigned char* prevHash);
+
+    int GetAlgo(int nRound) const { return schedule[nRound]; }
+
+    /** Hash an arbitrary message. */
+    void Hash(const unsigned char* data, size_t len, unsigned char hash[OUTPUT_SIZE]) const;
+
+    /** Set the serialized header fields before nNonce used by HashNonces. */
+    CX16R& SetHeaderPrefix(const unsigned char prefixIn[X16R_HEADER_PREFIX_SIZE]);
+
+    /**
+     * Hash the header prefix followed by each of the count nonces, writing
+     * count * OUTPUT_SIZE bytes to out. Requires SetHeaderPrefix.
+     */
+    void HashNonces(const uint32_t* nonces, size_t count, unsigned char* out) const;
+};
+
+/** Autodetect the best available multi-way kernels for X16R.
+ *  Returns the name of the implementation.
+ */
+std::string X16RAutoDetect();
+
+#endif // SUBI_CRYPTO_X16R_X16R_H
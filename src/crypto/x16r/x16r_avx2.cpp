@@ -0,0 +1,271 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// 4-way AVX2 implementations of the BLAKE-512 and Keccak-512 kernels used by
+// X16R. Each call hashes four equally sized messages stored back to back and
+// produces four 64 byte digests identical to the sph_blake512/sph_keccak512
+// reference code.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include <crypto/common.h>
+
+namespace x16r_avx2 {
+namespace {
+
+/** Gather word w of each of the four lanes into one vector. */
+inline __m256i Load4(const uint64_t w[4])
+{
+    return _mm256_set_epi64x(w[3], w[2], w[1], w[0]);
+}
+
+inline void Store4(__m256i v, uint64_t w[4])
+{
+    _mm256_storeu_si256((__m256i*)w, v);
+}
+
+template <int n>
+inline __m256i Rotr(__m256i x)
+{
+    return _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - n));
+}
+
+template <int n>
+inline __m256i Rotl(__m256i x)
+{
+    return _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - n));
+}
+
+/** BLAKE-512 */
+namespace blake {
+
+const uint64_t IV[8] = {
+    0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL, 0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL,
+    0x510E527FADE682D1ULL, 0x9B05688C2B3E6C1FULL, 0x1F83D9ABFB41BD6BULL, 0x5BE0CD19137E2179ULL
+};
+
+const uint64_t CB[16] = {
+    0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL,
+    0x452821E638D01377ULL, 0xBE5466CF34E90C6CULL, 0xC0AC29B7C97C50DDULL, 0x3F84D5B5B5470917ULL,
+    0x9216D5D98979FB1BULL, 0xD1310BA698DFB5ACULL, 0x2FFD72DBD01ADFB7ULL, 0xB8E1AFED6A267E96ULL,
+    0xBA7C9045F12C7F99ULL, 0x24A19947B3916CF7ULL, 0x0801F2E2858EFC16ULL, 0x636920D871574E69ULL
+};
+
+const uint8_t SIGMA[10][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+    { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+    { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+    {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+    { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 }
+};
+
+inline void G(__m256i* v, const __m256i* m, const uint8_t* s, int i, int a, int b, int c, int d)
+{
+    int x = s[2 * i], y = s[2 * i + 1];
+    v[a] = _mm256_add_epi64(_mm256_add_epi64(v[a], v[b]), _mm256_xor_si256(m[x], _mm256_set1_epi64x(CB[y])));
+    v[d] = _mm256_shuffle_epi32(_mm256_xor_si256(v[d], v[a]), 0xB1);
+    v[c] = _mm256_add_epi64(v[c], v[d]);
+    v[b] = Rotr<25>(_mm256_xor_si256(v[b], v[c]));
+    v[a] = _mm256_add_epi64(_mm256_add_epi64(v[a], v[b]), _mm256_xor_si256(m[y], _mm256_set1_epi64x(CB[x])));
+    v[d] = Rotr<16>(_mm256_xor_si256(v[d], v[a]));
+    v[c] = _mm256_add_epi64(v[c], v[d]);
+    v[b] = Rotr<11>(_mm256_xor_si256(v[b], v[c]));
+}
+
+/** Compress one 128 byte block per lane; blocks[l] points to lane l's block. */
+void Compress(__m256i* h, const unsigned char* const blocks[4], uint64_t counter)
+{
+    __m256i m[16], v[16];
+    for (int i = 0; i < 16; i++) {
+        uint64_t w[4];
+        for (int l = 0; l < 4; l++)
+            w[l] = ReadBE64(blocks[l] + 8 * i);
+        m[i] = Load4(w);
+    }
+    for (int i = 0; i < 8; i++)
+        v[i] = h[i];
+    for (int i = 0; i < 4; i++)
+        v[8 + i] = _mm256_set1_epi64x(CB[i]);
+    v[12] = _mm256_set1_epi64x(counter ^ CB[4]);
+    v[13] = _mm256_set1_epi64x(counter ^ CB[5]);
+    v[14] = _mm256_set1_epi64x(CB[6]);
+    v[15] = _mm256_set1_epi64x(CB[7]);
+    for (int r = 0; r < 16; r++) {
+        const uint8_t* s = SIGMA[r % 10];
+        G(v, m, s, 0, 0, 4,  8, 12);
+        G(v, m, s, 1, 1, 5,  9, 13);
+        G(v, m, s, 2, 2, 6, 10, 14);
+        G(v, m, s, 3, 3, 7, 11, 15);
+        G(v, m, s, 4, 0, 5, 10, 15);
+        G(v, m, s, 5, 1, 6, 11, 12);
+        G(v, m, s, 6, 2, 7,  8, 13);
+        G(v, m, s, 7, 3, 4,  9, 14);
+    }
+    for (int i = 0; i < 8; i++)
+        h[i] = _mm256_xor_si256(h[i], _mm256_xor_si256(v[i], v[i + 8]));
+}
+
+} // namespace blake
+
+/** Keccak-512 (original Keccak padding, as in sph_keccak512) */
+namespace keccak {
+
+const size_t RATE = 72;
+
+const uint64_t RC[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+void Permute(__m256i* a)
+{
+    __m256i b[5], c[5], t;
+    for (int round = 0; round < 24; round++) {
+        // Theta
+        for (int x = 0; x < 5; x++)
+            c[x] = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[x], a[x + 5]), _mm256_xor_si256(a[x + 10], a[x + 15])), a[x + 20]);
+        for (int x = 0; x < 5; x++) {
+            t = _mm256_xor_si256(c[(x + 4) % 5], Rotl<1>(c[(x + 1) % 5]));
+            for (int y = 0; y < 25; y += 5)
+                a[y + x] = _mm256_xor_si256(a[y + x], t);
+        }
+
+        // Rho and pi, walking the lanes along the pi permutation cycle
+        t = a[1];
+#define RHOPI(j, r) do { b[0] = a[j]; a[j] = Rotl<r>(t); t = b[0]; } while (0)
+        RHOPI(10,  1); RHOPI( 7,  3); RHOPI(11,  6); RHOPI(17, 10);
+        RHOPI(18, 15); RHOPI( 3, 21); RHOPI( 5, 28); RHOPI(16, 36);
+        RHOPI( 8, 45); RHOPI(21, 55); RHOPI(24,  2); RHOPI( 4, 14);
+        RHOPI(15, 27); RHOPI(23, 41); RHOPI(19, 56); RHOPI(13,  8);
+        RHOPI(12, 25); RHOPI( 2, 43); RHOPI(20, 62); RHOPI(14, 18);
+        RHOPI(22, 39); RHOPI( 9, 61); RHOPI( 6, 20); RHOPI( 1, 44);
+#undef RHOPI
+
+        // Chi
+        for (int y = 0; y < 25; y += 5) {
+            for (int x = 0; x < 5; x++)
+                b[x] = a[y + x];
+            for (int x = 0; x < 5; x++)
+                a[y + x] = _mm256_xor_si256(b[x], _mm256_andnot_si256(b[(x + 1) % 5], b[(x + 2) % 5]));
+        }
+
+        // Iota
+        a[0] = _mm256_xor_si256(a[0], _mm256_set1_epi64x(RC[round]));
+    }
+}
+
+void Absorb(__m256i* a, const unsigned char* const blocks[4])
+{
+    for (size_t i = 0; i < RATE / 8; i++) {
+        uint64_t w[4];
+        for (int l = 0; l < 4; l++)
+            w[l] = ReadLE64(blocks[l] + 8 * i);
+        a[i] = _mm256_xor_si256(a[i], Load4(w));
+    }
+    Permute(a);
+}
+
+} // namespace keccak
+
+} // namespace
+
+void Blake512_4way(const unsigned char* in, size_t len, unsigned char* out)
+{
+    __m256i h[8];
+    for (int i = 0; i < 8; i++)
+        h[i] = _mm256_set1_epi64x(blake::IV[i]);
+
+    const unsigned char* blocks[4];
+    uint64_t counter = 0;
+    size_t pos = 0;
+    for (; pos + 128 <= len; pos += 128) {
+        for (int l = 0; l < 4; l++)
+            blocks[l] = in + l * len + pos;
+        counter += 1024;
+        blake::Compress(h, blocks, counter);
+    }
+
+    size_t rem = len - pos;
+    uint64_t bits = (uint64_t)len << 3;
+    unsigned char pad[4][256];
+    for (int l = 0; l < 4; l++) {
+        memset(pad[l], 0, sizeof(pad[l]));
+        memcpy(pad[l], in + l * len + pos, rem);
+        pad[l][rem] = 0x80;
+        blocks[l] = pad[l];
+    }
+    if (rem <= 111) {
+        for (int l = 0; l < 4; l++) {
+            pad[l][111] |= 1;
+            WriteBE64(pad[l] + 120, bits);
+        }
+        blake::Compress(h, blocks, rem == 0 ? 0 : bits);
+    } else {
+        for (int l = 0; l < 4; l++) {
+            pad[l][128 + 111] = 1;
+            WriteBE64(pad[l] + 128 + 120, bits);
+        }
+        blake::Compress(h, blocks, bits);
+        for (int l = 0; l < 4; l++)
+            blocks[l] = pad[l] + 128;
+        blake::Compress(h, blocks, 0);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        uint64_t w[4];
+        Store4(h[i], w);
+        for (int l = 0; l < 4; l++)
+            WriteBE64(out + 64 * l + 8 * i, w[l]);
+    }
+}
+
+void Keccak512_4way(const unsigned char* in, size_t len, unsigned char* out)
+{
+    __m256i a[25];
+    for (int i = 0; i < 25; i++)
+        a[i] = _mm256_setzero_si256();
+
+    const unsigned char* blocks[4];
+    size_t pos = 0;
+    for (; pos + keccak::RATE <= len; pos += keccak::RATE) {
+        for (int l = 0; l < 4; l++)
+            blocks[l] = in + l * len + pos;
+        keccak::Absorb(a, blocks);
+    }
+
+    size_t rem = len - pos;
+    unsigned char pad[4][keccak::RATE];
+    for (int l = 0; l < 4; l++) {
+        memset(pad[l], 0, sizeof(pad[l]));
+        memcpy(pad[l], in + l * len + pos, rem);
+        pad[l][rem] = 0x01;
+        pad[l][keccak::RATE - 1] |= 0x80;
+        blocks[l] = pad[l];
+    }
+    keccak::Absorb(a, blocks);
+
+    for (int i = 0; i < 8; i++) {
+        uint64_t w[4];
+        Store4(a[i], w);
+        for (int l = 0; l < 4; l++)
+            WriteLE64(out + 64 * l + 8 * i, w[l]);
+    }
+}
+
+} // namespace x16r_avx2
+
+#endif // ENABLE_AVX2
@@ -17,9 +17,11 @@
 #include <checkpoints.h>
 #include <compat/sanity.h>
 #include <consensus/validation.h>
+#include <crypto/neoscrypt.h>
 #include <fs.h>
 #include <httpserver.h>
 #include <httprpc.h>
+#include <insightindexer.h>
 #include <key.h>
 #include <validation.h>
 #include <miner.h>
@@ -47,6 +49,7 @@
 #ifdef ENABLE_WALLET
 #include <wallet/init.h>
 #endif
+#include <pos/kernel.h>
 #include <pos/miner.h>
 #include <warnings.h>
 #include <stdint.h>
@@ -80,6 +83,7 @@
 #include "subinode/activesubinode.h"
 #include "subinode/darksend.h"
 #include "subinode/subinode-payments.h"
+#include "subinode/subinode-sigqueue.h"
 #include "subinode/subinode-sync.h"
 #include "subinode/subinodeman.h"
 #include "subinode/subinodeconfig.h"
@@ -87,6 +91,7 @@
 #include "subinode/instantx.h"
 #include "subinode/spork.h"
 #include "subinode/flat-database.h"
+#include "zerocoin/zerocoin.h"
 
 #if ENABLE_ZMQ
 #include <zmq/zmqnotificationinterface.h>
@@ -502,6 +507,9 @@ std::string HelpMessage(HelpMessageMode mode)
     if (showDebug) {
         strUsage += HelpMessageOpt("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex()));
     }
+    strUsage += HelpMessageOpt("-powhashcache", strprintf(_("Cache proof-of-work hashes of the block index so they are not recomputed at startup (default: %u)"), DEFAULT_POWHASH_CACHE));
+    strUsage += HelpMessageOpt("-zerocoindatacache=<n>", strprintf(_("Number of blocks whose zerocoin data is kept in memory (default: %u)"), DEFAULT_ZEROCOIN_DATA_CACHE));
+    strUsage += HelpMessageOpt("-zerocoinrebuild", strprintf(_("Rebuild the zerocoin state from the whole chain instead of resuming from the stored state (default: %u)"), DEFAULT_ZEROCOIN_REBUILD));
     strUsage += HelpMessageOpt("-persistmempool", strprintf(_("Whether to save the mempool on shutdown and load on restart (default: %u)"), DEFAULT_PERSIST_MEMPOOL));
     strUsage += HelpMessageOpt("-blockreconstructionextratxn=<n>", strprintf(_("Extra transactions to keep in memory for compact block reconstructions (default: %u)"), DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
@@ -1057,6 +1065,10 @@ bool AppInitParameterInteraction()
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        // the insight indexer rebuilds index entries from the block and undo files
+        if (gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) || gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
+            gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX))
+            return InitError(_("Prune mode is incompatible with -addressindex, -spentindex and -timestampindex."));
     }
 
     // -bind and -whitebind can't be set when not listening
@@ -1323,6 +1335,9 @@ bool AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string x16r_algo = X16RAutoDetect();
+    LogPrintf("Using the '%s' X16R implementation\n", x16r_algo);
+    LogPrintf("Using the '%s' neoscrypt batch implementation\n", neoscrypt_batch_autodetect());
     RandomInit();
     ECC_Start();
     ECC_Start_Stealth();
@@ -1387,11 +1402,14 @@ bool AppInitMain()
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    darkSendSigner.InitSignatureCache();
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
         for (int i=0; i<nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadZerocoinSpendCheck);
     }
 
     // Start the lightweight task scheduler thread
@@ -1838,6 +1856,13 @@ bool AppInitMain()
         vImportFiles.push_back(strFile);
     }
 
+    // Index writing follows the chain on its own thread, catching up from where it stopped
+    if (fAddressIndex || fSpentIndex || fTimestampIndex) {
+        if (!insightIndexer.Start())
+            return InitError(_("Error loading the address, spent and timestamp indexes"));
+        threadGroup.create_thread(&ThreadInsightIndex);
+    }
+
     threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles));
 
     // Wait for genesis block to be processed
@@ -2022,6 +2047,10 @@ bool AppInitMain()
     // ********************************************************* Step 11d: start subinode thread
 
     threadGroup.create_thread(boost::bind(&ThreadCheckDarkSendPool));
+    if (nScriptCheckThreads) {
+        for (int i=0; i<std::min(nScriptCheckThreads-1, MAX_SUBINODE_SIG_THREADS); i++)
+            threadGroup.create_thread(&ThreadSubinodeSigCheck);
+    }
 
 
     // ********************************************************* Step 11e: start staking
@@ -2039,6 +2068,10 @@ bool AppInitMain()
             assert(nWallets > 0);
             size_t nThreads = std::min(nWallets, (size_t)gArgs.GetArg("-stakingthreads", 1));
 
+            // kernel searches of large wallets share these, like block validation shares the script check threads
+            for (int i = 0; i < nScriptCheckThreads - 1; i++)
+                threadGroup.create_thread(&ThreadKernelSearch);
+
             size_t nPerThread = nWallets / nThreads;
             for (size_t i = 0; i < nThreads; ++i)
             {
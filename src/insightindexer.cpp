@@ -0,0 +1,270 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "insightindexer.h"
+
+#include "addressindex.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "spentindex.h"
+#include "txdb.h"
+#include "undo.h"
+#include "util.h"
+#include "utiltime.h"
+#include "validation.h"
+
+#include <algorithm>
+
+CInsightIndexer insightIndexer;
+
+/**
+ * Index entries of a block, built from its transactions and the coins they spent. The unspent
+ * index entries are in the order connecting the block applies them in, reversed to disconnect it.
+ */
+static bool GetBlockIndexEntries(const CBlock& block, const CBlockUndo& blockundo, int nHeight, bool fDisconnect,
+                                 std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& addressUnspentIndex,
+                                 std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& spentIndex)
+{
+    // every transaction but the coinbase has an undo entry, in block order
+    size_t nUndo = 0;
+    for (unsigned int i = 0; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256 txHash = tx.GetHash();
+
+        if (!tx.IsCoinBase()) {
+            if (nUndo >= blockundo.vtxundo.size())
+                return error("%s: block and undo data inconsistent", __func__);
+            const CTxUndo& txundo = blockundo.vtxundo[nUndo++];
+
+            if (!tx.IsZerocoinSpend()) {
+                if (txundo.vprevout.size() != tx.vin.size())
+                    return error("%s: transaction and undo data inconsistent", __func__);
+
+                for (unsigned int j = 0; j < tx.vin.size(); j++) {
+                    const COutPoint& prevout = tx.vin[j].prevout;
+                    const Coin& coin = txundo.vprevout[j];
+
+                    std::vector<uint8_t> hashBytes;
+                    int scriptType = 0;
+                    if (!ExtractIndexInfo(&coin.out.scriptPubKey, scriptType, hashBytes) || scriptType == 0)
+                        continue;
+                    uint256 hashAddress(hashBytes.data(), hashBytes.size());
+
+                    if (fAddressIndex) {
+                        // spending activity, and the spent output leaving the unspent index
+                        addressIndex.push_back(std::make_pair(CAddressIndexKey(scriptType, hashAddress, nHeight, i, txHash, j, true), coin.out.nValue * -1));
+                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(scriptType, hashAddress, prevout.hash, prevout.n),
+                            fDisconnect ? CAddressUnspentValue(coin.out.nValue, coin.out.scriptPubKey, coin.nHeight) : CAddressUnspentValue()));
+                    }
+
+                    if (fSpentIndex) {
+                        // the txid and input that spent an output, with the amount and address of the input
+                        spentIndex.push_back(std::make_pair(CSpentIndexKey(prevout.hash, prevout.n),
+                            fDisconnect ? CSpentIndexValue() : CSpentIndexValue(txHash, j, nHeight, coin.out.nValue, scriptType, hashAddress)));
+                    }
+                }
+            }
+        }
+
+        if (fAddressIndex) {
+            for (unsigned int k = 0; k < tx.vout.size(); k++) {
+                const CTxOut& out = tx.vout[k];
+
+                std::vector<uint8_t> hashBytes;
+                int scriptType = 0;
+                if (!ExtractIndexInfo(&out.scriptPubKey, scriptType, hashBytes) || scriptType == 0)
+                    continue;
+                uint256 hashAddress(hashBytes.data(), hashBytes.size());
+
+                // receiving activity and the new unspent output
+                addressIndex.push_back(std::make_pair(CAddressIndexKey(scriptType, hashAddress, nHeight, i, txHash, k, false), out.nValue));
+                addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(scriptType, hashAddress, txHash, k),
+                    fDisconnect ? CAddressUnspentValue() : CAddressUnspentValue(out.nValue, out.scriptPubKey, nHeight)));
+            }
+        }
+    }
+
+    // an output spent within the block must end up erased either way
+    if (fDisconnect)
+        std::reverse(addressUnspentIndex.begin(), addressUnspentIndex.end());
+
+    return true;
+}
+
+bool CInsightIndexer::IndexBlock(const CBlockIndex* pindex, bool fDisconnect)
+{
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+
+    // like ConnectBlock, skip the genesis block, its coinbase is not spendable
+    if (pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
+            return error("%s: failed to read block %s", __func__, pindex->GetBlockHash().ToString());
+        CBlockUndo blockundo;
+        if (!UndoReadFromDisk(blockundo, pindex))
+            return error("%s: failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+        if (!GetBlockIndexEntries(block, blockundo, pindex->nHeight, fDisconnect, addressIndex, addressUnspentIndex, spentIndex))
+            return error("%s: failed to index block %s", __func__, pindex->GetBlockHash().ToString());
+
+        // the timestamp index is only ever added to, as it was by ConnectBlock
+        if (fTimestampIndex && !fDisconnect) {
+            if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())) ||
+                !pblocktree->WriteTimestampBlockIndex(CTimestampBlockIndexKey(pindex->GetBlockHash()), CTimestampBlockIndexValue(pindex->nTime)))
+                return error("%s: failed to write timestamp index", __func__);
+        }
+    }
+
+    if (!pblocktree->WriteInsightIndexes(addressIndex, addressUnspentIndex, spentIndex, fDisconnect))
+        return error("%s: failed to write indexes of block %s", __func__, pindex->GetBlockHash().ToString());
+
+    pindexBest = fDisconnect ? pindex->pprev : pindex;
+    nBestHeight = fDisconnect ? pindex->nHeight - 1 : pindex->nHeight;
+    return true;
+}
+
+void CInsightIndexer::BlockConnected(const std::shared_ptr<const CBlock> &block, const CBlockIndex *pindex, const std::vector<CTransactionRef> &txnConflicted)
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fNotified = true;
+    }
+    condSync.notify_one();
+}
+
+void CInsightIndexer::BlockDisconnected(const std::shared_ptr<const CBlock> &block)
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fNotified = true;
+    }
+    condSync.notify_one();
+}
+
+void CInsightIndexer::SetBestChain(const CBlockLocator &locator)
+{
+    // The block index was just written up to the flushed tip, blocks the indexer got to
+    // since may not be on disk yet and are replayed from the flushed tip after a crash
+    CBlockLocator locatorBest;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = pindexBest;
+        if (!pindex || locator.IsNull())
+            return;
+        BlockMap::iterator mi = mapBlockIndex.find(locator.vHave[0]);
+        if (mi != mapBlockIndex.end() && pindex->GetAncestor(mi->second->nHeight) == mi->second)
+            pindex = mi->second;
+        locatorBest = chainActive.GetLocator(pindex);
+    }
+    if (!pblocktree->WriteInsightIndexBest(locatorBest))
+        LogPrintf("%s: failed to write the insight index best block\n", __func__);
+}
+
+bool CInsightIndexer::Start()
+{
+    CBlockLocator locator;
+    if (!pblocktree->ReadInsightIndexBest(locator)) {
+        bool fIndexer = false;
+        pblocktree->ReadFlag("insightindexer", fIndexer);
+        if (!fIndexer) {
+            // ConnectBlock wrote the indexes of this block tree DB up to the chain tip
+            {
+                LOCK(cs_main);
+                locator = chainActive.GetLocator();
+            }
+            if (!pblocktree->WriteInsightIndexBest(locator) || !pblocktree->WriteFlag("insightindexer", true))
+                return error("%s: failed to write the insight index best block", __func__);
+        }
+    }
+
+    if (!locator.IsNull()) {
+        LOCK(cs_main);
+        // a stale tip is disconnected by the indexer thread, if it was not written to disk
+        // before a crash resume from the latest block of the locator on the active chain
+        BlockMap::iterator mi = mapBlockIndex.find(locator.vHave[0]);
+        const CBlockIndex* pindex = mi != mapBlockIndex.end() ? mi->second : FindForkInGlobalIndex(chainActive, locator);
+        if (!pindex)
+            return error("%s: indexes synced to unknown block %s", __func__, locator.vHave[0].ToString());
+        pindexBest = pindex;
+        nBestHeight = pindex->nHeight;
+    }
+    LogPrintf("%s: insight indexes synced to height %d\n", __func__, nBestHeight.load());
+
+    RegisterValidationInterface(this);
+    return true;
+}
+
+void CInsightIndexer::Thread()
+{
+    int64_t nLastLog = GetTime();
+    bool fCaughtUp = false;
+
+    while (true) {
+        boost::this_thread::interruption_point();
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            fNotified = false;
+        }
+
+        const CBlockIndex* pindexNext = nullptr;
+        bool fDisconnect = false;
+        int nTipHeight;
+        {
+            LOCK(cs_main);
+            const CBlockIndex* pindexTip = chainActive.Tip();
+            const CBlockIndex* pindexSynced = pindexBest;
+            nTipHeight = chainActive.Height();
+            if (!pindexSynced) {
+                pindexNext = chainActive.Genesis();
+            } else if (chainActive.Contains(pindexSynced)) {
+                pindexNext = chainActive.Next(pindexSynced);
+            } else if (pindexTip && pindexSynced->GetAncestor(pindexTip->nHeight) != pindexTip) {
+                // the active chain moved to another branch, remove the indexed blocks back to the fork
+                pindexNext = pindexSynced;
+                fDisconnect = true;
+            } else {
+                // the active chain is behind on the indexed branch. It catches up while it is
+                // reconnected after -reindex-chainstate and the indexer waits for it, unless an
+                // indexed block can no longer be connected, e.g. after invalidateblock
+                for (const CBlockIndex* pindex = pindexSynced; pindex && pindex != pindexTip; pindex = pindex->pprev) {
+                    if ((pindex->nStatus & BLOCK_FAILED_MASK) || !(pindex->nStatus & BLOCK_HAVE_DATA) || pindex->nChainTx == 0) {
+                        pindexNext = pindexSynced;
+                        fDisconnect = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (!pindexNext) {
+            if (!fCaughtUp) {
+                LogPrintf("%s: insight indexes synced to height %d\n", __func__, nBestHeight.load());
+                fCaughtUp = true;
+            }
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (!fNotified) {
+                condSync.wait(lock); // interruption point
+            }
+            continue;
+        }
+
+        if (!IndexBlock(pindexNext, fDisconnect)) {
+            AbortNode("Failed to write address index");
+            return;
+        }
+
+        if (GetTime() >= nLastLog + 60) {
+            LogPrintf("Syncing insight indexes... at height %d of %d\n", nBestHeight.load(), nTipHeight);
+            nLastLog = GetTime();
+        }
+    }
+}
+
+void ThreadInsightIndex()
+{
+    RenameThread("subi-insightidx");
+    insightIndexer.Thread();
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef SUBI_INSIGHTINDEXER_H
+#define SUBI_INSIGHTINDEXER_H
+
+#include "validationinterface.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+class CBlock;
+class CBlockIndex;
+
+class CInsightIndexer;
+
+extern CInsightIndexer insightIndexer;
+
+/**
+ * Writes the address, spent and timestamp indexes on a thread of its own, so connecting
+ * a block costs an indexing node no more than a plain one.
+ *
+ * The indexer follows chainActive from the block its indexes are synced to. That block is
+ * stored in the block tree DB on SetBestChain, once the block index entries it refers to are
+ * on disk, so after a crash the indexer replays the blocks since then, which rewrites the same
+ * entries. A block's entries are rebuilt from the block and its undo data, the latter holding
+ * the coins it spent, so blocks can be indexed or removed from the indexes long after they
+ * were connected. When the active chain moves to another branch the indexer removes its
+ * blocks back to the fork first, as it does when indexed blocks are disconnected for good.
+ * BlockConnected and BlockDisconnected only wake the indexer up.
+ */
+class CInsightIndexer : public CValidationInterface
+{
+private:
+    boost::mutex mutex;
+    boost::condition_variable condSync;
+    // set when the active chain changed since the indexer last looked at it
+    bool fNotified;
+
+    // block the indexes are synced to, only changed by the indexer thread after Start
+    std::atomic<const CBlockIndex*> pindexBest;
+    std::atomic<int> nBestHeight;
+
+    bool IndexBlock(const CBlockIndex* pindex, bool fDisconnect);
+
+protected:
+    void BlockConnected(const std::shared_ptr<const CBlock> &block, const CBlockIndex *pindex, const std::vector<CTransactionRef> &txnConflicted) override;
+    void BlockDisconnected(const std::shared_ptr<const CBlock> &block) override;
+    void SetBestChain(const CBlockLocator &locator) override;
+
+public:
+    CInsightIndexer() : fNotified(false), pindexBest(nullptr), nBestHeight(-1) {}
+
+    /**
+     * Load the block the indexes are synced to and subscribe to chain updates.
+     * Block tree DBs written before the indexer existed were indexed up to the chain tip.
+     */
+    bool Start();
+
+    /// Thread loop
+    void Thread();
+
+    /// Block the indexes are synced to, nullptr before the first one
+    const CBlockIndex* GetBestBlock() const { return pindexBest; }
+
+    /// Height of the block the indexes are synced to, -1 before the first one
+    int GetBestHeight() const { return nBestHeight; }
+};
+
+/** Run the thread writing the address, spent and timestamp indexes */
+void ThreadInsightIndex();
+
+#endif
@@ -58,7 +58,8 @@ void Accumulator::accumulate(const PublicCoin& coin, bool validateCoin) {
 
 	if(!validateCoin || coin.validate()) {
 		// Compute new accumulator = "old accumulator"^{element} mod N
-		this->value = this->value.pow_mod(coin.getValue(), this->params->accumulatorModulus);
+		// (QR_N works mod N and holds its Montgomery context)
+		this->value = this->params->accumulatorQRNCommitmentGroup.pow(this->value, coin.getValue());
 	} else {
 		throw ZerocoinException("Coin is not valid");
 	}
@@ -27,6 +27,9 @@ namespace libzerocoin {
         Bignum g_n = params->accumulatorQRNCommitmentGroup.g;
         Bignum h_n = params->accumulatorQRNCommitmentGroup.h;
 
+        const IntegerGroupParams& pok = params->accumulatorPoKCommitmentGroup;
+        const IntegerGroupParams& qrn = params->accumulatorQRNCommitmentGroup;
+
         Bignum e = commitmentToCoin.getContents();
         Bignum r = commitmentToCoin.getRandomness();
 
@@ -34,9 +37,9 @@ namespace libzerocoin {
         Bignum r_2 = Bignum::randBignum(params->accumulatorModulus / 4);
         Bignum r_3 = Bignum::randBignum(params->accumulatorModulus / 4);
 
-        this->C_e = g_n.pow_mod(e, params->accumulatorModulus) * h_n.pow_mod(r_1, params->accumulatorModulus);
-        this->C_u = witness.getValue() * h_n.pow_mod(r_2, params->accumulatorModulus);
-        this->C_r = g_n.pow_mod(r_2, params->accumulatorModulus) * h_n.pow_mod(r_3, params->accumulatorModulus);
+        this->C_e = qrn.gPow(e) * qrn.hPow(r_1);
+        this->C_u = witness.getValue() * qrn.hPow(r_2);
+        this->C_r = qrn.gPow(r_2) * qrn.hPow(r_3);
 
         Bignum r_alpha = Bignum::randBignum(params->maxCoinValue * Bignum(2).pow(params->k_prime + params->k_dprime));
         if (!(Bignum::randBignum(Bignum(3)) % 2)) {
@@ -78,31 +81,29 @@ namespace libzerocoin {
             r_delta = 0 - r_delta;
         }
 
-        this->st_1 = (sg.pow_mod(r_alpha, params->accumulatorPoKCommitmentGroup.modulus) *
-                      sh.pow_mod(r_phi, params->accumulatorPoKCommitmentGroup.modulus)) %
+        this->st_1 = (pok.gPow(r_alpha) *
+                      pok.hPow(r_phi)) %
                      params->accumulatorPoKCommitmentGroup.modulus;
-        this->st_2 = (((commitmentToCoin.getCommitmentValue() *
-                        sg.inverse(params->accumulatorPoKCommitmentGroup.modulus)).pow_mod(r_gamma,
-                                                                                           params->accumulatorPoKCommitmentGroup.modulus)) *
-                      sh.pow_mod(r_psi, params->accumulatorPoKCommitmentGroup.modulus)) %
+        this->st_2 = (pok.pow(commitmentToCoin.getCommitmentValue() * sg.inverse(params->accumulatorPoKCommitmentGroup.modulus),
+                               r_gamma) *
+                      pok.hPow(r_psi)) %
                      params->accumulatorPoKCommitmentGroup.modulus;
-        this->st_3 = ((sg * commitmentToCoin.getCommitmentValue()).pow_mod(r_sigma,
-                                                                           params->accumulatorPoKCommitmentGroup.modulus) *
-                      sh.pow_mod(r_xi, params->accumulatorPoKCommitmentGroup.modulus)) %
+        this->st_3 = (pok.pow(sg * commitmentToCoin.getCommitmentValue(), r_sigma) *
+                      pok.hPow(r_xi)) %
                      params->accumulatorPoKCommitmentGroup.modulus;
 
         this->t_1 =
-                (h_n.pow_mod(r_zeta, params->accumulatorModulus) * g_n.pow_mod(r_epsilon, params->accumulatorModulus)) %
+                (qrn.hPow(r_zeta) * qrn.gPow(r_epsilon)) %
                 params->accumulatorModulus;
         this->t_2 =
-                (h_n.pow_mod(r_eta, params->accumulatorModulus) * g_n.pow_mod(r_alpha, params->accumulatorModulus)) %
+                (qrn.hPow(r_eta) * qrn.gPow(r_alpha)) %
                 params->accumulatorModulus;
-        this->t_3 = (C_u.pow_mod(r_alpha, params->accumulatorModulus) *
-                     ((h_n.inverse(params->accumulatorModulus)).pow_mod(r_beta, params->accumulatorModulus))) %
+        this->t_3 = (qrn.pow(C_u, r_alpha) *
+                     qrn.hPow(-r_beta)) %
                     params->accumulatorModulus;
-        this->t_4 = (C_r.pow_mod(r_alpha, params->accumulatorModulus) *
-                     ((h_n.inverse(params->accumulatorModulus)).pow_mod(r_delta, params->accumulatorModulus)) *
-                     ((g_n.inverse(params->accumulatorModulus)).pow_mod(r_beta, params->accumulatorModulus))) %
+        this->t_4 = (qrn.pow(C_r, r_alpha) *
+                     qrn.hPow(-r_delta) *
+                     qrn.gPow(-r_beta)) %
                     params->accumulatorModulus;
 
         CHashWriter hasher(0, 0);
@@ -135,6 +136,9 @@ namespace libzerocoin {
         Bignum g_n = params->accumulatorQRNCommitmentGroup.g;
         Bignum h_n = params->accumulatorQRNCommitmentGroup.h;
 
+        const IntegerGroupParams& pok = params->accumulatorPoKCommitmentGroup;
+        const IntegerGroupParams& qrn = params->accumulatorQRNCommitmentGroup;
+
 
 
         //According to the proof, this hash should be of length k_prime bits.  It is currently greater than that, which should not be a problem, but we should check this.
@@ -144,37 +148,35 @@ namespace libzerocoin {
 
         Bignum c = Bignum(hasher.GetHash()); //this hash should be of length k_prime bits
 
-        Bignum st_1_prime = (valueOfCommitmentToCoin.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) *
-                             sg.pow_mod(s_alpha, params->accumulatorPoKCommitmentGroup.modulus) *
-                             sh.pow_mod(s_phi, params->accumulatorPoKCommitmentGroup.modulus)) %
+        Bignum st_1_prime = (pok.pow(valueOfCommitmentToCoin, c) *
+                             pok.gPow(s_alpha) *
+                             pok.hPow(s_phi)) %
                             params->accumulatorPoKCommitmentGroup.modulus;
-        Bignum st_2_prime = (sg.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) * ((valueOfCommitmentToCoin *
-                                                                                              sg.inverse(
-                                                                                                      params->accumulatorPoKCommitmentGroup.modulus)).pow_mod(
-                s_gamma, params->accumulatorPoKCommitmentGroup.modulus)) *
-                             sh.pow_mod(s_psi, params->accumulatorPoKCommitmentGroup.modulus)) %
+        Bignum st_2_prime = (pok.gPow(c) *
+                             pok.pow(valueOfCommitmentToCoin * sg.inverse(params->accumulatorPoKCommitmentGroup.modulus),
+                                     s_gamma) *
+                             pok.hPow(s_psi)) %
                             params->accumulatorPoKCommitmentGroup.modulus;
-        Bignum st_3_prime = (sg.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) *
-                             (sg * valueOfCommitmentToCoin).pow_mod(s_sigma,
-                                                                    params->accumulatorPoKCommitmentGroup.modulus) *
-                             sh.pow_mod(s_xi, params->accumulatorPoKCommitmentGroup.modulus)) %
+        Bignum st_3_prime = (pok.gPow(c) *
+                             pok.pow(sg * valueOfCommitmentToCoin, s_sigma) *
+                             pok.hPow(s_xi)) %
                             params->accumulatorPoKCommitmentGroup.modulus;
 
         Bignum t_1_prime =
-                (C_r.pow_mod(c, params->accumulatorModulus) * h_n.pow_mod(s_zeta, params->accumulatorModulus) *
-                 g_n.pow_mod(s_epsilon, params->accumulatorModulus)) % params->accumulatorModulus;
+                (qrn.pow(C_r, c) * qrn.hPow(s_zeta) *
+                 qrn.gPow(s_epsilon)) % params->accumulatorModulus;
         Bignum t_2_prime =
-                (C_e.pow_mod(c, params->accumulatorModulus) * h_n.pow_mod(s_eta, params->accumulatorModulus) *
-                 g_n.pow_mod(s_alpha, params->accumulatorModulus)) % params->accumulatorModulus;
+                (qrn.pow(C_e, c) * qrn.hPow(s_eta) *
+                 qrn.gPow(s_alpha)) % params->accumulatorModulus;
 
-        Bignum t_3_prime = ((a.getValue()).pow_mod(c, params->accumulatorModulus) *
-                            C_u.pow_mod(s_alpha, params->accumulatorModulus) *
-                            ((h_n.inverse(params->accumulatorModulus)).pow_mod(s_beta, params->accumulatorModulus))) %
+        Bignum t_3_prime = (qrn.pow(a.getValue(), c) *
+                            qrn.pow(C_u, s_alpha) *
+                            qrn.hPow(-s_beta)) %
                            params->accumulatorModulus;
 
-        Bignum t_4_prime = (C_r.pow_mod(s_alpha, params->accumulatorModulus) *
-                            ((h_n.inverse(params->accumulatorModulus)).pow_mod(s_delta, params->accumulatorModulus)) *
-                            ((g_n.inverse(params->accumulatorModulus)).pow_mod(s_beta, params->accumulatorModulus))) %
+        Bignum t_4_prime = (qrn.pow(C_r, s_alpha) *
+                            qrn.hPow(-s_delta) *
+                            qrn.gPow(-s_beta)) %
                            params->accumulatorModulus;
 
         bool result = false;
@@ -25,6 +25,28 @@ Params::Params(CBigNum N, CBigNum Nseed, uint32_t securityLevel) {
 
 	this->accumulatorParams.initialized = true;
 	this->initialized = true;
+
+	// Size the fixed-base tables for the longest exponents the proofs use
+	// with each group: S1..S3 of the commitment equality proof, sprime of
+	// the serial number proof (a product of two values below the SoK group
+	// order), r_alpha, s_sigma etc. of the accumulator proof and s_beta and
+	// s_delta in QR_N. Longer exponents still work, only without the table.
+	uint32_t commitmentBits = COMMITMENT_EQUALITY_CHALLENGE_SIZE + COMMITMENT_EQUALITY_SECMARGIN + 1 +
+	                          std::max(std::max(this->serialNumberSoKCommitmentGroup.modulus.bitSize(),
+	                                            this->accumulatorParams.accumulatorPoKCommitmentGroup.modulus.bitSize()),
+	                                   this->accumulatorParams.maxCoinValue.bitSize());
+	uint32_t serialBits = std::max<uint32_t>(commitmentBits, 2 * this->serialNumberSoKCommitmentGroup.groupOrder.bitSize() + 1);
+	uint32_t proofBits = HASH_OUTPUT_BITS + this->accumulatorParams.k_prime + this->accumulatorParams.k_dprime + 2 +
+	                     this->accumulatorParams.accumulatorModulus.bitSize() +
+	                     std::max(this->accumulatorParams.accumulatorPoKCommitmentGroup.modulus.bitSize(),
+	                              this->accumulatorParams.maxCoinValue.bitSize());
+
+	this->coinCommitmentGroup.Precompute(this->coinCommitmentGroup.modulus, commitmentBits);
+	this->serialNumberSoKCommitmentGroup.Precompute(this->serialNumberSoKCommitmentGroup.modulus, serialBits);
+	this->accumulatorParams.accumulatorPoKCommitmentGroup.Precompute(
+	        this->accumulatorParams.accumulatorPoKCommitmentGroup.modulus, commitmentBits);
+	this->accumulatorParams.accumulatorQRNCommitmentGroup.Precompute(
+	        this->accumulatorParams.accumulatorModulus, proofBits);
 }
 
 AccumulatorAndProofParams::AccumulatorAndProofParams() {
@@ -39,7 +61,48 @@ Bignum IntegerGroupParams::randomElement() const {
 	// The generator of the group raised
 	// to a random number less than the order of the group
 	// provides us with a uniformly distributed random number.
-	return this->g.pow_mod(Bignum::randBignum(this->groupOrder),this->modulus);
+	return this->gPow(Bignum::randBignum(this->groupOrder));
+}
+
+void IntegerGroupParams::Precompute(const Bignum& m, unsigned int nExpBits) {
+	this->mont = std::make_shared<const CBigNumMontCtx>(m);
+	this->gTable = std::make_shared<const CBigNumFixedBase>(this->g, this->mont, nExpBits);
+	this->hTable = std::make_shared<const CBigNumFixedBase>(this->h, this->mont, nExpBits);
+}
+
+std::shared_ptr<const CBigNumFixedBase> IntegerGroupParams::FixedBase(const Bignum& base, unsigned int nExpBits) const {
+	if (!this->mont)
+		return nullptr;
+	return std::make_shared<const CBigNumFixedBase>(base, this->mont, nExpBits);
+}
+
+/**
+ * Modulus for plain pow_mod when Precompute was never called. The QRN
+ * commitment group leaves "modulus" unset and works mod N, which it does
+ * not know, so it must not fall back at all.
+ */
+static const Bignum& FallbackModulus(const IntegerGroupParams& group) {
+	if (!group.modulus)
+		throw ZerocoinException("Group parameters without a modulus used before Precompute");
+	return group.modulus;
+}
+
+Bignum IntegerGroupParams::gPow(const Bignum& e) const {
+	if (this->gTable)
+		return this->gTable->pow(e);
+	return this->g.pow_mod(e, FallbackModulus(*this));
+}
+
+Bignum IntegerGroupParams::hPow(const Bignum& e) const {
+	if (this->hTable)
+		return this->hTable->pow(e);
+	return this->h.pow_mod(e, FallbackModulus(*this));
+}
+
+Bignum IntegerGroupParams::pow(const Bignum& base, const Bignum& e) const {
+	if (this->mont)
+		return this->mont->pow_mod(base, e);
+	return base.pow_mod(e, FallbackModulus(*this));
 }
 
 } /* namespace libzerocoin */
@@ -53,6 +53,30 @@ public:
 	 */
     CBigNum groupOrder;
 
+	/**
+	 * g^e, h^e and base^e modulo the group modulus. These use the
+	 * Montgomery context and fixed-base tables built by Precompute,
+	 * and plain pow_mod with "modulus" if it was never called. Groups
+	 * without a modulus of their own, like the QRN group, throw then.
+	 */
+	CBigNum gPow(const CBigNum& e) const;
+	CBigNum hPow(const CBigNum& e) const;
+	CBigNum pow(const CBigNum& base, const CBigNum& e) const;
+
+	/**
+	 * Build the Montgomery context for modulus m and the g/h tables
+	 * for exponents of up to nExpBits bits. m is passed separately as
+	 * the QRN group leaves "modulus" unset and works mod N.
+	 * Not serialized; call again after deserializing.
+	 */
+	void Precompute(const CBigNum& m, unsigned int nExpBits);
+
+	/**
+	 * Fixed-base table for some other base, worth building when the
+	 * same base is raised to many exponents. Null without Precompute.
+	 */
+	std::shared_ptr<const CBigNumFixedBase> FixedBase(const CBigNum& base, unsigned int nExpBits) const;
+
 	ADD_SERIALIZE_METHODS;
 
 	template <typename Stream, typename Operation>
@@ -62,8 +86,17 @@ public:
 		READWRITE(h);
 		READWRITE(modulus);
 		READWRITE(groupOrder);
+		if (ser_action.ForRead()) {
+			mont.reset();
+			gTable.reset();
+			hTable.reset();
+		}
 	};
 
+private:
+	std::shared_ptr<const CBigNumMontCtx> mont;
+	std::shared_ptr<const CBigNumFixedBase> gTable;
+	std::shared_ptr<const CBigNumFixedBase> hTable;
 };
 
 class AccumulatorAndProofParams {
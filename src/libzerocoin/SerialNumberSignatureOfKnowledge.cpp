@@ -29,11 +29,6 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 		throw ZerocoinException("Groups are not structured correctly.");
 	}
 
-	Bignum a = params->coinCommitmentGroup.g;
-	Bignum b = params->coinCommitmentGroup.h;
-	Bignum g = params->serialNumberSoKCommitmentGroup.g;
-	Bignum h = params->serialNumberSoKCommitmentGroup.h;
-
 	CHashWriter hasher(0,0);
 	hasher << *params << commitmentToCoin.getCommitmentValue() << coin.getSerialNumber();
     if (!msghash.IsNull())
@@ -45,9 +40,6 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 
 
 	for(uint32_t i=0; i < params->zkp_iterations; i++) {
-		//FIXME we really ought to use one BN_CTX for all of these
-		// operations for performance reasons, not the one that
-		// is created individually  by the wrapper
 		r[i] = Bignum::randBignum(params->coinCommitmentGroup.groupOrder);
 		v[i] = Bignum::randBignum(params->serialNumberSoKCommitmentGroup.groupOrder);
 	}
@@ -85,10 +77,10 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 			s_notprime[i]       = r[i];
 			sprime[i]           = v[i];
 		} else {
-            challenges.Add([this, i, &r, &v, &b, &commitmentToCoin, &coin] {
+            challenges.Add([this, i, &r, &v, &commitmentToCoin, &coin] {
                 s_notprime[i]   = r[i] - coin.getRandomness();
                 sprime[i]       = v[i] - (commitmentToCoin.getRandomness() *
-			                              b.pow_mod(r[i] - coin.getRandomness(), params->serialNumberSoKCommitmentGroup.groupOrder));
+			                              params->coinCommitmentGroup.hPow(r[i] - coin.getRandomness()));
             });
 		}
     }
@@ -98,15 +90,12 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 inline Bignum SerialNumberSignatureOfKnowledge::challengeCalculation(const Bignum& a_exp,const Bignum& b_exp,
         const Bignum& h_exp) const {
 
-	Bignum a = params->coinCommitmentGroup.g;
-	Bignum b = params->coinCommitmentGroup.h;
-	Bignum g = params->serialNumberSoKCommitmentGroup.g;
-	Bignum h = params->serialNumberSoKCommitmentGroup.h;
-
-	Bignum exponent = (a.pow_mod(a_exp, params->serialNumberSoKCommitmentGroup.groupOrder)
-	                   * b.pow_mod(b_exp, params->serialNumberSoKCommitmentGroup.groupOrder)) % params->serialNumberSoKCommitmentGroup.groupOrder;
+	// a = coinCommitmentGroup.g and b = coinCommitmentGroup.h are raised mod the
+	// order of the SoK group, which is the modulus of coinCommitmentGroup.
+	Bignum exponent = (params->coinCommitmentGroup.gPow(a_exp)
+	                   * params->coinCommitmentGroup.hPow(b_exp)) % params->serialNumberSoKCommitmentGroup.groupOrder;
 
-	return (g.pow_mod(exponent, params->serialNumberSoKCommitmentGroup.modulus) * h.pow_mod(h_exp, params->serialNumberSoKCommitmentGroup.modulus)) % params->serialNumberSoKCommitmentGroup.modulus;
+	return (params->serialNumberSoKCommitmentGroup.gPow(exponent) * params->serialNumberSoKCommitmentGroup.hPow(h_exp)) % params->serialNumberSoKCommitmentGroup.modulus;
 }
 
 bool SerialNumberSignatureOfKnowledge::Verify(const Bignum& coinSerialNumber, const Bignum& valueOfCommitmentToCoin,
@@ -114,10 +103,10 @@ bool SerialNumberSignatureOfKnowledge::Verify(const Bignum& coinSerialNumber, co
 
     ParallelTasks::DoNotDisturb dnd;
 
-	Bignum a = params->coinCommitmentGroup.g;
-	Bignum b = params->coinCommitmentGroup.h;
-	Bignum g = params->serialNumberSoKCommitmentGroup.g;
-	Bignum h = params->serialNumberSoKCommitmentGroup.h;
+	// challengeCalculation relies on the same group structure as the prover
+	if (params->coinCommitmentGroup.modulus != params->serialNumberSoKCommitmentGroup.groupOrder) {
+		return false;
+	}
 
 	// Make sure that the serial number has a unique representation
 	if (coinSerialNumber < 0 || coinSerialNumber >= params->coinCommitmentGroup.groupOrder){
@@ -133,19 +122,24 @@ bool SerialNumberSignatureOfKnowledge::Verify(const Bignum& coinSerialNumber, co
 	vector<CBigNum> tprime(params->zkp_iterations);
 	unsigned char *hashbytes = (unsigned char*) &this->hash;
 
+	// About half of the iterations raise valueOfCommitmentToCoin to an exponent
+	// below the coin commitment modulus, so a table for it pays for itself.
+	std::shared_ptr<const CBigNumFixedBase> commitmentTable = params->serialNumberSoKCommitmentGroup.FixedBase(
+	        valueOfCommitmentToCoin, params->coinCommitmentGroup.modulus.bitSize());
+
     ParallelTasks challenges(params->zkp_iterations);
 
 	for(uint32_t i = 0; i < params->zkp_iterations; i++) {
-        challenges.Add([this, i, hashbytes, &b, &h, &tprime, &coinSerialNumber, &valueOfCommitmentToCoin] {
+        challenges.Add([this, i, hashbytes, &tprime, &coinSerialNumber, &valueOfCommitmentToCoin, &commitmentTable] {
             int bit = i % 8;
             int byte = i / 8;
             bool challenge_bit = ((hashbytes[byte] >> bit) & 0x01);
             if(challenge_bit) {
                 tprime[i] = challengeCalculation(coinSerialNumber, s_notprime[i], sprime[i]);
             } else {
-                Bignum exp = b.pow_mod(s_notprime[i], params->serialNumberSoKCommitmentGroup.groupOrder);
-                tprime[i] = ((valueOfCommitmentToCoin.pow_mod(exp, params->serialNumberSoKCommitmentGroup.modulus) % params->serialNumberSoKCommitmentGroup.modulus) *
-                             (h.pow_mod(sprime[i], params->serialNumberSoKCommitmentGroup.modulus) % params->serialNumberSoKCommitmentGroup.modulus)) %
+                Bignum exp = params->coinCommitmentGroup.hPow(s_notprime[i]);
+                tprime[i] = ((commitmentTable ? commitmentTable->pow(exp) : params->serialNumberSoKCommitmentGroup.pow(valueOfCommitmentToCoin, exp)) *
+                             params->serialNumberSoKCommitmentGroup.hPow(sprime[i])) %
                             params->serialNumberSoKCommitmentGroup.modulus;
             }
         });
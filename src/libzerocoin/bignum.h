@@ -5,6 +5,7 @@
 #ifndef BITCOIN_BIGNUM_H
 #define BITCOIN_BIGNUM_H
 
+#include <memory>
 #include <stdexcept>
 #include <vector>
 #include <openssl/bn.h>
@@ -23,30 +24,35 @@ public:
     explicit bignum_error(const std::string& str) : std::runtime_error(str) {}
 };
 
-/** RAII encapsulated BN_CTX (OpenSSL bignum context) */
+/**
+ * Per-thread BN_CTX (OpenSSL bignum context). OpenSSL only borrows
+ * temporaries from a BN_CTX for the duration of a single call, so every
+ * CBigNum operation on a thread shares one context instead of allocating
+ * and freeing a new one each time.
+ */
 class CAutoBN_CTX
 {
 protected:
     BN_CTX* pctx;
-    BN_CTX* operator=(BN_CTX* pnew) { return pctx = pnew; }
+
+    struct CThreadBN_CTX
+    {
+        BN_CTX* pctx;
+        CThreadBN_CTX() : pctx(BN_CTX_new()) {}
+        ~CThreadBN_CTX() { if (pctx != NULL) BN_CTX_free(pctx); }
+    };
 
 public:
     CAutoBN_CTX()
     {
-        pctx = BN_CTX_new();
+        static thread_local CThreadBN_CTX threadCtx;
+        pctx = threadCtx.pctx;
         if (pctx == NULL)
             throw bignum_error("CAutoBN_CTX : BN_CTX_new() returned NULL");
     }
 
-    ~CAutoBN_CTX()
-    {
-        if (pctx != NULL)
-            BN_CTX_free(pctx);
-    }
-
     operator BN_CTX*() { return pctx; }
     BN_CTX& operator*() { return *pctx; }
-    BN_CTX** operator&() { return &pctx; }
     bool operator!() { return (pctx == NULL); }
 };
 
@@ -816,4 +822,155 @@ inline std::ostream& operator<<(std::ostream &strm, const CBigNum &b) { return s
 
 typedef CBigNum Bignum;
 
+/**
+ * RAII encapsulated BN_MONT_CTX (OpenSSL Montgomery context) for a fixed
+ * odd modulus, so repeated exponentiations modulo the same number don't
+ * each have to set one up again. Read-only after construction and safe to
+ * share between threads.
+ */
+class CBigNumMontCtx
+{
+private:
+    BN_MONT_CTX* mont;
+    CBigNum modulus;
+
+    CBigNumMontCtx(const CBigNumMontCtx&) = delete;
+    CBigNumMontCtx& operator=(const CBigNumMontCtx&) = delete;
+
+public:
+    explicit CBigNumMontCtx(const CBigNum& m) : modulus(m)
+    {
+        CAutoBN_CTX pctx;
+        mont = BN_MONT_CTX_new();
+        if (mont == NULL || !BN_is_odd(&m) || !BN_MONT_CTX_set(mont, &m, pctx)) {
+            if (mont != NULL)
+                BN_MONT_CTX_free(mont);
+            throw bignum_error("CBigNumMontCtx : BN_MONT_CTX_set failed");
+        }
+    }
+
+    ~CBigNumMontCtx()
+    {
+        BN_MONT_CTX_free(mont);
+    }
+
+    const CBigNum& getModulus() const { return modulus; }
+
+    /** base^e mod m, same result as base.pow_mod(e, m) */
+    CBigNum pow_mod(const CBigNum& base, const CBigNum& e) const {
+        CAutoBN_CTX pctx;
+        CBigNum ret;
+        if (e < 0) {
+            CBigNum inv = base.inverse(modulus);
+            CBigNum posE = e * -1;
+            if (!BN_mod_exp_mont(&ret, &inv, &posE, &modulus, pctx, mont))
+                throw bignum_error("CBigNumMontCtx::pow_mod : BN_mod_exp_mont failed on negative exponent");
+        } else if (!BN_mod_exp_mont(&ret, &base, &e, &modulus, pctx, mont))
+            throw bignum_error("CBigNumMontCtx::pow_mod : BN_mod_exp_mont failed");
+        return ret;
+    }
+
+    /** Convert to and from the Montgomery representation, and multiply in it. */
+    CBigNum to_mont(const CBigNum& a) const {
+        CAutoBN_CTX pctx;
+        CBigNum ret;
+        if (!BN_to_montgomery(&ret, &a, mont, pctx))
+            throw bignum_error("CBigNumMontCtx::to_mont : BN_to_montgomery failed");
+        return ret;
+    }
+
+    CBigNum from_mont(const CBigNum& a) const {
+        CAutoBN_CTX pctx;
+        CBigNum ret;
+        if (!BN_from_montgomery(&ret, &a, mont, pctx))
+            throw bignum_error("CBigNumMontCtx::from_mont : BN_from_montgomery failed");
+        return ret;
+    }
+
+    void mul_mont(CBigNum& r, const CBigNum& a, const CBigNum& b) const {
+        CAutoBN_CTX pctx;
+        if (!BN_mod_mul_montgomery(&r, &a, &b, mont, pctx))
+            throw bignum_error("CBigNumMontCtx::mul_mont : BN_mod_mul_montgomery failed");
+    }
+};
+
+/**
+ * Fixed-base exponentiation modulo a fixed modulus using a precomputed
+ * table of base^(2^(WINDOW*i)) (Yao's method). An exponent of n bits costs
+ * about n/WINDOW + 2^(WINDOW+1) multiplications and no squarings, against
+ * roughly n squarings plus n/5 multiplications for a generic
+ * exponentiation. Exponents longer than the table fall back to the generic
+ * Montgomery exponentiation.
+ */
+class CBigNumFixedBase
+{
+public:
+    static const unsigned int WINDOW = 5;
+
+private:
+    CBigNum base;
+    std::shared_ptr<const CBigNumMontCtx> mont;
+    //! base^(2^(WINDOW*i)) mod m in Montgomery form
+    std::vector<CBigNum> table;
+
+public:
+    CBigNumFixedBase(const CBigNum& b, const std::shared_ptr<const CBigNumMontCtx>& montIn, unsigned int nMaxBits)
+        : base(b % montIn->getModulus()), mont(montIn)
+    {
+        const unsigned int nDigits = (nMaxBits + WINDOW - 1) / WINDOW;
+        table.reserve(nDigits);
+        CBigNum x = mont->to_mont(base);
+        for (unsigned int i = 0; i < nDigits; i++) {
+            table.push_back(x);
+            for (unsigned int j = 0; j < WINDOW; j++)
+                mont->mul_mont(x, x, x);
+        }
+    }
+
+    unsigned int getMaxBits() const { return table.size() * WINDOW; }
+
+    /** base^e mod m, same result as base.pow_mod(e, m) */
+    CBigNum pow(const CBigNum& e) const {
+        if (e < 0)
+            return pow(e * -1).inverse(mont->getModulus());
+        const unsigned int nBits = e.bitSize();
+        if (nBits > getMaxBits())
+            return mont->pow_mod(base, e);
+
+        // Split e into WINDOW-bit digits, least significant first
+        const unsigned int nDigits = (nBits + WINDOW - 1) / WINDOW;
+        std::vector<unsigned char> digits(nDigits, 0);
+        for (unsigned int i = 0; i < nDigits; i++)
+            for (unsigned int j = 0; j < WINDOW; j++)
+                if (BN_is_bit_set(&e, i * WINDOW + j))
+                    digits[i] |= 1 << j;
+
+        // result = prod_d (prod of entries with digit >= d), highest d first
+        CBigNum acc, result;
+        bool fAcc = false, fResult = false;
+        for (unsigned int d = (1 << WINDOW) - 1; d > 0; d--) {
+            for (unsigned int i = 0; i < nDigits; i++) {
+                if (digits[i] != d)
+                    continue;
+                if (fAcc)
+                    mont->mul_mont(acc, acc, table[i]);
+                else
+                    acc = table[i];
+                fAcc = true;
+            }
+            if (fAcc) {
+                if (fResult)
+                    mont->mul_mont(result, result, acc);
+                else
+                    result = acc;
+                fResult = true;
+            }
+        }
+        if (!fResult)
+            return CBigNum(1) % mont->getModulus();
+        return mont->from_mont(result);
+    }
+};
+
+
 #endif
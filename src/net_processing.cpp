@@ -33,6 +33,7 @@
 #include "subinode/activesubinode.h"
 #include "subinode/darksend.h"
 #include "subinode/subinode-payments.h"
+#include "subinode/subinode-sigqueue.h"
 #include "subinode/subinode-sync.h"
 #include "subinode/subinodeman.h"
 #include "subinode/subinodeconfig.h"
@@ -590,6 +591,7 @@ void PeerLogicValidation::InitializeNode(CNode *pnode) {
 
 void PeerLogicValidation::FinalizeNode(NodeId nodeid, bool& fUpdateConnectionTime) {
     fUpdateConnectionTime = false;
+    subinodeSigQueue.ForgetNode(nodeid);
     LOCK(cs_main);
     CNodeState *state = State(nodeid);
     assert(state != nullptr);
@@ -3229,6 +3231,9 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
     if (pfrom->fDisconnect)
         return false;
 
+    // subinode messages whose signers were recovered in the background
+    subinodeSigQueue.ProcessReady(pfrom);
+
     // this maintains the order of responses
     if (!pfrom->vRecvGetData.empty()) return true;
 
@@ -19,6 +19,16 @@
 #include <policy/policy.h>
 #include <consensus/validation.h>
 #include <coins.h>
+#include <crypto/common.h>
+#include <util.h>
+
+#include <checkqueue.h>
+
+#include <algorithm>
+#include <atomic>
+
+//! Candidates per range of a kernel search, a single range is searched without the kernel search threads
+static const size_t KERNEL_SEARCH_BATCH = 2000;
 
 /**
  * Stake Modifier (hash modifier of proof-of-stake):
@@ -37,6 +47,21 @@ uint256 ComputeStakeModifierV2(const CBlockIndex *pindexPrev, const uint256 &ker
     return Hash(ss.begin(), ss.end());
 }
 
+uint256 ComputeKernelHash(const uint256 &bnStakeModifier, uint32_t nBlockFromTime, const COutPoint &prevout, uint32_t nTime)
+{
+    // Same bytes as serializing the fields into a CDataStream, without the stream
+    unsigned char preimage[32 + 4 + 32 + 4 + 4];
+    memcpy(preimage, bnStakeModifier.begin(), 32);
+    WriteLE32(preimage + 32, nBlockFromTime);
+    memcpy(preimage + 36, prevout.hash.begin(), 32);
+    WriteLE32(preimage + 68, prevout.n);
+    WriteLE32(preimage + 72, nTime);
+
+    uint256 hash;
+    CHash256().Write(preimage, sizeof(preimage)).Finalize(hash.begin());
+    return hash;
+}
+
 /**
  * BlackCoin kernel protocol
  * coinstake must meet hash target according to the protocol:
@@ -90,10 +115,7 @@ bool CheckStakeKernelHash(const CBlockIndex *pindexPrev,
 
 
 
-    CDataStream ss(SER_GETHASH, 0);
-    ss << bnStakeModifier;
-    ss << nBlockFromTime << prevout.hash << prevout.n << nTime;
-    hashProofOfStake = Hash(ss.begin(), ss.end());
+    hashProofOfStake = ComputeKernelHash(bnStakeModifier, nBlockFromTime, prevout, nTime);
 
     /*
     LogPrintf("CheckStakeKernelHash(): \n"
@@ -326,6 +348,19 @@ bool CheckKernel(const CBlockIndex *pindexPrev, unsigned int nBits, int64_t nTim
 {
     uint256 hashProofOfStake, targetProofOfStake;
 
+    CStakeCandidate candidate;
+    if (!GetStakeCandidate(pindexPrev, prevout, candidate))
+        return false;
+
+    if (pBlockTime)
+        *pBlockTime = candidate.nBlockFromTime;
+
+    return CheckStakeKernelHash(pindexPrev, nBits, candidate.nBlockFromTime,
+        candidate.nValue, prevout, nTime, hashProofOfStake, targetProofOfStake);
+}
+
+bool GetStakeCandidate(const CBlockIndex *pindexPrev, const COutPoint &prevout, CStakeCandidate &candidate)
+{
     Coin coin;
     if (!pcoinsTip->GetCoin(prevout, coin))
         return error("%s: prevout not found", __func__);
@@ -350,11 +385,86 @@ bool CheckKernel(const CBlockIndex *pindexPrev, unsigned int nBits, int64_t nTim
     if (nRequiredDepth > nDepth)
         return false;
 
-    if (pBlockTime)
-        *pBlockTime = pindex->GetBlockTime();
+    candidate.prevout = prevout;
+    candidate.nValue = coin.out.nValue;
+    candidate.nBlockFromTime = pindex->GetBlockTime();
+    return true;
+}
 
-    CAmount amount = coin.out.nValue;
-    return CheckStakeKernelHash(pindexPrev, nBits, *pBlockTime,
-        amount, prevout, nTime, hashProofOfStake, targetProofOfStake);
+bool CKernelSearchCheck::operator()()
+{
+    const std::vector<CStakeCandidate> &candidates = *pcandidates;
+    uint64_t nCheckHashed = 0;
+    for (size_t i = nFirst; i < nLast && i < pnFound->load(std::memory_order_relaxed); i++)
+    {
+        const CStakeCandidate &candidate = candidates[i];
+        if (nTime < candidate.nBlockFromTime)
+            continue;
+
+        nCheckHashed++;
+        uint256 hashProofOfStake = ComputeKernelHash(bnStakeModifier, candidate.nBlockFromTime, candidate.prevout, nTime);
+        if (UintToArith256(hashProofOfStake) > bnTarget * arith_uint256(candidate.nValue))
+            continue;
+
+        size_t nPrev = pnFound->load();
+        while (i < nPrev && !pnFound->compare_exchange_weak(nPrev, i));
+        break;
+    }
+    *pnHashed += nCheckHashed;
+    // a kernel is not a failure, the ranges before it still have to be searched
+    return true;
+}
+
+void CKernelSearchCheck::swap(CKernelSearchCheck &check)
+{
+    std::swap(pcandidates, check.pcandidates);
+    std::swap(nFirst, check.nFirst);
+    std::swap(nLast, check.nLast);
+    std::swap(bnStakeModifier, check.bnStakeModifier);
+    std::swap(bnTarget, check.bnTarget);
+    std::swap(nTime, check.nTime);
+    std::swap(pnFound, check.pnFound);
+    std::swap(pnHashed, check.pnHashed);
+}
+
+static CCheckQueue<CKernelSearchCheck> kernelsearchqueue(1);
+
+void ThreadKernelSearch()
+{
+    RenameThread("subi-kernelsrch");
+    kernelsearchqueue.Thread();
 }
 
+size_t FindStakeKernel(const CBlockIndex *pindexPrev, unsigned int nBits, uint32_t nTime, const std::vector<CStakeCandidate> &candidates, size_t nStart, uint64_t *pnHashed)
+{
+    arith_uint256 bnTarget;
+    bool fNegative;
+    bool fOverflow;
+
+    bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
+    if (fNegative || fOverflow || bnTarget == 0 || nStart >= candidates.size())
+        return candidates.size();
+
+    // Lowest index found so far, searches stop once they are past it
+    std::atomic<size_t> nFound(candidates.size());
+    std::atomic<uint64_t> nHashed(0);
+
+    // Small sets are searched right here, larger ones in ranges shared with the kernel search threads
+    std::vector<CKernelSearchCheck> vChecks;
+    for (size_t nFirst = nStart; nFirst < candidates.size(); nFirst += KERNEL_SEARCH_BATCH)
+        vChecks.emplace_back(&candidates, nFirst, std::min(candidates.size(), nFirst + KERNEL_SEARCH_BATCH),
+                             pindexPrev->bnStakeModifier, bnTarget, nTime, &nFound, &nHashed);
+    if (vChecks.size() == 1) {
+        vChecks[0]();
+    } else {
+        // the queue hands out its last checks first, start with the lowest candidates
+        std::reverse(vChecks.begin(), vChecks.end());
+        CCheckQueueControl<CKernelSearchCheck> control(&kernelsearchqueue);
+        control.Add(vChecks);
+        control.Wait();
+    }
+
+    if (pnHashed)
+        *pnHashed += nHashed;
+    return nFound;
+}
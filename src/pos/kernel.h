@@ -7,11 +7,56 @@
 #define PPCOIN_KERNEL_H
 
 #include <validation.h>
+#include <arith_uint256.h>
 
+#include <atomic>
+
+
+/** Kernel input data a kernel hash is computed from */
+struct CStakeCandidate
+{
+    COutPoint prevout;
+    CAmount nValue;
+    uint32_t nBlockFromTime;
+};
+
+/**
+ * Search of a contiguous range of kernel candidates for the first one meeting the hash target.
+ * Run through CCheckQueue by FindStakeKernel, the ranges of one search share pnFound and stop
+ * once a lower candidate is found
+ */
+class CKernelSearchCheck {
+private:
+    const std::vector<CStakeCandidate> *pcandidates;
+    size_t nFirst;
+    size_t nLast;
+    uint256 bnStakeModifier;
+    arith_uint256 bnTarget;
+    uint32_t nTime;
+    std::atomic<size_t> *pnFound;
+    std::atomic<uint64_t> *pnHashed;
+
+public:
+    CKernelSearchCheck() : pcandidates(nullptr), nFirst(0), nLast(0), nTime(0), pnFound(nullptr), pnHashed(nullptr) {}
+    CKernelSearchCheck(const std::vector<CStakeCandidate> *pcandidatesIn, size_t nFirstIn, size_t nLastIn, const uint256 &bnStakeModifierIn,
+                       const arith_uint256 &bnTargetIn, uint32_t nTimeIn, std::atomic<size_t> *pnFoundIn, std::atomic<uint64_t> *pnHashedIn) :
+        pcandidates(pcandidatesIn), nFirst(nFirstIn), nLast(nLastIn), bnStakeModifier(bnStakeModifierIn),
+        bnTarget(bnTargetIn), nTime(nTimeIn), pnFound(pnFoundIn), pnHashed(pnHashedIn) {}
+
+    bool operator()();
+
+    void swap(CKernelSearchCheck &check);
+};
 
 // Compute the hash modifier for proof-of-stake
 uint256 ComputeStakeModifierV2(const CBlockIndex *pindexPrev, const uint256 &kernel);
 
+/**
+ * Compute the kernel hash of a stake input at nTime,
+ * SHA256d of the fixed 76 byte preimage stake modifier, nBlockFromTime, prevout and nTime
+ */
+uint256 ComputeKernelHash(const uint256 &bnStakeModifier, uint32_t nBlockFromTime, const COutPoint &prevout, uint32_t nTime);
+
 /**
  * Check whether stake kernel meets hash target
  * Sets hashProofOfStake on success return
@@ -41,4 +86,21 @@ bool CheckCoinStakeTimestamp(int nHeight, int64_t nTimeBlock);
  */
 bool CheckKernel(const CBlockIndex *pindexPrev, unsigned int nBits, int64_t nTime, const COutPoint &prevout, int64_t* pBlockTime = nullptr);
 
+/**
+ * Look up a kernel input in the UTXO set
+ * Fails if it is missing or not deep enough to stake on top of pindexPrev
+ */
+bool GetStakeCandidate(const CBlockIndex *pindexPrev, const COutPoint &prevout, CStakeCandidate &candidate);
+
+/**
+ * Search candidates from nStart on for a kernel meeting the hash target at nTime
+ * Returns the index of the first one found, or candidates.size() if there is none
+ * Large candidate sets are shared with the ThreadKernelSearch threads
+ * Adds the number of kernel hashes computed to pnHashed if given
+ */
+size_t FindStakeKernel(const CBlockIndex *pindexPrev, unsigned int nBits, uint32_t nTime, const std::vector<CStakeCandidate> &candidates, size_t nStart = 0, uint64_t *pnHashed = nullptr);
+
+/** Run an instance of the kernel search thread */
+void ThreadKernelSearch();
+
 #endif // PPCOIN_KERNEL_H
@@ -42,6 +42,99 @@ std::atomic<int64_t> nTimeLastStake(0);
 
 extern double GetDifficulty(const CBlockIndex* blockindex = nullptr);
 
+CStakingTelemetry stakingTelemetry;
+
+const char *GetStakePhaseName(StakePhase phase)
+{
+    switch (phase)
+    {
+        case STAKE_PHASE_LOCK_WAIT: return "lockwait";
+        case STAKE_PHASE_CREATE_BLOCK: return "createblock";
+        case STAKE_PHASE_SELECT_COINS: return "selectcoins";
+        case STAKE_PHASE_KERNEL_SEARCH: return "kernelsearch";
+        case STAKE_PHASE_SIGN_BLOCK: return "signblock";
+        default: return "unknown";
+    };
+};
+
+void StakePhaseStats::Add(int64_t nMicros)
+{
+    nCount++;
+    nTotalMicros += nMicros;
+    nMaxMicros = std::max(nMaxMicros, nMicros);
+
+    int nBucket = 0;
+    for (int64_t nMillis = nMicros / 1000; nMillis > 0 && nBucket < STAKE_LATENCY_BUCKETS - 1; nMillis >>= 1)
+        nBucket++;
+    vBuckets[nBucket]++;
+};
+
+void CStakingTelemetry::AddPhase(StakePhase phase, int64_t nMicros)
+{
+    LOCK(cs);
+    if (stats.nTimeStarted == 0)
+        stats.nTimeStarted = GetTime();
+    stats.vPhases[phase].Add(nMicros);
+};
+
+void CStakingTelemetry::AddKernelSearch(uint64_t nKernels, int64_t nMicros)
+{
+    LOCK(cs);
+    stats.nKernelsHashed += nKernels;
+    stats.vPhases[STAKE_PHASE_KERNEL_SEARCH].Add(nMicros);
+};
+
+CKernelSearchTimer::~CKernelSearchTimer()
+{
+    stakingTelemetry.AddKernelSearch(nKernels, nMicros);
+    LogPrint(BCLog::POS, "%s: Hashed %u kernels in %.2fms.\n", __func__, nKernels, nMicros * 0.001);
+};
+
+size_t CKernelSearchTimer::Find(const CBlockIndex *pindexPrev, unsigned int nBits, uint32_t nTime, const std::vector<CStakeCandidate> &candidates, size_t nStart)
+{
+    int64_t nTimeStart = GetTimeMicros();
+    size_t nKernel = FindStakeKernel(pindexPrev, nBits, nTime, candidates, nStart, &nKernels);
+    nMicros += GetTimeMicros() - nTimeStart;
+    return nKernel;
+};
+
+void CStakingTelemetry::AddStake(const uint256 &hashBlock, bool fAccepted)
+{
+    LOCK(cs);
+    stats.nStakesFound++;
+    if (!fAccepted)
+    {
+        stats.nStakesRejected++;
+        return;
+    };
+
+    stats.nStakesAccepted++;
+    recentStakes.push_back(hashBlock);
+    if (recentStakes.size() > MAX_TRACKED_STAKES)
+        recentStakes.pop_front();
+};
+
+StakingStats CStakingTelemetry::GetStats() const
+{
+    LOCK2(cs_main, cs);
+    StakingStats ret = stats;
+    for (const uint256 &hash : recentStakes)
+    {
+        BlockMap::const_iterator mi = mapBlockIndex.find(hash);
+        if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second))
+            ret.nStakesOrphaned++;
+    };
+    return ret;
+};
+
+void CStakingTelemetry::Reset()
+{
+    LOCK(cs);
+    stats = StakingStats();
+    stats.nTimeStarted = GetTime();
+    recentStakes.clear();
+};
+
 double GetPoSKernelPS()
 {
     LOCK(cs_main);
@@ -225,7 +318,9 @@ void ThreadStakeMiner(size_t nThreadID, std::vector<CWalletRef> &vpwallets, size
 
 
         {
+            int64_t nTimeLock = GetTimeMicros();
             LOCK(cs_main);
+            stakingTelemetry.AddPhase(STAKE_PHASE_LOCK_WAIT, GetTimeMicros() - nTimeLock);
             nBestHeight = chainActive.Height();
             nBestTime = chainActive.Tip()->nTime;
         }
@@ -315,7 +410,11 @@ void ThreadStakeMiner(size_t nThreadID, std::vector<CWalletRef> &vpwallets, size
 
             if (!pblocktemplate.get())
             {
+                int64_t nTimeCreate = GetTimeMicros();
                 pblocktemplate = BlockAssembler(Params()).CreateNewBlock(coinbaseScript);
+                nTimeCreate = GetTimeMicros() - nTimeCreate;
+                stakingTelemetry.AddPhase(STAKE_PHASE_CREATE_BLOCK, nTimeCreate);
+                LogPrint(BCLog::POS, "%s: Created new block in %.2fms.\n", __func__, nTimeCreate * 0.001);
                 if (!pblocktemplate.get())
                 {
                     fIsStaking = false;
@@ -329,10 +428,17 @@ void ThreadStakeMiner(size_t nThreadID, std::vector<CWalletRef> &vpwallets, size
             pwallet->nIsStaking = CWallet::IS_STAKING;
             nWaitFor = nMinerSleep;
             fIsStaking = true;
-            if (pwallet->SignBlock(pblocktemplate.get(), nBestHeight+1, nSearchTime))
+            int64_t nTimeSign = GetTimeMicros();
+            bool fSigned = pwallet->SignBlock(pblocktemplate.get(), nBestHeight+1, nSearchTime);
+            nTimeSign = GetTimeMicros() - nTimeSign;
+            stakingTelemetry.AddPhase(STAKE_PHASE_SIGN_BLOCK, nTimeSign);
+            LogPrint(BCLog::POS, "%s: Wallet %d, staking round took %.2fms.\n", __func__, i, nTimeSign * 0.001);
+            if (fSigned)
             {
                 CBlock *pblock = &pblocktemplate->block;
-                if (CheckStake(pblock))
+                bool fAccepted = CheckStake(pblock);
+                stakingTelemetry.AddStake(pblock->GetHash(), fAccepted);
+                if (fAccepted)
                 {
                      nTimeLastStake = GetTime();
                      break;
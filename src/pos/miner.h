@@ -2,12 +2,17 @@
 #define SUBI_POS_MINER_H
 
 #include <primitives/block.h>
+#include <sync.h>
+#include <uint256.h>
 #include <thread>
 #include <condition_variable>
 #include <atomic>
+#include <deque>
 #include <vector>
 
+class CBlockIndex;
 class CWallet;
+struct CStakeCandidate;
 
 class StakeThread
 {
@@ -24,6 +29,83 @@ public:
 
 extern std::vector<StakeThread*> vStakeThreads;
 
+//! Number of buckets in a stake loop latency histogram
+static const int STAKE_LATENCY_BUCKETS = 16;
+//! Number of our most recent accepted stakes checked for having been orphaned
+static const size_t MAX_TRACKED_STAKES = 1000;
+
+/** Phases of the stake loop whose latencies are tracked */
+enum StakePhase
+{
+    STAKE_PHASE_LOCK_WAIT,      // waiting for cs_main / cs_wallet
+    STAKE_PHASE_CREATE_BLOCK,   // BlockAssembler::CreateNewBlock
+    STAKE_PHASE_SELECT_COINS,   // CWallet::SelectCoinsForStaking
+    STAKE_PHASE_KERNEL_SEARCH,  // hashing the kernels of the selected coins
+    STAKE_PHASE_SIGN_BLOCK,     // CWallet::SignBlock, one staking round
+    STAKE_PHASE_COUNT
+};
+
+const char *GetStakePhaseName(StakePhase phase);
+
+/** Latencies of one phase of the stake loop */
+struct StakePhaseStats
+{
+    uint64_t nCount = 0;
+    int64_t nTotalMicros = 0;
+    int64_t nMaxMicros = 0;
+    //! bucket 0 counts durations below 1ms, bucket i those below 2^i ms, the last one all longer ones
+    uint64_t vBuckets[STAKE_LATENCY_BUCKETS] = {};
+
+    void Add(int64_t nMicros);
+};
+
+struct StakingStats
+{
+    int64_t nTimeStarted = 0;
+    uint64_t nKernelsHashed = 0;
+    uint64_t nStakesFound = 0;
+    uint64_t nStakesRejected = 0;   // found but not accepted, e.g. stale by the time they were signed
+    uint64_t nStakesAccepted = 0;
+    uint64_t nStakesOrphaned = 0;   // accepted, but no longer in the active chain
+    StakePhaseStats vPhases[STAKE_PHASE_COUNT];
+};
+
+/** Counters and latency histograms of the stake loop, shared by all staking threads */
+class CStakingTelemetry
+{
+private:
+    mutable CCriticalSection cs;
+    StakingStats stats;
+    // hashes of our most recent accepted stakes
+    std::deque<uint256> recentStakes;
+
+public:
+    void AddPhase(StakePhase phase, int64_t nMicros);
+    void AddKernelSearch(uint64_t nKernels, int64_t nMicros);
+    void AddStake(const uint256 &hashBlock, bool fAccepted);
+
+    /** Current counters, checking which of our recent stakes were orphaned */
+    StakingStats GetStats() const;
+    void Reset();
+};
+
+extern CStakingTelemetry stakingTelemetry;
+
+/** Times the kernel searches of a staking round and records them however the round ends */
+class CKernelSearchTimer
+{
+private:
+    uint64_t nKernels;
+    int64_t nMicros;
+
+public:
+    CKernelSearchTimer() : nKernels(0), nMicros(0) {}
+    ~CKernelSearchTimer();
+
+    /** FindStakeKernel, with only the search itself timed */
+    size_t Find(const CBlockIndex *pindexPrev, unsigned int nBits, uint32_t nTime, const std::vector<CStakeCandidate> &candidates, size_t nStart);
+};
+
 extern std::atomic<bool> fIsStaking;
 
 extern int nMinStakeInterval;
@@ -12,6 +12,10 @@
 #include <chainparams.h>
 #include <timedata.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 /*Forward declarations*/
 /*********************/
 unsigned int static DarkGravityWave(const CBlockIndex* pindexLast, const Consensus::Params& params);
@@ -94,6 +98,36 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
     return true;
 }
 
+void ComputePoWHashesParallel(size_t nCount, const std::function<void(size_t, size_t, uint256*)>& hashRangeFn, std::vector<uint256>& vHashesRet, int nThreads)
+{
+    vHashesRet.assign(nCount, uint256());
+    if (nCount == 0)
+        return;
+
+    // Hand out work in small chunks so that threads finishing early (neoscrypt
+    // and X16R rounds differ a lot in cost) keep picking up more. Chunks are a
+    // multiple of the widest neoscrypt batch.
+    static const size_t nChunkSize = 64;
+    std::atomic<size_t> nNext(0);
+    auto worker = [&]() {
+        while (true) {
+            size_t nBegin = nNext.fetch_add(nChunkSize);
+            if (nBegin >= nCount)
+                return;
+            hashRangeFn(nBegin, std::min(nBegin + nChunkSize, nCount), &vHashesRet[nBegin]);
+        }
+    };
+
+    size_t nWorkers = std::min<size_t>(std::max(nThreads, 1), (nCount + nChunkSize - 1) / nChunkSize);
+    std::vector<std::thread> vThreads;
+    vThreads.reserve(nWorkers - 1);
+    for (size_t i = 1; i < nWorkers; i++)
+        vThreads.emplace_back(worker);
+    worker();
+    for (std::thread& thread : vThreads)
+        thread.join();
+}
+
 unsigned int static DarkGravityWave(const CBlockIndex* pindexLast, const Consensus::Params& params) {
 
     const arith_uint256 bnPowLimit = UintToArith256(params.powLimit);
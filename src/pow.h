@@ -10,6 +10,9 @@
 
 #include <stdint.h>
 
+#include <functional>
+#include <vector>
+
 class CBlockHeader;
 class CBlockIndex;
 class uint256;
@@ -19,4 +22,11 @@ unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHead
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
 unsigned int GetNextTargetRequired(const CBlockIndex *pindexLast);
 
+/**
+ * Fill vHashesRet with nCount hashes on up to nThreads threads. Work is handed
+ * out as ranges: hashRangeFn(nBegin, nEnd, pHashes) must write the hashes of
+ * entries [nBegin, nEnd) to pHashes, and be safe to call concurrently.
+ */
+void ComputePoWHashesParallel(size_t nCount, const std::function<void(size_t, size_t, uint256*)>& hashRangeFn, std::vector<uint256>& vHashesRet, int nThreads);
+
 #endif // BITCOIN_POW_H
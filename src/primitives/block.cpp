@@ -25,7 +25,7 @@ uint256 CBlockHeader::GetPoWHash(int nHeight) const
   uint256 thash;
   unsigned int profile = 0x0;
 
-  if (nHeight >= 60000) {
+  if (nHeight >= X16R_ACTIVATION_HEIGHT) {
     thash = HashX16R(BEGIN(nVersion), END(nNonce), hashPrevBlock);
   } else {
     neoscrypt((unsigned char *) &nVersion, (unsigned char *) &thash, profile);
@@ -33,6 +33,28 @@ uint256 CBlockHeader::GetPoWHash(int nHeight) const
   return thash;
 }
 
+void GetBlockPoWHashes(const CBlockHeader* headers, const int* heights, size_t count, uint256* hashes)
+{
+    std::vector<size_t> vNeoscrypt;
+    std::vector<unsigned char> vInput;
+    for (size_t i = 0; i < count; i++) {
+        if (heights[i] >= X16R_ACTIVATION_HEIGHT) {
+            hashes[i] = headers[i].GetPoWHash(heights[i]);
+        } else {
+            const unsigned char* pbegin = (const unsigned char*)&headers[i].nVersion;
+            vInput.insert(vInput.end(), pbegin, pbegin + 80);
+            vNeoscrypt.push_back(i);
+        }
+    }
+    if (vNeoscrypt.empty())
+        return;
+
+    std::vector<unsigned char> vOutput(vNeoscrypt.size() * 32);
+    neoscrypt_batch(vInput.data(), vOutput.data(), vNeoscrypt.size(), 0);
+    for (size_t i = 0; i < vNeoscrypt.size(); i++)
+        memcpy(hashes[vNeoscrypt[i]].begin(), &vOutput[i * 32], 32);
+}
+
 std::string CBlock::ToString() const
 {
     std::stringstream s;
@@ -10,6 +10,9 @@
 #include <serialize.h>
 #include <uint256.h>
 
+/** First block height whose proof of work is X16R instead of neoscrypt. */
+static const int X16R_ACTIVATION_HEIGHT = 60000;
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -71,6 +74,12 @@ public:
     }
 };
 
+/**
+ * Compute the proof of work hash of each of count headers at the matching
+ * height. Neoscrypt headers are hashed several at a time with neoscrypt_batch().
+ */
+void GetBlockPoWHashes(const CBlockHeader* headers, const int* heights, size_t count, uint256* hashes);
+
 class CZerocoinTxInfo;
 
 class CBlock : public CBlockHeader
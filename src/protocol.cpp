@@ -57,6 +57,8 @@ const char *DSSTATUSUPDATE = "dssu";
 const char *DSTX = "dstx";
 const char *DSQUEUE = "dsq";
 const char *DSEG = "dseg";
+const char *MNLISTGET = "mnlget";
+const char *MNLIST = "mnlist";
 const char *SYNCSTATUSCOUNT = "ssc";
 const char *MNVERIFY = "mnv";
 const char *TXLOCKREQUEST = "ix";
@@ -128,6 +130,8 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::DSTX,
     NetMsgType::DSQUEUE,
     NetMsgType::DSEG,
+    NetMsgType::MNLISTGET,
+    NetMsgType::MNLIST,
     NetMsgType::SYNCSTATUSCOUNT,
     NetMsgType::MNVERIFY,
 };
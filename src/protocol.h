@@ -251,6 +251,8 @@ extern const char *MNANNOUNCE;
 extern const char *DSACCEPT;
 extern const char *DSQUEUE;
 extern const char *DSEG;
+extern const char *MNLISTGET;
+extern const char *MNLIST;
 extern const char *DSVIN;
 extern const char *DSSTATUSUPDATE;
 extern const char *DSSIGNFINALTX;
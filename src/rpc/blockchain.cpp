@@ -24,6 +24,7 @@
 #include <util.h>
 #include <utilstrencodings.h>
 #include <hash.h>
+#include <insightindexer.h>
 #include <validationinterface.h>
 #include <warnings.h>
 
@@ -1200,6 +1201,7 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
             "  \"pruneheight\": xxxxxx,        (numeric) lowest-height complete block stored (only present if pruning is enabled)\n"
             "  \"automatic_pruning\": xx,      (boolean) whether automatic pruning is enabled (only present if pruning is enabled)\n"
             "  \"prune_target_size\": xxxxxx,  (numeric) the target size used by pruning (only present if automatic pruning is enabled)\n"
+            "  \"insightindexheight\": xxxxxx, (numeric) height of the block the address, spent and timestamp indexes are synced to (only present if one of them is enabled)\n"
             "  \"softforks\": [                (array) status of softforks in progress\n"
             "     {\n"
             "        \"id\": \"xxxx\",           (string) name of softfork\n"
@@ -1263,6 +1265,9 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
         }
     }
 
+    if (fAddressIndex || fSpentIndex || fTimestampIndex)
+        obj.push_back(Pair("insightindexheight", insightIndexer.GetBestHeight()));
+
     const Consensus::Params& consensusParams = Params().GetConsensus();
     CBlockIndex* tip = chainActive.Tip();
     UniValue softforks(UniValue::VARR);
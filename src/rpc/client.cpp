@@ -173,6 +173,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     //SUBI Staking functions
     { "walletsettings", 1, "json" },
     { "reservebalance", 0, "enabled" },
+    { "getstakingstats", 0, "reset" },
 
     { "delegatestaking", 1, "amount" },
     { "delegatestaking", 2, "fee percent" },
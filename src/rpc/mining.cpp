@@ -11,6 +11,7 @@
 #include <consensus/params.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <crypto/x16r/x16r.h>
 #include <init.h>
 #include <validation.h>
 #include <miner.h>
@@ -106,6 +107,36 @@ UniValue getnetworkhashps(const JSONRPCRequest& request)
     return GetNetworkHashPS(!request.params[0].isNull() ? request.params[0].get_int() : 120, !request.params[1].isNull() ? request.params[1].get_int() : -1);
 }
 
+/**
+ * Grind nNonce of an X16R block in batches. The algorithm order and the first
+ * round state only depend on the header fields before nNonce, so they are set
+ * up once per template and the nonces are hashed several at a time.
+ */
+static void GrindX16RNonce(CBlock* pblock, uint32_t nInnerLoopCount, uint64_t& nMaxTries)
+{
+    static const size_t nBatchSize = 64;
+    uint32_t nonces[nBatchSize];
+    uint256 hashes[nBatchSize];
+
+    CX16R hasher(pblock->hashPrevBlock.begin());
+    hasher.SetHeaderPrefix((const unsigned char*)&pblock->nVersion);
+    while (nMaxTries > 0 && pblock->nNonce < nInnerLoopCount) {
+        size_t nCount = std::min<uint64_t>(std::min<uint64_t>(nBatchSize, nMaxTries), nInnerLoopCount - pblock->nNonce);
+        for (size_t i = 0; i < nCount; i++)
+            nonces[i] = pblock->nNonce + i;
+        hasher.HashNonces(nonces, nCount, hashes[0].begin());
+        for (size_t i = 0; i < nCount; i++) {
+            if (CheckProofOfWork(hashes[i], pblock->nBits, Params().GetConsensus())) {
+                pblock->nNonce = nonces[i];
+                nMaxTries -= i;
+                return;
+            }
+        }
+        pblock->nNonce += nCount;
+        nMaxTries -= nCount;
+    }
+}
+
 UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGenerate, uint64_t nMaxTries, bool keepScript)
 {
     static const int nInnerLoopCount = 0x10000;
@@ -129,9 +160,13 @@ UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGen
             LOCK(cs_main);
             IncrementExtraNonce(pblock, chainActive.Tip(), nExtraNonce);
         }
-        while (nMaxTries > 0 && pblock->nNonce < nInnerLoopCount && !CheckProofOfWork(pblock->GetPoWHash(nHeight+1), pblock->nBits, Params().GetConsensus())) {
-            ++pblock->nNonce;
-            --nMaxTries;
+        if (nHeight + 1 >= X16R_ACTIVATION_HEIGHT) {
+            GrindX16RNonce(pblock, nInnerLoopCount, nMaxTries);
+        } else {
+            while (nMaxTries > 0 && pblock->nNonce < nInnerLoopCount && !CheckProofOfWork(pblock->GetPoWHash(nHeight+1), pblock->nBits, Params().GetConsensus())) {
+                ++pblock->nNonce;
+                --nMaxTries;
+            }
         }
         if (nMaxTries == 0) {
             break;
@@ -16,6 +16,7 @@
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
+#include <streams.h>
 #include <timedata.h>
 #include <util.h>
 #include <utilstrencodings.h>
@@ -854,6 +855,125 @@ bool timestampSort(std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+/** Number of results per page if a cursor is given without a limit */
+static const int DEFAULT_ADDRESS_PAGE_SIZE = 1000;
+/** Largest page the address RPCs return */
+static const int MAX_ADDRESS_PAGE_SIZE = 50000;
+
+/** Page size the request asks for, or 0 if it wants all results at once */
+static size_t getAddressPageSize(const UniValue& params)
+{
+    if (!params[0].isObject())
+        return 0;
+
+    UniValue limitValue = find_value(params[0].get_obj(), "limit");
+    UniValue cursorValue = find_value(params[0].get_obj(), "cursor");
+    if (limitValue.isNull() && cursorValue.isNull())
+        return 0;
+
+    int limit = limitValue.isNull() ? DEFAULT_ADDRESS_PAGE_SIZE : limitValue.get_int();
+    if (limit < 1 || limit > MAX_ADDRESS_PAGE_SIZE) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Limit is expected to be between 1 and %d", MAX_ADDRESS_PAGE_SIZE));
+    }
+    return limit;
+}
+
+/**
+ * Cursors are the hex encoded position of the address in the request,
+ * followed by the index key the next page starts at.
+ */
+template <typename Key>
+static std::string encodeAddressCursor(uint32_t nAddress, const Key& key)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << nAddress << key;
+    return HexStr(ss.begin(), ss.end());
+}
+
+template <typename Key>
+static bool decodeAddressCursor(const UniValue& params, const std::vector<std::pair<uint256, int> > &addresses, uint32_t& nAddress, Key& key)
+{
+    UniValue cursorValue = find_value(params[0].get_obj(), "cursor");
+    if (cursorValue.isNull())
+        return false;
+    if (!cursorValue.isStr() || !IsHex(cursorValue.get_str())) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+
+    std::vector<unsigned char> data(ParseHex(cursorValue.get_str()));
+    CDataStream ss(data, SER_DISK, CLIENT_VERSION);
+    try {
+        ss >> nAddress >> key;
+    } catch (const std::exception&) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+
+    // a cursor only continues the request it was returned for
+    if (!ss.empty() || nAddress >= addresses.size() ||
+        key.hashBytes != addresses[nAddress].first || (int)key.type != addresses[nAddress].second) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+    return true;
+}
+
+/**
+ * Read a page of the address index entries of at most limit transactions, counting a transaction once
+ * for each address it involves, address after address in the order of the request and in index order for each address. Returns the cursor of the next page, or null after the last one.
+ */
+static UniValue getAddressIndexPage(const UniValue& params, const std::vector<std::pair<uint256, int> > &addresses,
+                                    size_t limit, int start, int end,
+                                    std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex)
+{
+    uint32_t nAddress = 0;
+    CAddressIndexKey keyStart;
+    bool fStart = decodeAddressCursor(params, addresses, nAddress, keyStart);
+
+    size_t nTxs = 0;
+    for (; nAddress < addresses.size(); nAddress++) {
+        bool fMore;
+        CAddressIndexKey keyNext;
+        size_t nFirst = addressIndex.size();
+        if (!GetAddressIndexPage(addresses[nAddress].first, addresses[nAddress].second, fStart ? &keyStart : nullptr,
+                                 limit - nTxs, addressIndex, fMore, keyNext, start, end)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        // the entries of a transaction are next to each other
+        for (size_t i = nFirst; i < addressIndex.size(); i++) {
+            if (i == nFirst || addressIndex[i].first.txhash != addressIndex[i - 1].first.txhash)
+                nTxs++;
+        }
+        if (fMore) {
+            return encodeAddressCursor(nAddress, keyNext);
+        }
+        fStart = false;
+    }
+
+    return NullUniValue;
+}
+
+static UniValue getAddressUnspentPage(const UniValue& params, const std::vector<std::pair<uint256, int> > &addresses,
+                                      size_t limit, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
+{
+    uint32_t nAddress = 0;
+    CAddressUnspentKey keyStart;
+    bool fStart = decodeAddressCursor(params, addresses, nAddress, keyStart);
+
+    for (; nAddress < addresses.size(); nAddress++) {
+        bool fMore;
+        CAddressUnspentKey keyNext;
+        if (!GetAddressUnspentPage(addresses[nAddress].first, addresses[nAddress].second, fStart ? &keyStart : nullptr,
+                                   limit - unspentOutputs.size(), unspentOutputs, fMore, keyNext)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        if (fMore) {
+            return encodeAddressCursor(nAddress, keyNext);
+        }
+        fStart = false;
+    }
+
+    return NullUniValue;
+}
+
 UniValue getaddressmempool(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -937,6 +1057,8 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
                         "      \"address\"  (string) The base58check encoded address\n"
                         "      ,...\n"
                         "    ]\n"
+                        "  \"limit\" (number, optional) Return a page of at most this many unspent outputs, at most " + std::to_string(MAX_ADDRESS_PAGE_SIZE) + "\n"
+                        "  \"cursor\" (string, optional) Continue from the cursor returned with the previous page\n"
                         "}\n"
                         "\nResult\n"
                         "[\n"
@@ -949,8 +1071,14 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
                         "    \"height\"  (number) The block height\n"
                         "  }\n"
                         "]\n"
+                        "\nResult with limit or cursor, unsorted in index order, address after address:\n"
+                        "{\n"
+                        "  \"utxos\"  (array) The unspent outputs as above\n"
+                        "  \"cursor\"  (string) The cursor of the next page, null after the last page\n"
+                        "}\n"
                         "\nExamples:\n"
                 + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"NwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+                + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"NwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 100}'")
                 + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"NwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -962,13 +1090,19 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
 
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
 
-    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    size_t limit = getAddressPageSize(request.params);
+    UniValue cursor;
+    if (limit > 0) {
+        cursor = getAddressUnspentPage(request.params, addresses, limit, unspentOutputs);
+    } else {
+        for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
         }
-    }
 
-    std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+        std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    }
 
     UniValue result(UniValue::VARR);
 
@@ -988,6 +1122,13 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         result.push_back(output);
     }
 
+    if (limit > 0) {
+        UniValue page(UniValue::VOBJ);
+        page.push_back(Pair("utxos", result));
+        page.push_back(Pair("cursor", cursor));
+        return page;
+    }
+
     return result;
 }
 
@@ -1006,6 +1147,9 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
                         "    ]\n"
                         "  \"start\" (number) The start block height\n"
                         "  \"end\" (number) The end block height\n"
+                        "  \"limit\" (number, optional) Return a page with all deltas of at most this many transactions,\n"
+                        "                     counting a transaction once for each address, at most " + std::to_string(MAX_ADDRESS_PAGE_SIZE) + "\n"
+                        "  \"cursor\" (string, optional) Continue from the cursor returned with the previous page\n"
                         "}\n"
                         "\nResult:\n"
                         "[\n"
@@ -1018,6 +1162,11 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
                         "    \"address\"  (string) The base58check encoded address\n"
                         "  }\n"
                         "]\n"
+                        "\nResult with limit or cursor, in index order, address after address:\n"
+                        "{\n"
+                        "  \"deltas\"  (array) The changes as above\n"
+                        "  \"cursor\"  (string) The cursor of the next page, null after the last page\n"
+                        "}\n"
                         "\nExamples:\n"
                 + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"NwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
                 + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"NwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
@@ -1046,14 +1195,24 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
 
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
-    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+    size_t limit = getAddressPageSize(request.params);
+    UniValue cursor;
+    if (limit > 0) {
         if (start > 0 && end > 0) {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
+            cursor = getAddressIndexPage(request.params, addresses, limit, start, end, addressIndex);
         } else {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            cursor = getAddressIndexPage(request.params, addresses, limit, 0, 0, addressIndex);
+        }
+    } else {
+        for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            if (start > 0 && end > 0) {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
+            } else {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
             }
         }
     }
@@ -1076,6 +1235,13 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         result.push_back(delta);
     }
 
+    if (limit > 0) {
+        UniValue page(UniValue::VOBJ);
+        page.push_back(Pair("deltas", result));
+        page.push_back(Pair("cursor", cursor));
+        return page;
+    }
+
     return result;
 }
 
@@ -1109,22 +1275,16 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
-    }
-
     CAmount balance = 0;
     CAmount received = 0;
 
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
+    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+        CAddressBalanceValue value;
+        if (!GetAddressBalance((*it).first, (*it).second, value)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
-        balance += it->second;
+        balance += value.balance;
+        received += value.received;
     }
 
     UniValue result(UniValue::VOBJ);
@@ -1150,12 +1310,19 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
                         "    ]\n"
                         "  \"start\" (number) The start block height\n"
                         "  \"end\" (number) The end block height\n"
+                        "  \"limit\" (number, optional) Return a page of at most this many txids, at most " + std::to_string(MAX_ADDRESS_PAGE_SIZE) + "\n"
+                        "  \"cursor\" (string, optional) Continue from the cursor returned with the previous page\n"
                         "}\n"
                         "\nResult:\n"
                         "[\n"
                         "  \"transactionid\"  (string) The transaction id\n"
                         "  ,...\n"
                         "]\n"
+                        "\nResult with limit or cursor, in index order, address after address:\n"
+                        "{\n"
+                        "  \"txids\"  (array) The transaction ids, a transaction involving several of the addresses is listed for each\n"
+                        "  \"cursor\"  (string) The cursor of the next page, null after the last page\n"
+                        "}\n"
                         "\nExamples:\n"
                 + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
                 + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
@@ -1180,18 +1347,45 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
 
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
-    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+    size_t limit = getAddressPageSize(request.params);
+    UniValue cursor;
+    if (limit > 0) {
         if (start > 0 && end > 0) {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
+            cursor = getAddressIndexPage(request.params, addresses, limit, start, end, addressIndex);
         } else {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            cursor = getAddressIndexPage(request.params, addresses, limit, 0, 0, addressIndex);
+        }
+    } else {
+        for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            if (start > 0 && end > 0) {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
+            } else {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
             }
         }
     }
 
+    if (limit > 0) {
+        // entries of a transaction are next to each other and never split across pages
+        UniValue txids(UniValue::VARR);
+        for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
+            if (it != addressIndex.begin() && it->first.txhash == (it - 1)->first.txhash &&
+                it->first.hashBytes == (it - 1)->first.hashBytes && it->first.type == (it - 1)->first.type) {
+                continue;
+            }
+            txids.push_back(it->first.txhash.GetHex());
+        }
+
+        UniValue page(UniValue::VOBJ);
+        page.push_back(Pair("txids", txids));
+        page.push_back(Pair("cursor", cursor));
+        return page;
+    }
+
     std::set<std::pair<int, std::string> > txids;
     UniValue result(UniValue::VARR);
 
@@ -8,6 +8,7 @@
 #include "consensus/validation.h"
 #include "darksend.h"
 #include "init.h"
+#include "random.h"
 #include "instantx.h"
 #include "subinode-payments.h"
 #include "subinode-sync.h"
@@ -2354,13 +2355,35 @@ bool CDarkSendSigner::SignMessage(std::string strMessage, std::vector<unsigned c
     return key.SignCompact(ss.GetHash(), vchSigRet);
 }
 
-bool CDarkSendSigner::VerifyMessage(CPubKey pubkey, const std::vector<unsigned char> &vchSig, std::string strMessage, std::string &strErrorRet) {
+void CDarkSendSigner::InitSignatureCache()
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+    GetRandBytes(nonce.begin(), 32);
+    nCacheElements = setValid.setup_bytes(SUBINODE_SIG_CACHE_BYTES);
+    LogPrintf("Using %zu MiB for subinode signature cache, able to store %zu elements\n",
+            (nCacheElements*sizeof(uint256)) >> 20, nCacheElements);
+}
+
+bool CDarkSendSigner::VerifyMessage(CPubKey pubkey, const std::vector<unsigned char> &vchSig, std::string strMessage, std::string &strErrorRet, bool fWarmCache) {
     CHashWriter ss(SER_GETHASH, 0);
     ss << strMessageMagic;
     ss << strMessage;
+    uint256 hashMessage = ss.GetHash();
+
+    // the same broadcasts, pings and votes are checked again on updates and recovery replies
+    uint256 entry;
+    CSHA256().Write(nonce.begin(), 32).Write(hashMessage.begin(), 32).Write(pubkey.begin(), pubkey.size()).Write(vchSig.data(), vchSig.size()).Finalize(entry.begin());
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+        if (nCacheElements > 0 && setValid.contains(entry, false)) {
+            if (!fWarmCache) nCacheHits++;
+            return true;
+        }
+    }
+    if (!fWarmCache) nCacheMisses++;
 
     CPubKey pubkeyFromSig;
-    if (!pubkeyFromSig.RecoverCompact(ss.GetHash(), vchSig)) {
+    if (!pubkeyFromSig.RecoverCompact(hashMessage, vchSig)) {
         strErrorRet = "Error recovering public key.";
         return false;
     }
@@ -2372,9 +2395,17 @@ bool CDarkSendSigner::VerifyMessage(CPubKey pubkey, const std::vector<unsigned c
         return false;
     }
 
+    boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+    if (nCacheElements > 0) setValid.insert(entry);
     return true;
 }
 
+void CDarkSendSigner::GetCacheStats(size_t& nElementsRet, uint64_t& nHitsRet, uint64_t& nMissesRet) {
+    nElementsRet = nCacheElements;
+    nHitsRet = nCacheHits;
+    nMissesRet = nCacheMisses;
+}
+
 bool CDarkSendEntry::AddScriptSig(const CTxIn &txin) {
     BOOST_FOREACH(CTxDSIn & txdsin, vecTxDSIn)
     {
@@ -6,9 +6,15 @@
 #ifndef DARKSEND_H
 #define DARKSEND_H
 
+#include "cuckoocache.h"
 #include "subinode.h"
+#include "script/sigcache.h"
 #include "wallet/wallet.h"
+
+#include <atomic>
+
 #include <boost/foreach.hpp>
+#include <boost/thread/shared_mutex.hpp>
 
 class CDarksendPool;
 class CDarkSendSigner;
@@ -38,6 +44,9 @@ static const int PRIVATESEND_KEYS_THRESHOLD_WARNING = 100;
 // Stop mixing completely, it's too dangerous to continue when we have only this many keys left
 static const int PRIVATESEND_KEYS_THRESHOLD_STOP    = 50;
 
+// Memory for the cache of valid subinode and InstantSend message signatures
+static const size_t SUBINODE_SIG_CACHE_BYTES        = 4 << 20;
+
 // The main object for accessing mixing
 extern CDarksendPool darkSendPool;
 // A helper object for signing messages from Subinodes
@@ -240,15 +249,30 @@ public:
  */
 class CDarkSendSigner
 {
+private:
+    //! Entries are SHA256(nonce || message hash || public key || signature) of valid signatures
+    uint256 nonce;
+    CuckooCache::cache<uint256, SignatureCacheHasher> setValid;
+    boost::shared_mutex cs_sigcache;
+    size_t nCacheElements;
+    std::atomic<uint64_t> nCacheHits;
+    std::atomic<uint64_t> nCacheMisses;
+
 public:
+    CDarkSendSigner() : nCacheElements(0), nCacheHits(0), nCacheMisses(0) {}
+
+    /// Set up the valid signature cache, signatures are not cached before
+    void InitSignatureCache();
     /// Is the input associated with this public key? (and there is 10000 SUBI - checking if valid subinode)
     bool IsVinAssociatedWithPubkey(const CTxIn& vin, const CPubKey& pubkey);
     /// Set the private/public key values, returns true if successful
     bool GetKeysFromSecret(std::string strSecret, CKey& keyRet, CPubKey& pubkeyRet);
     /// Sign the message, returns true if successful
     bool SignMessage(std::string strMessage, std::vector<unsigned char>& vchSigRet, CKey key);
-    /// Verify the message, returns true if succcessful
-    bool VerifyMessage(CPubKey pubkey, const std::vector<unsigned char>& vchSig, std::string strMessage, std::string& strErrorRet);
+    /// Verify the message, returns true if succcessful. Warming the cache ahead of the processing is left out of its stats
+    bool VerifyMessage(CPubKey pubkey, const std::vector<unsigned char>& vchSig, std::string strMessage, std::string& strErrorRet, bool fWarmCache = false);
+    /// Number of signatures the valid signature cache can hold, and how often VerifyMessage found one there
+    void GetCacheStats(size_t& nElementsRet, uint64_t& nHitsRet, uint64_t& nMissesRet);
 };
 
 
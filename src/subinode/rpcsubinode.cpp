@@ -116,7 +116,7 @@ UniValue subinode(const JSONRPCRequest& req) {
          strCommand != "start-disabled" && strCommand != "list" && strCommand != "list-conf" && strCommand != "count" &&
          strCommand != "debug" && strCommand != "current" && strCommand != "winner" && strCommand != "winners" &&
          strCommand != "genkey" &&
-         strCommand != "connect" && strCommand != "outputs" && strCommand != "status"))
+         strCommand != "connect" && strCommand != "outputs" && strCommand != "status" && strCommand != "sigcache"))
         throw std::runtime_error(
                 "subinode \"command\"...\n"
                         "Set of commands to execute subinode related actions\n"
@@ -131,6 +131,7 @@ UniValue subinode(const JSONRPCRequest& req) {
                         "  start        - Start local Hot subinode configured in dash.conf\n"
                         "  start-alias  - Start single remote subinode by assigned alias configured in subinode.conf\n"
                         "  start-<mode> - Start remote subinodes configured in subinode.conf (<mode>: 'all', 'missing', 'disabled')\n"
+                        "  sigcache     - Print subinode and InstantSend message signature cache statistics\n"
                         "  status       - Print subinode status information\n"
                         "  list         - Print list of all known subinodes (see subinodelist for more info)\n"
                         "  list-conf    - Print subinode.conf in JSON format\n"
@@ -188,8 +189,7 @@ UniValue subinode(const JSONRPCRequest& req) {
             if (strMode == "enabled")
                 return mnodeman.CountEnabled();
 
-            int nCount;
-            mnodeman.GetNextSubinodeInQueueForPayment(true, nCount);
+            int nCount = mnodeman.CountQualifiedForPayment();
 
             if (strMode == "qualify")
                 return nCount;
@@ -200,6 +200,18 @@ UniValue subinode(const JSONRPCRequest& req) {
                                  mnodeman.CountEnabled(), nCount);
         }
 
+        if (strCommand == "sigcache") {
+            size_t nElements;
+            uint64_t nHits, nMisses;
+            darkSendSigner.GetCacheStats(nElements, nHits, nMisses);
+
+            UniValue obj(UniValue::VOBJ);
+            obj.push_back(Pair("maxelements", (uint64_t)nElements));
+            obj.push_back(Pair("hits", nHits));
+            obj.push_back(Pair("misses", nMisses));
+            return obj;
+        }
+
         if (strCommand == "current" || strCommand == "winner") {
             int nCount;
             int nHeight;
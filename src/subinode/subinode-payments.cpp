@@ -6,6 +6,7 @@
 #include "activesubinode.h"
 #include "darksend.h"
 #include "subinode-payments.h"
+#include "subinode-sigqueue.h"
 #include "subinode-sync.h"
 #include "subinodeman.h"
 #include "netfulfilledman.h"
@@ -242,75 +243,100 @@ void CSubinodePayments::ProcessMessage(CNode *pfrom, std::string &strCommand, CD
                 //LogPrintf("mnpayments SUBINODEPAYMENTVOTE -- nHeight=%d seen\n", pCurrentBlockIndex->nHeight);
                 return;
             }
-
-            // Avoid processing same vote multiple times
-            mapSubinodePaymentVotes[nHash] = vote;
-            // but first mark vote as non-verified,
-            // AddPaymentVote() below should take care of it if vote is actually ok
-            mapSubinodePaymentVotes[nHash].MarkAsNotVerified();
         }
 
-        int nFirstBlock = pCurrentBlockIndex->nHeight - GetStorageLimit();
-        if (vote.nBlockHeight < nFirstBlock || vote.nBlockHeight > pCurrentBlockIndex->nHeight + 20) {
-            //LogPrintf("mnpaymentsSUBINODEPAYMENTVOTE -- vote out of range: nFirstBlock=%d, nBlockHeight=%d, nHeight=%d\n", nFirstBlock, vote.nBlockHeight, pCurrentBlockIndex->nHeight);
-            return;
-        }
+        std::vector<CSubinodeSigQueue::sig_t> vecSigs;
+        subinode_info_t mnInfo = mnodeman.GetSubinodeInfo(vote.vinSubinode);
+        if (mnInfo.fInfoValid)
+            vecSigs.push_back(CSubinodeSigQueue::sig_t(mnInfo.pubKeySubinode, vote.GetSignatureMessage(), vote.vchSig));
+        subinodeSigQueue.Push(pfrom, nHash, vecSigs, [this, vote](CNode* pnode) { ProcessPaymentVote(pnode, vote); });
+    }
+}
 
-        std::string strError = "";
-        if (!vote.IsValid(pfrom, pCurrentBlockIndex->nHeight, strError)) {
-            //LogPrintf("mnpayments SUBINODEPAYMENTVOTE -- invalid message, error: %s\n", strError);
-            return;
-        }
+void CSubinodePayments::ProcessPaymentVote(CNode* pfrom, CSubinodePaymentVote vote)
+{
+    if (!pCurrentBlockIndex) return;
 
-        if (!CanVote(vote.vinSubinode.prevout, vote.nBlockHeight)) {
-            //LogPrintf("SUBINODEPAYMENTVOTE -- subinode already voted, subinode\n");
-            return;
-        }
+    uint256 nHash = vote.GetHash();
 
-        subinode_info_t mnInfo = mnodeman.GetSubinodeInfo(vote.vinSubinode);
-        if (!mnInfo.fInfoValid) {
-            // mn was not found, so we can't check vote, some info is probably missing
-            //LogPrintf("SUBINODEPAYMENTVOTE -- subinode is missing \n");
-            mnodeman.AskForMN(pfrom, vote.vinSubinode);
+    {
+        LOCK(cs_mapSubinodePaymentVotes);
+        if (mapSubinodePaymentVotes.count(nHash)) {
+            //LogPrintf("mnpayments SUBINODEPAYMENTVOTE -- nHeight=%d seen\n", pCurrentBlockIndex->nHeight);
             return;
         }
 
-        int nDos = 0;
-        if (!vote.CheckSignature(mnInfo.pubKeySubinode, pCurrentBlockIndex->nHeight, nDos)) {
-            if (nDos) {
-                //LogPrintf("SUBINODEPAYMENTVOTE -- ERROR: invalid signature\n");
-                Misbehaving(pfrom->GetId(), nDos);
-            } else {
-                // only warn about anything non-critical (i.e. nDos == 0) in debug mode
-                //LogPrintf("mnpayments SUBINODEPAYMENTVOTE -- WARNING: invalid signature\n");
-            }
-            // Either our info or vote info could be outdated.
-            // In case our info is outdated, ask for an update,
-            mnodeman.AskForMN(pfrom, vote.vinSubinode);
-            // but there is nothing we can do if vote info itself is outdated
-            // (i.e. it was signed by a mn which changed its key),
-            // so just quit here.
-            return;
-        }
+        // Avoid processing same vote multiple times
+        mapSubinodePaymentVotes[nHash] = vote;
+        // but first mark vote as non-verified,
+        // AddPaymentVote() below should take care of it if vote is actually ok
+        mapSubinodePaymentVotes[nHash].MarkAsNotVerified();
+    }
 
-        CTxDestination address1;
-        ExtractDestination(vote.payee, address1);
-        CBitcoinAddress address2(address1);
+    int nFirstBlock = pCurrentBlockIndex->nHeight - GetStorageLimit();
+    if (vote.nBlockHeight < nFirstBlock || vote.nBlockHeight > pCurrentBlockIndex->nHeight + 20) {
+        //LogPrintf("mnpaymentsSUBINODEPAYMENTVOTE -- vote out of range: nFirstBlock=%d, nBlockHeight=%d, nHeight=%d\n", nFirstBlock, vote.nBlockHeight, pCurrentBlockIndex->nHeight);
+        return;
+    }
+
+    std::string strError = "";
+    if (!vote.IsValid(pfrom, pCurrentBlockIndex->nHeight, strError)) {
+        //LogPrintf("mnpayments SUBINODEPAYMENTVOTE -- invalid message, error: %s\n", strError);
+        return;
+    }
 
-        //LogPrintf("mnpayments SUBINODEPAYMENTVOTE -- vote: address=%s, nBlockHeight=%d, nHeight=%d, prevout=%s\n", address2.ToString(), vote.nBlockHeight, pCurrentBlockIndex->nHeight, vote.vinSubinode.prevout.ToStringShort());
+    if (!CanVote(vote.vinSubinode.prevout, vote.nBlockHeight)) {
+        //LogPrintf("SUBINODEPAYMENTVOTE -- subinode already voted, subinode\n");
+        return;
+    }
 
-        if (AddPaymentVote(vote)) {
-            vote.Relay();
-            subinodeSync.AddedPaymentVote();
+    subinode_info_t mnInfo = mnodeman.GetSubinodeInfo(vote.vinSubinode);
+    if (!mnInfo.fInfoValid) {
+        // mn was not found, so we can't check vote, some info is probably missing
+        //LogPrintf("SUBINODEPAYMENTVOTE -- subinode is missing \n");
+        mnodeman.AskForMN(pfrom, vote.vinSubinode);
+        return;
+    }
+
+    int nDos = 0;
+    if (!vote.CheckSignature(mnInfo.pubKeySubinode, pCurrentBlockIndex->nHeight, nDos)) {
+        if (nDos) {
+            //LogPrintf("SUBINODEPAYMENTVOTE -- ERROR: invalid signature\n");
+            Misbehaving(pfrom->GetId(), nDos);
+        } else {
+            // only warn about anything non-critical (i.e. nDos == 0) in debug mode
+            //LogPrintf("mnpayments SUBINODEPAYMENTVOTE -- WARNING: invalid signature\n");
         }
+        // Either our info or vote info could be outdated.
+        // In case our info is outdated, ask for an update,
+        mnodeman.AskForMN(pfrom, vote.vinSubinode);
+        // but there is nothing we can do if vote info itself is outdated
+        // (i.e. it was signed by a mn which changed its key),
+        // so just quit here.
+        return;
+    }
+
+    CTxDestination address1;
+    ExtractDestination(vote.payee, address1);
+    CBitcoinAddress address2(address1);
+
+    //LogPrintf("mnpayments SUBINODEPAYMENTVOTE -- vote: address=%s, nBlockHeight=%d, nHeight=%d, prevout=%s\n", address2.ToString(), vote.nBlockHeight, pCurrentBlockIndex->nHeight, vote.vinSubinode.prevout.ToStringShort());
+
+    if (AddPaymentVote(vote)) {
+        vote.Relay();
+        subinodeSync.AddedPaymentVote();
     }
 }
 
+std::string CSubinodePaymentVote::GetSignatureMessage() const {
+    return vinSubinode.prevout.ToStringShort() +
+           boost::lexical_cast<std::string>(nBlockHeight) +
+           ScriptToAsmStr(payee);
+}
+
 bool CSubinodePaymentVote::Sign() {
     std::string strError;
-    std::string strMessage = vinSubinode.prevout.ToStringShort() +
-                             boost::lexical_cast<std::string>(nBlockHeight) +
-                             ScriptToAsmStr(payee);
+    std::string strMessage = GetSignatureMessage();
 
     if (!darkSendSigner.SignMessage(strMessage, vchSig, activeSubinode.keySubinode)) {
         //LogPrint("CSubinodePaymentVote::Sign -- SignMessage() failed\n");
@@ -336,22 +362,29 @@ bool CSubinodePayments::GetBlockPayee(int nBlockHeight, CScript &payee) {
 // Is this subinode scheduled to get paid soon?
 // -- Only look ahead up to 8 blocks to allow for propagation of the latest 2 blocks of votes
 bool CSubinodePayments::IsScheduled(CSubinode &mn, int nNotBlockHeight) {
-    LOCK(cs_mapSubinodeBlocks);
-
-    if (!pCurrentBlockIndex) return false;
+    std::vector<CScript> vecPayees;
+    GetScheduledPayees(nNotBlockHeight, vecPayees);
 
     CScript mnpayee;
     mnpayee = GetScriptForDestination(mn.pubKeyCollateralAddress.GetID());
 
+    return std::find(vecPayees.begin(), vecPayees.end(), mnpayee) != vecPayees.end();
+}
+
+void CSubinodePayments::GetScheduledPayees(int nNotBlockHeight, std::vector<CScript>& vecPayeesRet) {
+    LOCK(cs_mapSubinodeBlocks);
+
+    vecPayeesRet.clear();
+    if (!pCurrentBlockIndex) return;
+
     CScript payee;
     for (int64_t h = pCurrentBlockIndex->nHeight; h <= pCurrentBlockIndex->nHeight + 8; h++) {
         if (h == nNotBlockHeight) continue;
-        if (mapSubinodeBlocks.count(h) && mapSubinodeBlocks[h].GetBestPayee(payee) && mnpayee == payee) {
-            return true;
+        std::map<int, CSubinodeBlockPayees>::iterator it = mapSubinodeBlocks.find(h);
+        if (it != mapSubinodeBlocks.end() && it->second.GetBestPayee(payee)) {
+            vecPayeesRet.push_back(payee);
         }
     }
-
-    return false;
 }
 
 bool CSubinodePayments::AddPaymentVote(const CSubinodePaymentVote &vote) {
@@ -680,9 +713,7 @@ bool CSubinodePaymentVote::CheckSignature(const CPubKey &pubKeySubinode, int nVa
     // do not ban by default
     nDos = 0;
 
-    std::string strMessage = vinSubinode.prevout.ToStringShort() +
-                             boost::lexical_cast<std::string>(nBlockHeight) +
-                             ScriptToAsmStr(payee);
+    std::string strMessage = GetSignatureMessage();
 
     std::string strError = "";
     if (!darkSendSigner.VerifyMessage(pubKeySubinode, vchSig, strMessage, strError)) {
@@ -149,6 +149,8 @@ public:
         return ss.GetHash();
     }
 
+    /// The string the subinode key signs
+    std::string GetSignatureMessage() const;
     bool Sign();
     bool CheckSignature(const CPubKey& pubKeySubinode, int nValidationHeight, int &nDos);
 
@@ -205,11 +207,15 @@ public:
     bool GetBlockPayee(int nBlockHeight, CScript& payee);
     bool IsTransactionValid(const CTransaction& txNew, int nBlockHeight);
     bool IsScheduled(CSubinode& mn, int nNotBlockHeight);
+    /// Best payees of the blocks up to 8 ahead of the current one, except for nNotBlockHeight
+    void GetScheduledPayees(int nNotBlockHeight, std::vector<CScript>& vecPayeesRet);
 
     bool CanVote(COutPoint outSubinode, int nBlockHeight);
 
     int GetMinSubinodePaymentsProto();
     void ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+    /// Process a payment vote once subinodeSigQueue checked its signature
+    void ProcessPaymentVote(CNode* pfrom, CSubinodePaymentVote vote);
     std::string GetRequiredPaymentsString(int nBlockHeight);
     void FillBlockPayee(CMutableTransaction& txNew, int nBlockHeight, CAmount blockReward, CTxOut& txoutSubinodeRet);
     std::string ToString() const;
@@ -0,0 +1,127 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "darksend.h"
+#include "subinode-sigqueue.h"
+#include "util.h"
+
+CSubinodeSigQueue subinodeSigQueue;
+
+void CSubinodeSigQueue::Thread()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        nWorkers++;
+    }
+
+    while (true) {
+        std::shared_ptr<job_t> job;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (queueWork.empty()) {
+                condWorker.wait(lock); // interruption point
+            }
+            job = queueWork.front();
+            queueWork.pop_front();
+        }
+
+        // only warms the signature cache, the processing checks the signatures again
+        BOOST_FOREACH(const sig_t& sig, job->vecSigs) {
+            std::string strError;
+            darkSendSigner.VerifyMessage(sig.pubkey, sig.vchSig, sig.strMessage, strError, true);
+        }
+
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            job->fDone = true;
+        }
+        if (g_connman) g_connman->WakeMessageHandler();
+    }
+}
+
+void CSubinodeSigQueue::Push(CNode* pfrom, const uint256& hash, const std::vector<sig_t>& vecSigs, std::function<void(CNode*)> fnProcess)
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        std::shared_ptr<job_t> job = std::make_shared<job_t>();
+        job->hash = hash;
+        job->fnProcess = fnProcess;
+        job->fDone = false;
+
+        std::map<uint256, std::shared_ptr<job_t> >::iterator mi = mapQueued.find(hash);
+        if (mi != mapQueued.end()) {
+            // checked for another peer already, the processing finds the message seen or the signatures cached
+            job->pending = mi->second;
+            mapNodeJobs[pfrom->GetId()].push_back(job);
+            return;
+        }
+
+        if (nWorkers > 0 && queueWork.size() < MAX_QUEUED_MESSAGES) {
+            job->vecSigs = vecSigs;
+            mapQueued.insert(std::make_pair(hash, job));
+            queueWork.push_back(job);
+            mapNodeJobs[pfrom->GetId()].push_back(job);
+            condWorker.notify_one();
+            return;
+        }
+
+        if (mapNodeJobs.count(pfrom->GetId())) {
+            // no worker to spare, but the earlier messages from this peer still go first
+            job->fDone = true;
+            mapNodeJobs[pfrom->GetId()].push_back(job);
+            return;
+        }
+    }
+
+    fnProcess(pfrom);
+}
+
+void CSubinodeSigQueue::EraseQueued(const std::shared_ptr<job_t>& job)
+{
+    // follow-up jobs of other peers keep the job itself alive
+    std::map<uint256, std::shared_ptr<job_t> >::iterator mi = mapQueued.find(job->hash);
+    if (mi != mapQueued.end() && mi->second == job)
+        mapQueued.erase(mi);
+}
+
+void CSubinodeSigQueue::ProcessReady(CNode* pfrom)
+{
+    std::vector<std::shared_ptr<job_t> > vecReady;
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        std::map<NodeId, std::deque<std::shared_ptr<job_t> > >::iterator it = mapNodeJobs.find(pfrom->GetId());
+        if (it == mapNodeJobs.end()) return;
+
+        // keep the order the peer sent the messages in, e.g. a ping after the broadcast it belongs to
+        std::deque<std::shared_ptr<job_t> >& jobs = it->second;
+        while (!jobs.empty() && jobs.front()->IsReady()) {
+            EraseQueued(jobs.front());
+            vecReady.push_back(jobs.front());
+            jobs.pop_front();
+        }
+        if (jobs.empty()) mapNodeJobs.erase(it);
+    }
+
+    BOOST_FOREACH(const std::shared_ptr<job_t>& job, vecReady) {
+        job->fnProcess(pfrom);
+    }
+}
+
+void CSubinodeSigQueue::ForgetNode(NodeId nodeid)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    std::map<NodeId, std::deque<std::shared_ptr<job_t> > >::iterator it = mapNodeJobs.find(nodeid);
+    if (it == mapNodeJobs.end()) return;
+
+    BOOST_FOREACH(const std::shared_ptr<job_t>& job, it->second) {
+        EraseQueued(job);
+    }
+    mapNodeJobs.erase(it);
+}
+
+void ThreadSubinodeSigCheck()
+{
+    RenameThread("subi-mnsig");
+    subinodeSigQueue.Thread();
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef SUBINODE_SIGQUEUE_H
+#define SUBINODE_SIGQUEUE_H
+
+#include "net.h"
+#include "pubkey.h"
+#include "uint256.h"
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+class CSubinodeSigQueue;
+
+extern CSubinodeSigQueue subinodeSigQueue;
+
+//! maximum number of threads checking subinode message signatures
+static const int MAX_SUBINODE_SIG_THREADS = 4;
+
+/**
+ * Checks the signatures of subinode broadcasts, pings and payment votes on worker threads,
+ * so bursts of them (e.g. during list sync) do not stall the message handler on ECDSA.
+ *
+ * A message handler drops messages it has seen, then pushes the signatures of a new one
+ * together with the rest of its processing. The workers put the valid signatures into the
+ * CDarkSendSigner cache, and the processing then runs on the message handler thread in the
+ * order the peer sent the messages, with its signature checks hitting the cache.
+ */
+class CSubinodeSigQueue
+{
+public:
+    //! signed string, its signature and the key expected to have signed it
+    struct sig_t {
+        CPubKey pubkey;
+        std::string strMessage;
+        std::vector<unsigned char> vchSig;
+
+        sig_t(const CPubKey& pubkeyIn, const std::string& strMessageIn, const std::vector<unsigned char>& vchSigIn) :
+            pubkey(pubkeyIn), strMessage(strMessageIn), vchSig(vchSigIn) {}
+    };
+
+private:
+    //! maximum number of messages waiting for a worker, further ones are checked right away
+    static const size_t MAX_QUEUED_MESSAGES = 10000;
+
+    struct job_t {
+        uint256 hash;
+        std::vector<sig_t> vecSigs;
+        std::function<void(CNode*)> fnProcess;
+        bool fDone;
+        // the queued job of another peer with the same message, whose signatures this one waits for
+        std::shared_ptr<job_t> pending;
+
+        bool IsReady() const { return fDone || (pending && pending->fDone); }
+    };
+
+    boost::mutex mutex;
+    boost::condition_variable condWorker;
+    // messages waiting for a worker
+    std::deque<std::shared_ptr<job_t> > queueWork;
+    // messages by the peer they came from, in the order they came
+    std::map<NodeId, std::deque<std::shared_ptr<job_t> > > mapNodeJobs;
+    // jobs checking the signatures of a message, by its hash
+    std::map<uint256, std::shared_ptr<job_t> > mapQueued;
+    int nWorkers;
+
+    //! Stop deduplicating against this job, with mutex held
+    void EraseQueued(const std::shared_ptr<job_t>& job);
+
+public:
+    CSubinodeSigQueue() : nWorkers(0) {}
+
+    /// Worker thread loop
+    void Thread();
+
+    /**
+     * Check the signatures in vecSigs in the background, then run fnProcess on the message
+     * handler thread after the earlier messages from this peer. If the message with this hash
+     * is queued already, fnProcess waits for its signatures instead. Without workers, or with
+     * the queue full, the signatures are left to fnProcess.
+     */
+    void Push(CNode* pfrom, const uint256& hash, const std::vector<sig_t>& vecSigs, std::function<void(CNode*)> fnProcess);
+
+    /// Run the processing of the messages from this peer whose signatures are checked
+    void ProcessReady(CNode* pfrom);
+
+    /// Drop the messages from a disconnected peer
+    void ForgetNode(NodeId nodeid);
+};
+
+/** Run an instance of the subinode message signature checking thread */
+void ThreadSubinodeSigCheck();
+
+#endif
@@ -146,6 +146,7 @@ void CSubinodeSync::Reset() {
     nTimeLastGovernanceItem = GetTime();
     nTimeLastFailure = 0;
     nCountFailures = 0;
+    fReceivedSubinodeList = false;
 }
 
 std::string CSubinodeSync::GetAssetName() {
@@ -179,6 +180,7 @@ void CSubinodeSync::SwitchToNextAsset() {
             break;
         case (SUBINODE_SYNC_SPORKS):
             nTimeLastSubinodeList = GetTime();
+            fReceivedSubinodeList = false;
             nRequestedSubinodeAssets = SUBINODE_SYNC_LIST;
             //LogPrint("CSubinodeSync::SwitchToNextAsset -- Starting %s\n", GetAssetName());
             break;
@@ -340,6 +342,14 @@ void CSubinodeSync::ProcessTick() {
             // MNLIST : SYNC SUBINODE LIST FROM OTHER CONNECTED CLIENTS
 
             if (nRequestedSubinodeAssets == SUBINODE_SYNC_LIST) {
+                // a peer sent us the whole list at once, no need to ask others or wait for the timeout
+                if (fReceivedSubinodeList) {
+                    //LogPrint("CSubinodeSync::ProcessTick -- nTick %d nRequestedSubinodeAssets %d -- received the list\n", nTick, nRequestedSubinodeAssets);
+                    SwitchToNextAsset();
+                    g_connman->ReleaseNodeVector(vNodesCopy);
+                    return;
+                }
+
                 // check for timeout first
                 if (nTimeLastSubinodeList < GetTime() - SUBINODE_SYNC_TIMEOUT_SECONDS) {
                     //LogPrint("CSubinodeSync::ProcessTick -- nTick %d nRequestedSubinodeAssets %d -- timeout\n", nTick, nRequestedSubinodeAssets);
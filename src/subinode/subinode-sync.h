@@ -52,6 +52,9 @@ private:
     // How many times we failed
     int nCountFailures;
 
+    // Whether a peer sent us its whole subinode list in this list sync
+    bool fReceivedSubinodeList;
+
     // Keep track of current block index
     const CBlockIndex *pCurrentBlockIndex;
 
@@ -63,6 +66,7 @@ public:
     CSubinodeSync() { Reset(); }
 
     void AddedSubinodeList() { nTimeLastSubinodeList = GetTime(); }
+    void ReceivedSubinodeList() { nTimeLastSubinodeList = GetTime(); fReceivedSubinodeList = true; }
     void AddedPaymentVote() { nTimeLastPaymentVote = GetTime(); }
     void AddedGovernanceItem() { nTimeLastGovernanceItem = GetTime(); }
 
@@ -111,7 +111,10 @@ bool CSubinode::UpdateFromNewBroadcast(CSubinodeBroadcast &mnb) {
     pubKeySubinode = mnb.pubKeySubinode;
     sigTime = mnb.sigTime;
     vchSig = mnb.vchSig;
-    nProtocolVersion = mnb.nProtocolVersion;
+    if (nProtocolVersion != mnb.nProtocolVersion) {
+        nProtocolVersion = mnb.nProtocolVersion;
+        mnodeman.InvalidateRankCache();
+    }
     addr = mnb.addr;
     nPoSeBanScore = 0;
     nPoSeBanHeight = 0;
@@ -160,6 +163,15 @@ arith_uint256 CSubinode::CalculateScore(const uint256 &blockHash) {
 void CSubinode::Check(bool fForce) {
     LOCK(cs);
 
+    int nActiveStateOld = nActiveState;
+    CheckState(fForce);
+    if (nActiveState != nActiveStateOld) {
+        // subinode rankings only include nodes in some states
+        mnodeman.InvalidateRankCache();
+    }
+}
+
+void CSubinode::CheckState(bool fForce) {
     if (ShutdownRequested()) return;
 
     if (!fForce && (GetTime() - nTimeLastChecked < SUBINODE_CHECK_SECONDS)) return;
@@ -719,15 +731,19 @@ bool CSubinodeBroadcast::CheckOutpoint(int &nDos) {
     return true;
 }
 
+std::string CSubinodeBroadcast::GetSignatureMessage() const {
+    return addr.ToString() + boost::lexical_cast<std::string>(sigTime) +
+           pubKeyCollateralAddress.GetID().ToString() + pubKeySubinode.GetID().ToString() +
+           boost::lexical_cast<std::string>(nProtocolVersion);
+}
+
 bool CSubinodeBroadcast::Sign(CKey &keyCollateralAddress) {
     std::string strError;
     std::string strMessage;
 
     sigTime = GetAdjustedTime();
 
-    strMessage = addr.ToString() + boost::lexical_cast<std::string>(sigTime) +
-                 pubKeyCollateralAddress.GetID().ToString() + pubKeySubinode.GetID().ToString() +
-                 boost::lexical_cast<std::string>(nProtocolVersion);
+    strMessage = GetSignatureMessage();
 
     if (!darkSendSigner.SignMessage(strMessage, vchSig, keyCollateralAddress)) {
         //LogPrint("CSubinodeBroadcast::Sign -- SignMessage() failed\n");
@@ -747,9 +763,7 @@ bool CSubinodeBroadcast::CheckSignature(int &nDos) {
     std::string strError = "";
     nDos = 0;
 
-    strMessage = addr.ToString() + boost::lexical_cast<std::string>(sigTime) +
-                 pubKeyCollateralAddress.GetID().ToString() + pubKeySubinode.GetID().ToString() +
-                 boost::lexical_cast<std::string>(nProtocolVersion);
+    strMessage = GetSignatureMessage();
 
     //LogPrint("subinode", "CSubinodeBroadcast::CheckSignature -- strMessage: %s  pubKeyCollateralAddress address: %s  sig: %s\n", strMessage, CBitcoinAddress(pubKeyCollateralAddress.GetID()).ToString(), EncodeBase64(&vchSig[0], vchSig.size()));
 
@@ -778,12 +792,16 @@ CSubinodePing::CSubinodePing(CTxIn &vinNew) {
     vchSig = std::vector < unsigned char > ();
 }
 
+std::string CSubinodePing::GetSignatureMessage() const {
+    return vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+}
+
 bool CSubinodePing::Sign(CKey &keySubinode, CPubKey &pubKeySubinode) {
     std::string strError;
     std::string strSubiNodeSignMessage;
 
     sigTime = GetAdjustedTime();
-    std::string strMessage = vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+    std::string strMessage = GetSignatureMessage();
 
     if (!darkSendSigner.SignMessage(strMessage, vchSig, keySubinode)) {
         //LogPrint("CSubinodePing::Sign -- SignMessage() failed\n");
@@ -799,7 +817,7 @@ bool CSubinodePing::Sign(CKey &keySubinode, CPubKey &pubKeySubinode) {
 }
 
 bool CSubinodePing::CheckSignature(CPubKey &pubKeySubinode, int &nDos) {
-    std::string strMessage = vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+    std::string strMessage = GetSignatureMessage();
     std::string strError = "";
     nDos = 0;
 
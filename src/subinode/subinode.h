@@ -81,6 +81,8 @@ public:
 
     bool IsExpired() { return GetTime() - sigTime > SUBINODE_NEW_START_REQUIRED_SECONDS; }
 
+    /// The string the subinode key signs
+    std::string GetSignatureMessage() const;
     bool Sign(CKey& keySubinode, CPubKey& pubKeySubinode);
     bool CheckSignature(CPubKey& pubKeySubinode, int &nDos);
     bool SimpleCheck(int& nDos);
@@ -146,6 +148,8 @@ private:
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
 
+    void CheckState(bool fForce);
+
 public:
     enum state {
         SUBINODE_PRE_ENABLED,
@@ -373,6 +377,8 @@ public:
     bool Update(CSubinode* pmn, int& nDos);
     bool CheckOutpoint(int& nDos);
 
+    /// The string the collateral key signs
+    std::string GetSignatureMessage() const;
     bool Sign(CKey& keyCollateralAddress);
     bool CheckSignature(int& nDos);
     void RelaySubiNode();
@@ -7,6 +7,7 @@
 #include "addrman.h"
 #include "darksend.h"
 #include "subinode-payments.h"
+#include "subinode-sigqueue.h"
 #include "subinode-sync.h"
 #include "subinodeman.h"
 #include "netfulfilledman.h"
@@ -18,14 +19,38 @@ CSubinodeMan mnodeman;
 
 const std::string CSubinodeMan::SERIALIZATION_VERSION_STRING = "CSubinodeMan-Version-4";
 
-struct CompareLastPaidBlock
+SaltedKeyIDHasher::SaltedKeyIDHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+/** Remove the entry of pmn under key from one of the multimap indexes */
+static void EraseSubinodeIndexEntry(std::unordered_multimap<CKeyID, CSubinode*, SaltedKeyIDHasher>& mapIndex, const CKeyID& key, const CSubinode* pmn)
 {
-    bool operator()(const std::pair<int, CSubinode*>& t1,
-                    const std::pair<int, CSubinode*>& t2) const
-    {
-        return (t1.first != t2.first) ? (t1.first < t2.first) : (t1.second->vin < t2.second->vin);
+    auto range = mapIndex.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == pmn) {
+            mapIndex.erase(it);
+            return;
+        }
     }
-};
+}
+
+/** Block at nBlockHeight of the active chain (-1 for the tip), the rankings for a height are seeded by its hash */
+static const CBlockIndex* GetRankingBlockIndex(int nBlockHeight)
+{
+    LOCK(cs_main);
+    if (chainActive.Tip() == NULL) return NULL;
+    if (nBlockHeight < -1 || nBlockHeight > chainActive.Height()) return NULL;
+    return nBlockHeight == -1 ? chainActive.Tip() : chainActive[nBlockHeight];
+}
+
+/** Collateral key id a payee script pays to, payees are always pay-to-pubkey-hash scripts of a collateral key */
+static bool GetPayeeKeyID(const CScript& payee, CKeyID& keyIDRet)
+{
+    CTxDestination dest;
+    if (!ExtractDestination(payee, dest) || !boost::get<CKeyID>(&dest))
+        return false;
+    keyIDRet = boost::get<CKeyID>(dest);
+    return GetScriptForDestination(keyIDRet) == payee;
+}
 
 struct CompareScoreMN
 {
@@ -98,10 +123,21 @@ void CSubinodeIndex::RebuildIndex()
 }
 
 CSubinodeMan::CSubinodeMan() : cs(),
-  vSubinodes(),
+  listSubinodes(),
+  mapSubinodesByOutpoint(),
+  mapSubinodesByPubKey(),
+  mapSubinodesByPayee(),
+  mapScoreCache(),
+  mapRankCache(),
+  nRankCacheVersion(0),
+  mapEnabledCounts(),
+  nEnabledCountVersion(0),
+  nListVersion(0),
   mAskedUsForSubinodeList(),
   mWeAskedForSubinodeList(),
   mWeAskedForSubinodeListEntry(),
+  listSentSnapshots(),
+  hashLastReceivedList(),
   mWeAskedForVerification(),
   mMnbRecoveryRequests(),
   mMnbRecoveryGoodReplies(),
@@ -126,7 +162,9 @@ bool CSubinodeMan::Add(CSubinode &mn)
     CSubinode *pmn = Find(mn.vin);
     if (pmn == NULL) {
         //LogPrint("subinode", "CSubinodeMan::Add -- Adding new Subinode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
-        vSubinodes.push_back(mn);
+        listSubinodes.push_back(mn);
+        IndexSubinode(&listSubinodes.back());
+        InvalidateRankCache();
         indexSubinodes.AddSubinodeVIN(mn.vin);
         fSubinodesAdded = true;
         return true;
@@ -171,7 +209,7 @@ void CSubinodeMan::Check()
 
 //    //LogPrint("subinode", "CSubinodeMan::Check -- nLastWatchdogVoteTime=%d, IsWatchdogActive()=%d\n", nLastWatchdogVoteTime, IsWatchdogActive());
 
-    BOOST_FOREACH(CSubinode& mn, vSubinodes) {
+    BOOST_FOREACH(CSubinode& mn, listSubinodes) {
         mn.Check();
     }
 }
@@ -190,11 +228,11 @@ void CSubinodeMan::CheckAndRemove()
         Check();
 
         // Remove spent subinodes, prepare structures and make requests to reasure the state of inactive ones
-        std::vector<CSubinode>::iterator it = vSubinodes.begin();
+        std::list<CSubinode>::iterator it = listSubinodes.begin();
         std::vector<std::pair<int, CSubinode> > vecSubinodeRanks;
         // ask for up to MNB_RECOVERY_MAX_ASK_ENTRIES subinode entries at a time
         int nAskForMnbRecovery = MNB_RECOVERY_MAX_ASK_ENTRIES;
-        while(it != vSubinodes.end()) {
+        while(it != listSubinodes.end()) {
             CSubinodeBroadcast mnb = CSubinodeBroadcast(*it);
             uint256 hash = mnb.GetHash();
             // If collateral was spent ...
@@ -207,7 +245,11 @@ void CSubinodeMan::CheckAndRemove()
 
                 // and finally remove it from the list
 //                it->FlagGovernanceItemsAsDirty();
-                it = vSubinodes.erase(it);
+                UnindexSubinode(&(*it));
+                it = listSubinodes.erase(it);
+                InvalidateRankCache();
+                // peers would not send the removed subinodes again as changes since their list
+                hashLastReceivedList.SetNull();
                 fSubinodesRemoved = true;
             } else {
                 bool fAsk = pCurrentBlockIndex &&
@@ -367,10 +409,20 @@ void CSubinodeMan::CheckAndRemove()
 void CSubinodeMan::Clear()
 {
     LOCK(cs);
-    vSubinodes.clear();
+    listSubinodes.clear();
+    mapSubinodesByOutpoint.clear();
+    mapSubinodesByPubKey.clear();
+    mapSubinodesByPayee.clear();
+    setPaymentQueue.clear();
+    mapScoreCache.clear();
+    mapRankCache.clear();
+    InvalidateRankCache();
     mAskedUsForSubinodeList.clear();
     mWeAskedForSubinodeList.clear();
     mWeAskedForSubinodeListEntry.clear();
+    listSentSnapshots.clear();
+    hashLastReceivedList.SetNull();
+    setIncompleteLists.clear();
     mapSeenSubinodeBroadcast.clear();
     mapSeenSubinodePing.clear();
     nDsqCount = 0;
@@ -385,7 +437,7 @@ int CSubinodeMan::CountSubinodes(int nProtocolVersion)
     int nCount = 0;
     nProtocolVersion = nProtocolVersion == -1 ? mnpayments.GetMinSubinodePaymentsProto() : nProtocolVersion;
 
-    BOOST_FOREACH(CSubinode& mn, vSubinodes) {
+    BOOST_FOREACH(CSubinode& mn, listSubinodes) {
         if(mn.nProtocolVersion < nProtocolVersion) continue;
         nCount++;
     }
@@ -396,14 +448,24 @@ int CSubinodeMan::CountSubinodes(int nProtocolVersion)
 int CSubinodeMan::CountEnabled(int nProtocolVersion)
 {
     LOCK(cs);
-    int nCount = 0;
     nProtocolVersion = nProtocolVersion == -1 ? mnpayments.GetMinSubinodePaymentsProto() : nProtocolVersion;
 
-    BOOST_FOREACH(CSubinode& mn, vSubinodes) {
+    // the count only changes with the list and the states and protocol versions tracked by nListVersion
+    int64_t nVersion = nListVersion;
+    if(nEnabledCountVersion != nVersion) {
+        mapEnabledCounts.clear();
+        nEnabledCountVersion = nVersion;
+    }
+    std::map<int, int>::iterator it = mapEnabledCounts.find(nProtocolVersion);
+    if(it != mapEnabledCounts.end()) return it->second;
+
+    int nCount = 0;
+    BOOST_FOREACH(CSubinode& mn, listSubinodes) {
         if(mn.nProtocolVersion < nProtocolVersion || !mn.IsEnabled()) continue;
         nCount++;
     }
 
+    mapEnabledCounts[nProtocolVersion] = nCount;
     return nCount;
 }
 
@@ -413,7 +475,7 @@ int CSubinodeMan::CountByIP(int nNetworkType)
     LOCK(cs);
     int nNodeCount = 0;
 
-    BOOST_FOREACH(CSubinode& mn, vSubinodes)
+    BOOST_FOREACH(CSubinode& mn, listSubinodes)
         if ((nNetworkType == NET_IPV4 && mn.addr.IsIPv4()) ||
             (nNetworkType == NET_TOR  && mn.addr.IsTor())  ||
             (nNetworkType == NET_IPV6 && mn.addr.IsIPv6())) {
@@ -439,45 +501,186 @@ void CSubinodeMan::DsegUpdate(CNode* pnode)
     }
     
     const CNetMsgMaker msgMaker(pnode->GetSendVersion());
-    g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::DSEG, CTxIn()));
+    if (pnode->nVersion >= MNLIST_VERSION) {
+        g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::MNLISTGET, hashLastReceivedList));
+    } else {
+        g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::DSEG, CTxIn()));
+    }
     int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
     mWeAskedForSubinodeList[pnode->addr] = askAgain;
 
     //LogPrint("subinode", "CSubinodeMan::DsegUpdate -- asked %s for the list\n", pnode->addr.ToString());
 }
 
-CSubinode* CSubinodeMan::Find(const CScript &payee)
+void CSubinodeMan::SendSubinodeList(CNode* pnode, const uint256& hashKnownList)
 {
     LOCK(cs);
 
-    BOOST_FOREACH(CSubinode& mn, vSubinodes)
-    {
-        if(GetScriptForDestination(mn.pubKeyCollateralAddress.GetID()) == payee)
-            return &mn;
+    std::map<COutPoint, uint256> mapEntries;
+    std::vector<CSubinodeBroadcast> vecMnb;
+    BOOST_FOREACH(CSubinode& mn, listSubinodes) {
+        if (mn.addr.IsRFC1918() || mn.addr.IsLocal()) continue; // do not send local network subinode
+        if (mn.IsUpdateRequired()) continue; // do not send outdated subinodes
+
+        CSubinodeBroadcast mnb = CSubinodeBroadcast(mn);
+        CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+        ss << mnb.GetHash() << mn.lastPing.GetHash();
+        mapEntries[mn.vin.prevout] = ss.GetHash();
+        vecMnb.push_back(mnb);
+    }
+    uint256 hashList = SerializeHash(mapEntries);
+
+    // only send what changed if the peer has a list we sent recently
+    std::vector<CSubinodeBroadcast> vecSend;
+    std::deque<std::pair<uint256, std::map<COutPoint, uint256> > >::const_iterator itKnown = listSentSnapshots.begin();
+    while (itKnown != listSentSnapshots.end() && itKnown->first != hashKnownList) ++itKnown;
+    if (itKnown == listSentSnapshots.end()) {
+        vecSend.swap(vecMnb);
+    } else {
+        BOOST_FOREACH(const CSubinodeBroadcast& mnb, vecMnb) {
+            std::map<COutPoint, uint256>::const_iterator it = itKnown->second.find(mnb.vin.prevout);
+            if (it == itKnown->second.end() || it->second != mapEntries[mnb.vin.prevout])
+                vecSend.push_back(mnb);
+        }
     }
-    return NULL;
+
+    if (listSentSnapshots.empty() || listSentSnapshots.front().first != hashList) {
+        listSentSnapshots.push_front(std::make_pair(hashList, mapEntries));
+        if (listSentSnapshots.size() > MAX_SENT_LIST_SNAPSHOTS)
+            listSentSnapshots.pop_back();
+    }
+
+    const CNetMsgMaker msgMaker(pnode->GetSendVersion());
+    size_t nSent = 0;
+    do {
+        size_t nCount = std::min(vecSend.size() - nSent, (size_t)MNLIST_MAX_ENTRIES);
+        std::vector<CSubinodeBroadcast> vecPart(vecSend.begin() + nSent, vecSend.begin() + nSent + nCount);
+        nSent += nCount;
+        g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::MNLIST, hashList, vecPart, nSent == vecSend.size()));
+    } while (nSent < vecSend.size());
+
+    //LogPrint("subinode", "CSubinodeMan::SendSubinodeList -- sent %d of %d subinodes to peer %d\n", vecSend.size(), mapEntries.size(), pnode->GetId());
+}
+
+void CSubinodeMan::IndexSubinode(CSubinode* pmn)
+{
+    mapSubinodesByOutpoint[pmn->vin.prevout] = pmn;
+    mapSubinodesByPubKey.emplace(pmn->pubKeySubinode.GetID(), pmn);
+    mapSubinodesByPayee.emplace(pmn->pubKeyCollateralAddress.GetID(), pmn);
+    setPaymentQueue.insert(std::make_pair(pmn->GetLastPaidBlock(), pmn));
+}
+
+void CSubinodeMan::UnindexSubinode(CSubinode* pmn)
+{
+    mapSubinodesByOutpoint.erase(pmn->vin.prevout);
+    EraseSubinodeIndexEntry(mapSubinodesByPubKey, pmn->pubKeySubinode.GetID(), pmn);
+    EraseSubinodeIndexEntry(mapSubinodesByPayee, pmn->pubKeyCollateralAddress.GetID(), pmn);
+    setPaymentQueue.erase(std::make_pair(pmn->GetLastPaidBlock(), pmn));
+}
+
+void CSubinodeMan::ReindexSubinodePubKey(CSubinode* pmn, const CPubKey& pubKeyOld)
+{
+    if(pmn->pubKeySubinode == pubKeyOld) return;
+    EraseSubinodeIndexEntry(mapSubinodesByPubKey, pubKeyOld.GetID(), pmn);
+    mapSubinodesByPubKey.emplace(pmn->pubKeySubinode.GetID(), pmn);
+}
+
+void CSubinodeMan::RebuildSubinodeIndexes()
+{
+    mapSubinodesByOutpoint.clear();
+    mapSubinodesByPubKey.clear();
+    mapSubinodesByPayee.clear();
+    setPaymentQueue.clear();
+    BOOST_FOREACH(CSubinode& mn, listSubinodes) {
+        IndexSubinode(&mn);
+    }
+    InvalidateRankCache();
+}
+
+CSubinodeMan::score_cache_t& CSubinodeMan::GetScoreCache(const CBlockIndex* pindex)
+{
+    std::map<const CBlockIndex*, score_cache_t>::iterator it = mapScoreCache.find(pindex);
+    if(it == mapScoreCache.end()) {
+        if(mapScoreCache.size() >= MAX_RANK_CACHE_BLOCKS) mapScoreCache.clear();
+        it = mapScoreCache.insert(std::make_pair(pindex, score_cache_t())).first;
+        it->second.blockHash = pindex->GetBlockPoWHash();
+    }
+    return it->second;
+}
+
+const CSubinodeMan::rank_cache_t& CSubinodeMan::GetRankedSubinodes(const CBlockIndex* pindex, int nBlockHeight, int nMinProtocol, rank_filter_t filter)
+{
+    int64_t nVersion = nListVersion;
+    if(nRankCacheVersion != nVersion) {
+        mapRankCache.clear();
+        nRankCacheVersion = nVersion;
+    }
+
+    // keyed by height rather than block, a reorg or a new tip for height -1 replaces the entry
+    std::tuple<int, int, int> key = std::make_tuple(nBlockHeight, nMinProtocol, (int)filter);
+    std::map<std::tuple<int, int, int>, rank_cache_t>::iterator it = mapRankCache.find(key);
+    if(it != mapRankCache.end() && it->second.pindex == pindex) return it->second;
+
+    if(it == mapRankCache.end()) {
+        if(mapRankCache.size() >= MAX_RANK_CACHE_BLOCKS) mapRankCache.clear();
+        it = mapRankCache.insert(std::make_pair(key, rank_cache_t())).first;
+    }
+
+    score_cache_t& scores = GetScoreCache(pindex);
+    std::vector<std::pair<int64_t, CSubinode*> > vecSubinodeScores;
+    BOOST_FOREACH(CSubinode& mn, listSubinodes) {
+        if(mn.nProtocolVersion < nMinProtocol) continue;
+        if(filter == RANK_FILTER_ENABLED && !mn.IsEnabled()) continue;
+        if(filter == RANK_FILTER_VALID_FOR_PAYMENT && !mn.IsValidForPayment()) continue;
+
+        int64_t nScore = scores.GetScore(mn).GetCompact(false);
+
+        vecSubinodeScores.push_back(std::make_pair(nScore, &mn));
+    }
+
+    sort(vecSubinodeScores.rbegin(), vecSubinodeScores.rend(), CompareScoreMN());
+
+    rank_cache_t& ranks = it->second;
+    ranks.pindex = pindex;
+    ranks.vecRanked.clear();
+    ranks.mapRanks.clear();
+    ranks.vecRanked.reserve(vecSubinodeScores.size());
+    BOOST_FOREACH (PAIRTYPE(int64_t, CSubinode*)& s, vecSubinodeScores) {
+        ranks.vecRanked.push_back(s.second);
+        ranks.mapRanks.emplace(s.second->vin.prevout, (int)ranks.vecRanked.size());
+    }
+    return ranks;
+}
+
+CSubinode* CSubinodeMan::Find(const CScript &payee)
+{
+    LOCK(cs);
+
+    CKeyID keyID;
+    if(!GetPayeeKeyID(payee, keyID))
+        return NULL;
+
+    auto it = mapSubinodesByPayee.find(keyID);
+    return it == mapSubinodesByPayee.end() ? NULL : it->second;
 }
 
 CSubinode* CSubinodeMan::Find(const CTxIn &vin)
 {
     LOCK(cs);
 
-    BOOST_FOREACH(CSubinode& mn, vSubinodes)
-    {
-        if(mn.vin.prevout == vin.prevout)
-            return &mn;
-    }
-    return NULL;
+    auto it = mapSubinodesByOutpoint.find(vin.prevout);
+    return it == mapSubinodesByOutpoint.end() ? NULL : it->second;
 }
 
 CSubinode* CSubinodeMan::Find(const CPubKey &pubKeySubinode)
 {
     LOCK(cs);
 
-    BOOST_FOREACH(CSubinode& mn, vSubinodes)
-    {
-        if(mn.pubKeySubinode == pubKeySubinode)
-            return &mn;
+    // the index is by key id, compare the full key to rule out a collision
+    auto range = mapSubinodesByPubKey.equal_range(pubKeySubinode.GetID());
+    for(auto it = range.first; it != range.second; ++it) {
+        if(it->second->pubKeySubinode == pubKeySubinode)
+            return it->second;
     }
     return NULL;
 }
@@ -591,35 +794,74 @@ CSubinode* CSubinodeMan::GetNextSubinodeInQueueForPayment(bool fFilterSigTime, i
     return GetNextSubinodeInQueueForPayment(pCurrentBlockIndex->nHeight, fFilterSigTime, nCount);
 }
 
+int CSubinodeMan::WalkPaymentQueue(int nBlockHeight, bool fFilterSigTime, int nMnCount, int nCandidates, int nMinQualified, std::vector<CSubinode*>& vecCandidatesRet)
+{
+    // subinodes scheduled to be paid in the next 8 blocks, see CSubinodePayments::IsScheduled
+    std::set<const CSubinode*> setScheduled;
+    std::vector<CScript> vecScheduledPayees;
+    mnpayments.GetScheduledPayees(nBlockHeight, vecScheduledPayees);
+    BOOST_FOREACH(const CScript& payee, vecScheduledPayees) {
+        CKeyID keyID;
+        if(!GetPayeeKeyID(payee, keyID)) continue;
+        auto range = mapSubinodesByPayee.equal_range(keyID);
+        for(auto it = range.first; it != range.second; ++it) {
+            setScheduled.insert(it->second);
+        }
+    }
+
+    // the same checks as GetNotQualifyReason
+    int nCount = 0;
+    BOOST_FOREACH(const PAIRTYPE(int, CSubinode*)& item, setPaymentQueue) {
+        CSubinode& mn = *item.second;
+        if(!mn.IsValidForPayment()) continue;
+        if(mn.nProtocolVersion < mnpayments.GetMinSubinodePaymentsProto()) continue;
+        if(setScheduled.count(&mn)) continue;
+        if(fFilterSigTime && mn.sigTime + (nMnCount * 2.6 * 60) > GetAdjustedTime()) continue;
+        if(mn.GetCollateralAge() < nMnCount) continue;
+
+        nCount++;
+        if((int)vecCandidatesRet.size() < nCandidates) {
+            vecCandidatesRet.push_back(&mn);
+        }
+        if((int)vecCandidatesRet.size() >= nCandidates && nCount >= nMinQualified) break;
+    }
+    return nCount;
+}
+
+int CSubinodeMan::CountQualifiedForPayment()
+{
+    // Need LOCK2 here to ensure consistent locking order because GetCollateralAge locks cs_main
+    LOCK2(cs_main,cs);
+
+    if(!pCurrentBlockIndex) return 0;
+
+    int nMnCount = CountEnabled();
+    std::vector<CSubinode*> vecCandidates;
+    int nCount = WalkPaymentQueue(pCurrentBlockIndex->nHeight, true, nMnCount, 0, std::numeric_limits<int>::max(), vecCandidates);
+    if(nCount < nMnCount / 3) {
+        nCount = WalkPaymentQueue(pCurrentBlockIndex->nHeight, false, nMnCount, 0, std::numeric_limits<int>::max(), vecCandidates);
+    }
+    return nCount;
+}
+
 CSubinode* CSubinodeMan::GetNextSubinodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCount)
 {
     // Need LOCK2 here to ensure consistent locking order because the GetBlockHash call below locks cs_main
     LOCK2(cs_main,cs);
 
     CSubinode *pBestSubinode = NULL;
-    std::vector<std::pair<int, CSubinode*> > vecSubinodeLastPaid;
 
     /*
-        Make a vector with all of the last paid times
+        Take the least recently paid qualified subinodes from the payment queue
     */
-    //LogPrintf("\nSubinode InQueueForPayment \n");
+    // Look at 1/10 of the oldest nodes (by last payment), calculate their scores and pay the best one
+    //  -- This doesn't look at who is being paid in the +8-10 blocks, allowing for double payments very rarely
+    //  -- 1/100 payments should be a double payment on mainnet - (1/(3000/10))*2
+    //  -- (chance per block * chances before IsScheduled will fire)
     int nMnCount = CountEnabled();
-    int index = 0;
-    BOOST_FOREACH(CSubinode &mn, vSubinodes)
-    {
-        index += 1;
-
-        char* reasonStr = GetNotQualifyReason(mn, nBlockHeight, fFilterSigTime, nMnCount);
-        if (reasonStr != NULL) {
-            //LogPrint("subinodeman", "Subinode, %s, addr(%s), qualify %s\n",
-                     //mn.vin.prevout.ToStringShort(), CBitcoinAddress(mn.pubKeyCollateralAddress.GetID()).ToString(), reasonStr);
-            delete [] reasonStr;
-            continue;
-        }
-        //LogPrintf("\nNODE Last Paid\n");
-        vecSubinodeLastPaid.push_back(std::make_pair(mn.GetLastPaidBlock(), &mn));
-    }
-    nCount = (int)vecSubinodeLastPaid.size();
+    int nTenthNetwork = std::max(nMnCount/10, 1);
+    std::vector<CSubinode*> vecSubinodeLastPaid;
+    nCount = WalkPaymentQueue(nBlockHeight, fFilterSigTime, nMnCount, nTenthNetwork, fFilterSigTime ? nMnCount / 3 : 0, vecSubinodeLastPaid);
 
     //when the network is in the process of upgrading, don't penalize nodes that recently restarted
     if(fFilterSigTime && nCount < nMnCount / 3) {
@@ -627,29 +869,19 @@ CSubinode* CSubinodeMan::GetNextSubinodeInQueueForPayment(int nBlockHeight, bool
         return GetNextSubinodeInQueueForPayment(nBlockHeight, false, nCount);
     }
 
-    // Sort them low to high
-    sort(vecSubinodeLastPaid.begin(), vecSubinodeLastPaid.end(), CompareLastPaidBlock());
-
-    uint256 blockHash;
-    if(!GetBlockHash(blockHash, nBlockHeight - 100)) {
+    const CBlockIndex* pindex = GetRankingBlockIndex(nBlockHeight - 100);
+    if(!pindex) {
         LogPrintf("CSubinode::GetNextSubinodeInQueueForPayment -- ERROR: GetBlockHash() failed at nBlockHeight %d\n", (nBlockHeight - 100));
         return NULL;
     }
-    // Look at 1/10 of the oldest nodes (by last payment), calculate their scores and pay the best one
-    //  -- This doesn't look at who is being paid in the +8-10 blocks, allowing for double payments very rarely
-    //  -- 1/100 payments should be a double payment on mainnet - (1/(3000/10))*2
-    //  -- (chance per block * chances before IsScheduled will fire)
-    int nTenthNetwork = nMnCount/10;
-    int nCountTenth = 0;
+    score_cache_t& scores = GetScoreCache(pindex);
     arith_uint256 nHighest = 0;
-    BOOST_FOREACH (PAIRTYPE(int, CSubinode*)& s, vecSubinodeLastPaid){
-        arith_uint256 nScore = s.second->CalculateScore(blockHash);
+    BOOST_FOREACH (CSubinode* pmn, vecSubinodeLastPaid){
+        arith_uint256 nScore = scores.GetScore(*pmn);
         if(nScore > nHighest){
             nHighest = nScore;
-            pBestSubinode = s.second;
+            pBestSubinode = pmn;
         }
-        nCountTenth++;
-        if(nCountTenth >= nTenthNetwork) break;
     }
     return pBestSubinode;
 }
@@ -668,7 +900,7 @@ CSubinode* CSubinodeMan::FindRandomNotInVec(const std::vector<CTxIn> &vecToExclu
 
     // fill a vector of pointers
     std::vector<CSubinode*> vpSubinodesShuffled;
-    BOOST_FOREACH(CSubinode &mn, vSubinodes) {
+    BOOST_FOREACH(CSubinode &mn, listSubinodes) {
         vpSubinodesShuffled.push_back(&mn);
     }
 
@@ -699,66 +931,34 @@ CSubinode* CSubinodeMan::FindRandomNotInVec(const std::vector<CTxIn> &vecToExclu
 
 int CSubinodeMan::GetSubinodeRank(const CTxIn& vin, int nBlockHeight, int nMinProtocol, bool fOnlyActive)
 {
-    std::vector<std::pair<int64_t, CSubinode*> > vecSubinodeScores;
-
     //make sure we know about this block
-    uint256 blockHash = uint256();
-    if(!GetBlockHash(blockHash, nBlockHeight)) return -1;
+    const CBlockIndex* pindex = GetRankingBlockIndex(nBlockHeight);
+    if(!pindex) return -1;
 
     LOCK(cs);
 
-    // scan for winner
-    BOOST_FOREACH(CSubinode& mn, vSubinodes) {
-        if(mn.nProtocolVersion < nMinProtocol) continue;
-        if(fOnlyActive) {
-            if(!mn.IsEnabled()) continue;
-        }
-        else {
-            if(!mn.IsValidForPayment()) continue;
-        }
-        int64_t nScore = mn.CalculateScore(blockHash).GetCompact(false);
-
-        vecSubinodeScores.push_back(std::make_pair(nScore, &mn));
-    }
-
-    sort(vecSubinodeScores.rbegin(), vecSubinodeScores.rend(), CompareScoreMN());
-
-    int nRank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CSubinode*)& scorePair, vecSubinodeScores) {
-        nRank++;
-        if(scorePair.second->vin.prevout == vin.prevout) return nRank;
-    }
-
-    return -1;
+    const rank_cache_t& ranks = GetRankedSubinodes(pindex, nBlockHeight, nMinProtocol,
+                                                   fOnlyActive ? RANK_FILTER_ENABLED : RANK_FILTER_VALID_FOR_PAYMENT);
+    std::unordered_map<COutPoint, int, SaltedOutpointHasher>::const_iterator it = ranks.mapRanks.find(vin.prevout);
+    return it == ranks.mapRanks.end() ? -1 : it->second;
 }
 
 std::vector<std::pair<int, CSubinode> > CSubinodeMan::GetSubinodeRanks(int nBlockHeight, int nMinProtocol)
 {
-    std::vector<std::pair<int64_t, CSubinode*> > vecSubinodeScores;
     std::vector<std::pair<int, CSubinode> > vecSubinodeRanks;
 
     //make sure we know about this block
-    uint256 blockHash = uint256();
-    if(!GetBlockHash(blockHash, nBlockHeight)) return vecSubinodeRanks;
+    const CBlockIndex* pindex = GetRankingBlockIndex(nBlockHeight);
+    if(!pindex) return vecSubinodeRanks;
 
     LOCK(cs);
 
-    // scan for winner
-    BOOST_FOREACH(CSubinode& mn, vSubinodes) {
-
-        if(mn.nProtocolVersion < nMinProtocol || !mn.IsEnabled()) continue;
-
-        int64_t nScore = mn.CalculateScore(blockHash).GetCompact(false);
-
-        vecSubinodeScores.push_back(std::make_pair(nScore, &mn));
-    }
-
-    sort(vecSubinodeScores.rbegin(), vecSubinodeScores.rend(), CompareScoreMN());
-
+    const rank_cache_t& ranks = GetRankedSubinodes(pindex, nBlockHeight, nMinProtocol, RANK_FILTER_ENABLED);
+    vecSubinodeRanks.reserve(ranks.vecRanked.size());
     int nRank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CSubinode*)& s, vecSubinodeScores) {
+    BOOST_FOREACH (CSubinode* pmn, ranks.vecRanked) {
         nRank++;
-        vecSubinodeRanks.push_back(std::make_pair(nRank, *s.second));
+        vecSubinodeRanks.push_back(std::make_pair(nRank, *pmn));
     }
 
     return vecSubinodeRanks;
@@ -766,38 +966,19 @@ std::vector<std::pair<int, CSubinode> > CSubinodeMan::GetSubinodeRanks(int nBloc
 
 CSubinode* CSubinodeMan::GetSubinodeByRank(int nRank, int nBlockHeight, int nMinProtocol, bool fOnlyActive)
 {
-    std::vector<std::pair<int64_t, CSubinode*> > vecSubinodeScores;
-
-    LOCK(cs);
-
-    uint256 blockHash;
-    if(!GetBlockHash(blockHash, nBlockHeight)) {
+    const CBlockIndex* pindex = GetRankingBlockIndex(nBlockHeight);
+    if(!pindex) {
         //LogPrint("CSubinode::GetSubinodeByRank -- ERROR: GetBlockHash() failed at nBlockHeight %d\n", nBlockHeight);
         return NULL;
     }
 
-    // Fill scores
-    BOOST_FOREACH(CSubinode& mn, vSubinodes) {
-
-        if(mn.nProtocolVersion < nMinProtocol) continue;
-        if(fOnlyActive && !mn.IsEnabled()) continue;
-
-        int64_t nScore = mn.CalculateScore(blockHash).GetCompact(false);
-
-        vecSubinodeScores.push_back(std::make_pair(nScore, &mn));
-    }
-
-    sort(vecSubinodeScores.rbegin(), vecSubinodeScores.rend(), CompareScoreMN());
+    LOCK(cs);
 
-    int rank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CSubinode*)& s, vecSubinodeScores){
-        rank++;
-        if(rank == nRank) {
-            return s.second;
-        }
-    }
+    const rank_cache_t& ranks = GetRankedSubinodes(pindex, nBlockHeight, nMinProtocol,
+                                                   fOnlyActive ? RANK_FILTER_ENABLED : RANK_FILTER_NONE);
+    if(nRank < 1 || nRank > (int)ranks.vecRanked.size()) return NULL;
 
-    return NULL;
+    return ranks.vecRanked[nRank - 1];
 }
 
 void CSubinodeMan::ProcessSubinodeConnections()
@@ -866,18 +1047,7 @@ void CSubinodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CDataSt
 
         //LogPrint("MNANNOUNCE -- Subinode announce, subinode=%s\n", mnb.vin.prevout.ToStringShort());
 
-        int nDos = 0;
-
-        if (CheckMnbAndUpdateSubinodeList(pfrom, mnb, nDos)) {
-            // use announced Subinode as a peer
-            g_connman->addrman.Add(CAddress(mnb.addr, NODE_NETWORK), pfrom->addr, 2*60*60);
-        } else if(nDos > 0) {
-            Misbehaving(pfrom->GetId(), nDos);
-        }
-
-        if(fSubinodesAdded) {
-            NotifySubinodeUpdates();
-        }
+        ReceiveBroadcast(pfrom, mnb);
     } else if (strCommand == NetMsgType::MNPING) { //Subinode Ping
 
         CSubinodePing mnp;
@@ -889,34 +1059,7 @@ void CSubinodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CDataSt
 
         //LogPrint("subinode", "MNPING -- Subinode ping, subinode=%s\n", mnp.vin.prevout.ToStringShort());
 
-        // Need LOCK2 here to ensure consistent locking order because the CheckAndUpdate call below locks cs_main
-        LOCK2(cs_main, cs);
-
-        if(mapSeenSubinodePing.count(nHash)) return; //seen
-        mapSeenSubinodePing.insert(std::make_pair(nHash, mnp));
-
-        //LogPrint("subinode", "MNPING -- Subinode ping, subinode=%s new\n", mnp.vin.prevout.ToStringShort());
-
-        // see if we have this Subinode
-        CSubinode* pmn = mnodeman.Find(mnp.vin);
-
-        // too late, new MNANNOUNCE is required
-        if(pmn && pmn->IsNewStartRequired()) return;
-
-        int nDos = 0;
-        if(mnp.CheckAndUpdate(pmn, false, nDos)) return;
-
-        if(nDos > 0) {
-            // if anything significant failed, mark that node
-            Misbehaving(pfrom->GetId(), nDos);
-        } else if(pmn != NULL) {
-            // nothing significant failed, mn is a known one too
-            return;
-        }
-
-        // something significant is broken or mn is unknown,
-        // we might have to ask for a subinode entry once
-        AskForMN(pfrom, mnp.vin);
+        ReceivePing(pfrom, mnp);
 
     } else if (strCommand == NetMsgType::DSEG) { //Get Subinode list or specific entry
         // Ignore such requests until we are fully synced.
@@ -952,7 +1095,7 @@ void CSubinodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CDataSt
 
         int nInvCount = 0;
 
-        BOOST_FOREACH(CSubinode& mn, vSubinodes) {
+        BOOST_FOREACH(CSubinode& mn, listSubinodes) {
             if (vin != CTxIn() && vin != mn.vin) continue; // asked for specific vin but we are not there yet
             if (mn.addr.IsRFC1918() || mn.addr.IsLocal()) continue; // do not send local network subinode
             if (mn.IsUpdateRequired()) continue; // do not send outdated subinodes
@@ -983,6 +1126,78 @@ void CSubinodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CDataSt
         // smth weird happen - someone asked us for vin we have no idea about?
         //LogPrint("subinode", "DSEG -- No invs sent to peer %d\n", pfrom->GetId());
 
+    } else if (strCommand == NetMsgType::MNLISTGET) { //Get the whole Subinode list or the changes since a list we sent before
+        // Ignore such requests until we are fully synced, see DSEG
+        if (!subinodeSync.IsSynced(chainActive.Height())) return;
+
+        uint256 hashKnownList;
+        vRecv >> hashKnownList;
+
+        LOCK(cs);
+
+        //local network
+        bool isLocal = (pfrom->addr.IsRFC1918() || pfrom->addr.IsLocal());
+
+        if(!isLocal && Params().NetworkIDString() == CBaseChainParams::MAIN) {
+            std::map<CNetAddr, int64_t>::iterator i = mAskedUsForSubinodeList.find(pfrom->addr);
+            if (i != mAskedUsForSubinodeList.end() && GetTime() < (*i).second) {
+                Misbehaving(pfrom->GetId(), 34);
+                //LogPrint("MNLISTGET -- peer already asked me for the list, peer=%d\n", pfrom->GetId());
+                return;
+            }
+            int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
+            mAskedUsForSubinodeList[pfrom->addr] = askAgain;
+        }
+
+        SendSubinodeList(pfrom, hashKnownList);
+
+    } else if (strCommand == NetMsgType::MNLIST) { //Subinode list, or a part of it
+
+        uint256 hashList;
+        std::vector<CSubinodeBroadcast> vecMnb;
+        bool fLast;
+        vRecv >> hashList >> vecMnb >> fLast;
+
+        {
+            LOCK(cs);
+            std::map<CNetAddr, int64_t>::iterator it = mWeAskedForSubinodeList.find(pfrom->addr);
+            if (it == mWeAskedForSubinodeList.end() || GetTime() > it->second) {
+                // we did not ask this peer for the list
+                Misbehaving(pfrom->GetId(), 20);
+                return;
+            }
+        }
+
+        if (vecMnb.size() > MNLIST_MAX_ENTRIES) {
+            Misbehaving(pfrom->GetId(), 20);
+            return;
+        }
+
+        // each entry is signed by its own subinode, treat them as if they were announced one by one
+        // the ping of an entry is processed after its broadcast
+        BOOST_FOREACH(const CSubinodeBroadcast& mnb, vecMnb) {
+            pfrom->setAskFor.erase(mnb.GetHash());
+            pfrom->setAskFor.erase(mnb.lastPing.GetHash());
+            ReceiveBroadcast(pfrom, mnb, true);
+        }
+
+        if (fLast) {
+            //LogPrint("subinode", "MNLIST -- got the list %s from peer %d\n", hashList.ToString(), pfrom->GetId());
+            // the list is synced once the entries before are processed, including those another peer sent first.
+            // Entries we did not add would not be sent again as changes, so then the next request asks for all of them
+            uint256 hashDone = (CHashWriter(SER_GETHASH, 0) << hashList << pfrom->GetId()).GetHash();
+            subinodeSigQueue.Push(pfrom, hashDone, std::vector<CSubinodeSigQueue::sig_t>(), [this, hashList](CNode* pnode) {
+                {
+                    LOCK(cs);
+                    if (setIncompleteLists.erase(pnode->GetId()))
+                        hashLastReceivedList.SetNull();
+                    else
+                        hashLastReceivedList = hashList;
+                }
+                subinodeSync.ReceivedSubinodeList();
+            });
+        }
+
     } else if (strCommand == NetMsgType::MNVERIFY) { // Subinode Verify
 
         // Need LOCK2 here to ensure consistent locking order because the all functions below call GetBlockHash which locks cs_main
@@ -1004,6 +1219,102 @@ void CSubinodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CDataSt
     }
 }
 
+void CSubinodeMan::ReceiveBroadcast(CNode* pfrom, const CSubinodeBroadcast& mnb, bool fListEntry)
+{
+    bool fSeen;
+    {
+        LOCK(cs);
+        fSeen = mapSeenSubinodeBroadcast.count(mnb.GetHash());
+    }
+    if (fSeen) {
+        // no new signatures to check, only the sync and recovery bookkeeping
+        ProcessBroadcast(pfrom, mnb, fListEntry);
+        return;
+    }
+
+    std::vector<CSubinodeSigQueue::sig_t> vecSigs;
+    vecSigs.push_back(CSubinodeSigQueue::sig_t(mnb.pubKeyCollateralAddress, mnb.GetSignatureMessage(), mnb.vchSig));
+    vecSigs.push_back(CSubinodeSigQueue::sig_t(mnb.pubKeySubinode, mnb.lastPing.GetSignatureMessage(), mnb.lastPing.vchSig));
+    subinodeSigQueue.Push(pfrom, mnb.GetHash(), vecSigs, [this, mnb, fListEntry](CNode* pnode) { ProcessBroadcast(pnode, mnb, fListEntry); });
+}
+
+void CSubinodeMan::ReceivePing(CNode* pfrom, const CSubinodePing& mnp)
+{
+    uint256 nHash = mnp.GetHash();
+
+    {
+        LOCK(cs);
+        if(mapSeenSubinodePing.count(nHash)) return; //seen
+    }
+
+    // pings from unknown subinodes only ask for the subinode, there is nothing to check early
+    std::vector<CSubinodeSigQueue::sig_t> vecSigs;
+    subinode_info_t mnInfo = GetSubinodeInfo(mnp.vin);
+    if (mnInfo.fInfoValid)
+        vecSigs.push_back(CSubinodeSigQueue::sig_t(mnInfo.pubKeySubinode, mnp.GetSignatureMessage(), mnp.vchSig));
+    subinodeSigQueue.Push(pfrom, nHash, vecSigs, [this, mnp](CNode* pnode) { ProcessPing(pnode, mnp); });
+}
+
+void CSubinodeMan::ProcessBroadcast(CNode* pfrom, CSubinodeBroadcast mnb, bool fListEntry)
+{
+    int nDos = 0;
+
+    if (CheckMnbAndUpdateSubinodeList(pfrom, mnb, nDos)) {
+        // use announced Subinode as a peer
+        g_connman->addrman.Add(CAddress(mnb.addr, NODE_NETWORK), pfrom->addr, 2*60*60);
+    } else {
+        if (fListEntry) {
+            LOCK(cs);
+            setIncompleteLists.insert(pfrom->GetId());
+        }
+        if(nDos > 0) {
+            Misbehaving(pfrom->GetId(), nDos);
+        }
+    }
+
+    // adding a new entry took its ping, a newer ping of a known one is checked on its own
+    if (fListEntry && !(mnb.lastPing == CSubinodePing()))
+        ReceivePing(pfrom, mnb.lastPing);
+
+    if(fSubinodesAdded) {
+        NotifySubinodeUpdates();
+    }
+}
+
+void CSubinodeMan::ProcessPing(CNode* pfrom, CSubinodePing mnp)
+{
+    uint256 nHash = mnp.GetHash();
+
+    // Need LOCK2 here to ensure consistent locking order because the CheckAndUpdate call below locks cs_main
+    LOCK2(cs_main, cs);
+
+    if(mapSeenSubinodePing.count(nHash)) return; //seen
+    mapSeenSubinodePing.insert(std::make_pair(nHash, mnp));
+
+    //LogPrint("subinode", "MNPING -- Subinode ping, subinode=%s new\n", mnp.vin.prevout.ToStringShort());
+
+    // see if we have this Subinode
+    CSubinode* pmn = mnodeman.Find(mnp.vin);
+
+    // too late, new MNANNOUNCE is required
+    if(pmn && pmn->IsNewStartRequired()) return;
+
+    int nDos = 0;
+    if(mnp.CheckAndUpdate(pmn, false, nDos)) return;
+
+    if(nDos > 0) {
+        // if anything significant failed, mark that node
+        Misbehaving(pfrom->GetId(), nDos);
+    } else if(pmn != NULL) {
+        // nothing significant failed, mn is a known one too
+        return;
+    }
+
+    // something significant is broken or mn is unknown,
+    // we might have to ask for a subinode entry once
+    AskForMN(pfrom, mnp.vin);
+}
+
 // Verification of subinodes via unique direct requests.
 
 void CSubinodeMan::DoFullVerificationStep()
@@ -1047,7 +1358,7 @@ void CSubinodeMan::DoFullVerificationStep()
     if(nOffset >= (int)vecSubinodeRanks.size()) return;
 
     std::vector<CSubinode*> vSortedByAddr;
-    BOOST_FOREACH(CSubinode& mn, vSubinodes) {
+    BOOST_FOREACH(CSubinode& mn, listSubinodes) {
         vSortedByAddr.push_back(&mn);
     }
 
@@ -1087,7 +1398,7 @@ void CSubinodeMan::DoFullVerificationStep()
 
 void CSubinodeMan::CheckSameAddr()
 {
-    if(!subinodeSync.IsSynced(chainActive.Height()) || vSubinodes.empty()) return;
+    if(!subinodeSync.IsSynced(chainActive.Height()) || listSubinodes.empty()) return;
 
     std::vector<CSubinode*> vBan;
     std::vector<CSubinode*> vSortedByAddr;
@@ -1098,7 +1409,7 @@ void CSubinodeMan::CheckSameAddr()
         CSubinode* pprevSubinode = NULL;
         CSubinode* pverifiedSubinode = NULL;
 
-        BOOST_FOREACH(CSubinode& mn, vSubinodes) {
+        BOOST_FOREACH(CSubinode& mn, listSubinodes) {
             vSortedByAddr.push_back(&mn);
         }
 
@@ -1251,9 +1562,9 @@ void CSubinodeMan::ProcessVerifyReply(CNode* pnode, CSubinodeVerification& mnv)
 
         CSubinode* prealSubinode = NULL;
         std::vector<CSubinode*> vpSubinodesToBan;
-        std::vector<CSubinode>::iterator it = vSubinodes.begin();
+        std::list<CSubinode>::iterator it = listSubinodes.begin();
         std::string strMessage1 = strprintf("%s%d%s", pnode->addr.ToString(), mnv.nonce, blockHash.ToString());
-        while(it != vSubinodes.end()) {
+        while(it != listSubinodes.end()) {
             if(CAddress(it->addr, NODE_NETWORK) == pnode->addr) {
                 if(darkSendSigner.VerifyMessage(it->pubKeySubinode, mnv.vchSig1, strMessage1, strError)) {
                     // found it!
@@ -1405,7 +1716,7 @@ void CSubinodeMan::ProcessVerifyBroadcast(CNode* pnode, const CSubinodeVerificat
 
         // increase ban score for everyone else with the same addr
         int nCount = 0;
-        BOOST_FOREACH(CSubinode& mn, vSubinodes) {
+        BOOST_FOREACH(CSubinode& mn, listSubinodes) {
             if(mn.addr != mnv.addr || mn.vin.prevout == mnv.vin1.prevout) continue;
             mn.IncreasePoSeBanScore();
             nCount++;
@@ -1421,7 +1732,7 @@ std::string CSubinodeMan::ToString() const
 {
     std::ostringstream info;
 
-    info << "Subinodes: " << (int)vSubinodes.size() <<
+    info << "Subinodes: " << (int)listSubinodes.size() <<
             ", peers who asked us for Subinode list: " << (int)mAskedUsForSubinodeList.size() <<
             ", peers we asked for Subinode list: " << (int)mWeAskedForSubinodeList.size() <<
             ", entries in Subinode list we asked for: " << (int)mWeAskedForSubinodeListEntry.size() <<
@@ -1449,7 +1760,10 @@ void CSubinodeMan::UpdateSubinodeList(CSubinodeBroadcast mnb)
             }
         } else {
             CSubinodeBroadcast mnbOld = mapSeenSubinodeBroadcast[CSubinodeBroadcast(*pmn).GetHash()].second;
-            if (pmn->UpdateFromNewBroadcast(mnb)) {
+            CPubKey pubKeyOld = pmn->pubKeySubinode;
+            bool fUpdated = pmn->UpdateFromNewBroadcast(mnb);
+            ReindexSubinodePubKey(pmn, pubKeyOld);
+            if (fUpdated) {
                 subinodeSync.AddedSubinodeList();
                 mapSeenSubinodeBroadcast.erase(mnbOld.GetHash());
             }
@@ -1514,7 +1828,10 @@ bool CSubinodeMan::CheckMnbAndUpdateSubinodeList(CNode* pfrom, CSubinodeBroadcas
         CSubinode *pmn = Find(mnb.vin);
         if (pmn) {
             CSubinodeBroadcast mnbOld = mapSeenSubinodeBroadcast[CSubinodeBroadcast(*pmn).GetHash()].second;
-            if (!mnb.Update(pmn, nDos)) {
+            CPubKey pubKeyOld = pmn->pubKeySubinode;
+            bool fUpdated = mnb.Update(pmn, nDos);
+            ReindexSubinodePubKey(pmn, pubKeyOld);
+            if (!fUpdated) {
                 //LogPrint("subinode", "CSubinodeMan::CheckMnbAndUpdateSubinodeList -- Update() failed, subinode=%s\n", mnb.vin.prevout.ToStringShort());
                 return false;
             }
@@ -1568,8 +1885,14 @@ void CSubinodeMan::UpdateLastPaid()
     //LogPrint("mnpayments", "CSubinodeMan::UpdateLastPaid -- nHeight=%d, nMaxBlocksToScanBack=%d, IsFirstRun=%s\n",
                             // pCurrentBlockIndex->nHeight, nMaxBlocksToScanBack, IsFirstRun ? "true" : "false");
 
-    BOOST_FOREACH(CSubinode& mn, vSubinodes) {
+    BOOST_FOREACH(CSubinode& mn, listSubinodes) {
+        int nBlockLastPaidOld = mn.GetLastPaidBlock();
         mn.UpdateLastPaid(pCurrentBlockIndex, nMaxBlocksToScanBack);
+        if(mn.GetLastPaidBlock() != nBlockLastPaidOld) {
+            // move it to its new place in the payment queue
+            setPaymentQueue.erase(std::make_pair(nBlockLastPaidOld, &mn));
+            setPaymentQueue.insert(std::make_pair(mn.GetLastPaidBlock(), &mn));
+        }
     }
 
     // every time is like the first time if winners list is not synced
@@ -1588,14 +1911,14 @@ void CSubinodeMan::CheckAndRebuildSubinodeIndex()
         return;
     }
 
-    if(indexSubinodes.GetSize() <= int(vSubinodes.size())) {
+    if(indexSubinodes.GetSize() <= int(listSubinodes.size())) {
         return;
     }
 
     indexSubinodesOld = indexSubinodes;
     indexSubinodes.Clear();
-    for(size_t i = 0; i < vSubinodes.size(); ++i) {
-        indexSubinodes.AddSubinodeVIN(vSubinodes[i].vin);
+    BOOST_FOREACH(const CSubinode& mn, listSubinodes) {
+        indexSubinodes.AddSubinodeVIN(mn.vin);
     }
 
     fIndexRebuilt = true;
@@ -6,15 +6,47 @@
 #ifndef SUBINODEMAN_H
 #define SUBINODEMAN_H
 
+#include "hash.h"
 #include "subinode.h"
 #include "sync.h"
 
+#include <atomic>
+#include <deque>
+#include <list>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
 using namespace std;
 
 class CSubinodeMan;
 
 extern CSubinodeMan mnodeman;
 
+struct CompareLastPaidBlock
+{
+    bool operator()(const std::pair<int, CSubinode*>& t1,
+                    const std::pair<int, CSubinode*>& t2) const
+    {
+        return (t1.first != t2.first) ? (t1.first < t2.first) : (t1.second->vin < t2.second->vin);
+    }
+};
+
+/** Salted hasher for the key id indexes of CSubinodeMan */
+class SaltedKeyIDHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedKeyIDHasher();
+
+    size_t operator()(const CKeyID& id) const {
+        return CSipHasher(k0, k1).Write(id.begin(), id.size()).Finalize();
+    }
+};
+
 /**
  * Provides a forward and reverse index between MN vin's and integers.
  *
@@ -98,6 +130,11 @@ private:
 
     static const int DSEG_UPDATE_SECONDS        = 3 * 60 * 60;
 
+    /// Broadcasts per MNLIST message
+    static const int MNLIST_MAX_ENTRIES         = 500;
+    /// Lists sent to peers we can send the changes since
+    static const int MAX_SENT_LIST_SNAPSHOTS    = 8;
+
     static const int LAST_PAID_SCAN_BLOCKS      = 100;
 
     static const int MIN_POSE_PROTO_VERSION     = 70203;
@@ -111,18 +148,71 @@ private:
     static const int MNB_RECOVERY_WAIT_SECONDS      = 60;
     static const int MNB_RECOVERY_RETRY_SECONDS     = 3 * 60 * 60;
 
+    static const int MAX_RANK_CACHE_BLOCKS      = 16;
+
+    /// Filters applied to the list before it is ranked
+    enum rank_filter_t {
+        RANK_FILTER_NONE,
+        RANK_FILTER_VALID_FOR_PAYMENT,
+        RANK_FILTER_ENABLED
+    };
+
+    /// Scores of the subinodes for one block by collateral outpoint
+    struct score_cache_t {
+        uint256 blockHash;
+        std::unordered_map<COutPoint, arith_uint256, SaltedOutpointHasher> mapScores;
+
+        arith_uint256 GetScore(CSubinode& mn)
+        {
+            auto it = mapScores.find(mn.vin.prevout);
+            if(it == mapScores.end()) {
+                it = mapScores.emplace(mn.vin.prevout, mn.CalculateScore(blockHash)).first;
+            }
+            return it->second;
+        }
+    };
+
+    /// Subinodes passing a filter for one block, best score first
+    struct rank_cache_t {
+        const CBlockIndex* pindex;
+        std::vector<CSubinode*> vecRanked;
+        std::unordered_map<COutPoint, int, SaltedOutpointHasher> mapRanks;
+    };
 
     // Keep track of current block index
     const CBlockIndex *pCurrentBlockIndex;
 
-    // map to hold all MNs
-    std::vector<CSubinode> vSubinodes;
+    // list to hold all MNs, list nodes keep the CSubinode pointers handed out by Find valid until removal
+    std::list<CSubinode> listSubinodes;
+    // indexes into listSubinodes by collateral outpoint, by operator key and by collateral key (the payee)
+    std::unordered_map<COutPoint, CSubinode*, SaltedOutpointHasher> mapSubinodesByOutpoint;
+    std::unordered_multimap<CKeyID, CSubinode*, SaltedKeyIDHasher> mapSubinodesByPubKey;
+    std::unordered_multimap<CKeyID, CSubinode*, SaltedKeyIDHasher> mapSubinodesByPayee;
+    // all entries by last paid block, the order they are considered for payment in
+    std::set<std::pair<int, CSubinode*>, CompareLastPaidBlock> setPaymentQueue;
+
+    // a score only depends on the collateral and the block, these are kept until too many blocks are cached
+    std::map<const CBlockIndex*, score_cache_t> mapScoreCache;
+    // rankings by height, min protocol and filter, dropped as soon as nRankCacheVersion falls behind nListVersion
+    std::map<std::tuple<int, int, int>, rank_cache_t> mapRankCache;
+    int64_t nRankCacheVersion;
+    // enabled subinode counts by protocol version, valid while nEnabledCountVersion matches nListVersion
+    std::map<int, int> mapEnabledCounts;
+    int64_t nEnabledCountVersion;
+    // bumped whenever an entry is added or removed or changes its state or protocol version
+    std::atomic<int64_t> nListVersion;
     // who's asked for the Subinode list and the last time
     std::map<CNetAddr, int64_t> mAskedUsForSubinodeList;
     // who we asked for the Subinode list and the last time
     std::map<CNetAddr, int64_t> mWeAskedForSubinodeList;
     // which Subinodes we've asked for
     std::map<COutPoint, std::map<CNetAddr, int64_t> > mWeAskedForSubinodeListEntry;
+    // lists we sent as MNLIST by their hash, newest first: hash of the broadcast and ping by outpoint
+    std::deque<std::pair<uint256, std::map<COutPoint, uint256> > > listSentSnapshots;
+    // hash of the last list we received as MNLIST, null if we removed subinodes since
+    uint256 hashLastReceivedList;
+    // peers with entries of the MNLIST they are sending we did not add
+    std::set<NodeId> setIncompleteLists;
     // who we asked for the subinode verification
     std::map<CNetAddr, CSubinodeVerification> mWeAskedForVerification;
 
@@ -152,6 +242,24 @@ private:
 
     friend class CSubinodeSync;
 
+    /// Add or remove the index entries of an entry in listSubinodes
+    void IndexSubinode(CSubinode* pmn);
+    void UnindexSubinode(CSubinode* pmn);
+    /// Move an entry to its new operator key after a broadcast replaced pubKeyOld
+    void ReindexSubinodePubKey(CSubinode* pmn, const CPubKey& pubKeyOld);
+    void RebuildSubinodeIndexes();
+
+    score_cache_t& GetScoreCache(const CBlockIndex* pindex);
+    /// Rank the subinodes for the block pindex at nBlockHeight, or return the cached ranking
+    const rank_cache_t& GetRankedSubinodes(const CBlockIndex* pindex, int nBlockHeight, int nMinProtocol, rank_filter_t filter);
+
+    /**
+     * Walk the payment queue from the least recently paid subinode, collecting the first nCandidates
+     * subinodes qualified for payment at nBlockHeight into vecCandidatesRet. Stops as soon as those are
+     * found and at least nMinQualified subinodes qualified. Returns the number of qualified subinodes seen.
+     */
+    int WalkPaymentQueue(int nBlockHeight, bool fFilterSigTime, int nMnCount, int nCandidates, int nMinQualified, std::vector<CSubinode*>& vecCandidatesRet);
+
 public:
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -179,7 +287,16 @@ public:
             READWRITE(strVersion);
         }
 
+        // the list is stored as a vector to keep the cache file format
+        std::vector<CSubinode> vSubinodes;
+        if(!ser_action.ForRead()) {
+            vSubinodes.assign(listSubinodes.begin(), listSubinodes.end());
+        }
         READWRITE(vSubinodes);
+        if(ser_action.ForRead()) {
+            listSubinodes.assign(vSubinodes.begin(), vSubinodes.end());
+            RebuildSubinodeIndexes();
+        }
         READWRITE(mAskedUsForSubinodeList);
         READWRITE(mWeAskedForSubinodeList);
         READWRITE(mWeAskedForSubinodeListEntry);
@@ -211,7 +328,7 @@ public:
     /// Check all Subinodes and remove inactive
     void CheckAndRemove();
 
-    /// Clear Subinode vector
+    /// Clear Subinode list
     void Clear();
 
     /// Count Subinodes filtered by nProtocolVersion.
@@ -224,7 +341,10 @@ public:
     /// Count Subinodes by network type - NET_IPV4, NET_IPV6, NET_TOR
     // int CountByIP(int nNetworkType);
 
+    /// Ask a peer for the whole list, or for the changes since the last list it sent us
     void DsegUpdate(CNode* pnode);
+    /// Send the list as MNLIST, only the changes since hashKnownList if we sent that list recently
+    void SendSubinodeList(CNode* pnode, const uint256& hashKnownList);
 
     /// Find an entry
     CSubinode* Find(const CScript &payee);
@@ -286,7 +406,11 @@ public:
 
     char* GetNotQualifyReason(CSubinode& mn, int nBlockHeight, bool fFilterSigTime, int nMnCount);
 
-    /// Find an entry in the subinode list that is next to be paid
+    /// Count the subinodes qualified for payment at the current block as GetNextSubinodeInQueueForPayment would
+    int CountQualifiedForPayment();
+
+    /// Find an entry in the subinode list that is next to be paid,
+    /// nCount is set to the number of qualified subinodes seen before the winner was settled
     CSubinode* GetNextSubinodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCount);
     /// Same as above but use current block height
     CSubinode* GetNextSubinodeInQueueForPayment(bool fFilterSigTime, int& nCount);
@@ -294,7 +418,7 @@ public:
     /// Find a random entry
     CSubinode* FindRandomNotInVec(const std::vector<CTxIn> &vecToExclude, int nProtocolVersion = -1);
 
-    std::vector<CSubinode> GetFullSubinodeVector() { return vSubinodes; }
+    std::vector<CSubinode> GetFullSubinodeVector() { LOCK(cs); return std::vector<CSubinode>(listSubinodes.begin(), listSubinodes.end()); }
 
     std::vector<std::pair<int, CSubinode> > GetSubinodeRanks(int nBlockHeight = -1, int nMinProtocol=0);
     int GetSubinodeRank(const CTxIn &vin, int nBlockHeight, int nMinProtocol=0, bool fOnlyActive=true);
@@ -304,6 +428,13 @@ public:
     std::pair<CService, std::set<uint256> > PopScheduledMnbRequestConnection();
 
     void ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+    /// Process a subinode broadcast or ping we have not seen yet, after subinodeSigQueue checked its signatures.
+    /// Entries of an MNLIST (fListEntry) we do not add make the next list request ask for the full list
+    void ReceiveBroadcast(CNode* pfrom, const CSubinodeBroadcast& mnb, bool fListEntry = false);
+    void ReceivePing(CNode* pfrom, const CSubinodePing& mnp);
+    /// Called by ReceiveBroadcast and ReceivePing
+    void ProcessBroadcast(CNode* pfrom, CSubinodeBroadcast mnb, bool fListEntry);
+    void ProcessPing(CNode* pfrom, CSubinodePing mnp);
 
     void DoFullVerificationStep();
     void CheckSameAddr();
@@ -313,7 +444,7 @@ public:
     void ProcessVerifyBroadcast(CNode* pnode, const CSubinodeVerification& mnv);
 
     /// Return the number of (unique) Subinodes
-    int size() { return vSubinodes.size(); }
+    int size() { return listSubinodes.size(); }
 
     std::string ToString() const;
 
@@ -357,6 +488,9 @@ public:
 
     void UpdatedBlockTip(const CBlockIndex *pindex);
 
+    /// Drop the cached rankings, must be called when a listed subinode changes its state or protocol version
+    void InvalidateRankCache() { nListVersion++; }
+
     /**
      * Called to notify CGovernanceManager that the subinode index has been updated.
      * Must be called while not holding the CSubinodeMan::cs mutex
@@ -0,0 +1,183 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addressindex.h>
+#include <arith_uint256.h>
+#include <keystore.h>
+#include <script/script.h>
+#include <script/standard.h>
+#include <txdb.h>
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(addressindex_tests, BasicTestingSetup)
+
+static uint256 TxHash(int n)
+{
+    return ArithToUint256(arith_uint256(n));
+}
+
+BOOST_AUTO_TEST_CASE(address_index_paging)
+{
+    CBlockTreeDB db(1 << 20, true);
+    const uint256 hashAddress = InsecureRand256();
+    const uint256 hashOther = InsecureRand256();
+
+    // five transactions with two outputs each paying the address, one per block,
+    // and one for another address in each block
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vEntries;
+    for (int nHeight = 1; nHeight <= 5; nHeight++) {
+        for (size_t n = 0; n < 2; n++)
+            vEntries.push_back(std::make_pair(CAddressIndexKey(ADDR_INDT_PUBKEY_ADDRESS, hashAddress, nHeight, 1, TxHash(nHeight), n, false), COIN));
+        vEntries.push_back(std::make_pair(CAddressIndexKey(ADDR_INDT_PUBKEY_ADDRESS, hashOther, nHeight, 2, TxHash(100 + nHeight), 0, false), COIN));
+    }
+    BOOST_CHECK(db.WriteInsightIndexes(vEntries, {}, {}, false));
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vAll;
+    BOOST_CHECK(db.ReadAddressIndex(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, vAll));
+    BOOST_CHECK_EQUAL(vAll.size(), 10U);
+
+    // the limit counts transactions, whose entries are never split across pages
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vPaged;
+    CAddressIndexKey keyNext;
+    bool fMore = true;
+    bool fFirst = true;
+    int nPages = 0;
+    while (fMore) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vPage;
+        CAddressIndexKey keyStart = keyNext;
+        BOOST_CHECK(db.ReadAddressIndexPage(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, fFirst ? nullptr : &keyStart, 3, vPage, fMore, keyNext));
+        BOOST_CHECK(vPage.size() == 6 || (!fMore && vPage.size() == 4));
+        vPaged.insert(vPaged.end(), vPage.begin(), vPage.end());
+        fFirst = false;
+        nPages++;
+    }
+    BOOST_CHECK_EQUAL(nPages, 2);
+    BOOST_CHECK_EQUAL(vPaged.size(), vAll.size());
+    for (size_t i = 0; i < vAll.size() && i < vPaged.size(); i++) {
+        BOOST_CHECK(vPaged[i].first.txhash == vAll[i].first.txhash);
+        BOOST_CHECK_EQUAL(vPaged[i].first.index, vAll[i].first.index);
+    }
+
+    // a height range limits the pages as well
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vRange;
+    BOOST_CHECK(db.ReadAddressIndexPage(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, nullptr, 5, vRange, fMore, keyNext, 2, 3));
+    BOOST_CHECK(!fMore);
+    BOOST_CHECK_EQUAL(vRange.size(), 4U);
+    for (const auto& entry : vRange)
+        BOOST_CHECK(entry.first.blockHeight >= 2 && entry.first.blockHeight <= 3);
+}
+
+BOOST_AUTO_TEST_CASE(address_unspent_index_paging)
+{
+    CBlockTreeDB db(1 << 20, true);
+    const uint256 hashAddress = InsecureRand256();
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vEntries;
+    for (int n = 1; n <= 5; n++)
+        vEntries.push_back(std::make_pair(CAddressUnspentKey(ADDR_INDT_PUBKEY_ADDRESS, hashAddress, TxHash(n), 0), CAddressUnspentValue(n * COIN, CScript() << OP_TRUE, n)));
+    BOOST_CHECK(db.WriteInsightIndexes({}, vEntries, {}, false));
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vAll;
+    BOOST_CHECK(db.ReadAddressUnspentIndex(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, vAll));
+    BOOST_CHECK_EQUAL(vAll.size(), 5U);
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vPaged;
+    CAddressUnspentKey keyNext;
+    bool fMore = true;
+    bool fFirst = true;
+    while (fMore) {
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vPage;
+        CAddressUnspentKey keyStart = keyNext;
+        BOOST_CHECK(db.ReadAddressUnspentIndexPage(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, fFirst ? nullptr : &keyStart, 2, vPage, fMore, keyNext));
+        BOOST_CHECK(vPage.size() <= 2);
+        vPaged.insert(vPaged.end(), vPage.begin(), vPage.end());
+        fFirst = false;
+    }
+    BOOST_CHECK_EQUAL(vPaged.size(), vAll.size());
+    for (size_t i = 0; i < vAll.size() && i < vPaged.size(); i++) {
+        BOOST_CHECK(vPaged[i].first.txhash == vAll[i].first.txhash);
+        BOOST_CHECK_EQUAL(vPaged[i].second.satoshis, vAll[i].second.satoshis);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(address_index_key_forms)
+{
+    CKey key, keyStake;
+    key.MakeNewKey(true);
+    keyStake.MakeNewKey(true);
+    const CKeyID keyID = key.GetPubKey().GetID();
+    const CScript scriptKeyHash = GetScriptForDestination(keyID);
+    const CScript scriptStake = GetScriptForDestination(keyStake.GetPubKey().GetID());
+
+    CScript scriptTimeLocked = CScript() << CScriptNum(100) << OP_CHECKLOCKTIMEVERIFY << OP_DROP;
+    scriptTimeLocked += scriptKeyHash;
+    CScript scriptColdStake = CScript() << OP_ISCOINSTAKE << OP_IF;
+    scriptColdStake += scriptStake;
+    scriptColdStake << OP_ELSE;
+    scriptColdStake += scriptKeyHash;
+    scriptColdStake << OP_ENDIF;
+
+    // every output the wallet matches for the key is indexed under its P2PKH address
+    for (const CScript& script : {scriptKeyHash, GetScriptForRawPubKey(key.GetPubKey()),
+                                  GetScriptForDestination(WitnessV0KeyHash(keyID)), scriptTimeLocked, scriptColdStake}) {
+        int scriptType = 0;
+        std::vector<uint8_t> hashBytes;
+        BOOST_CHECK(ExtractIndexInfo(&script, scriptType, hashBytes));
+        BOOST_CHECK_EQUAL(scriptType, ADDR_INDT_PUBKEY_ADDRESS);
+        BOOST_CHECK(hashBytes == std::vector<uint8_t>(keyID.begin(), keyID.end()));
+    }
+
+    int scriptType = 0;
+    std::vector<uint8_t> hashBytes;
+    BOOST_CHECK(ExtractIndexInfo(&(CScript() << OP_RETURN), scriptType, hashBytes));
+    BOOST_CHECK_EQUAL(scriptType, ADDR_INDT_UNKNOWN);
+}
+
+BOOST_AUTO_TEST_CASE(address_balance_connect_disconnect)
+{
+    CBlockTreeDB db(1 << 20, true);
+    const uint256 hashAddress = InsecureRand256();
+
+    // a block receiving 5 coins in two outputs of one transaction, and one spending 3 of them
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vReceive = {
+        std::make_pair(CAddressIndexKey(ADDR_INDT_PUBKEY_ADDRESS, hashAddress, 1, 1, TxHash(1), 0, false), 2 * COIN),
+        std::make_pair(CAddressIndexKey(ADDR_INDT_PUBKEY_ADDRESS, hashAddress, 1, 1, TxHash(1), 1, false), 3 * COIN),
+    };
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vSpend = {
+        std::make_pair(CAddressIndexKey(ADDR_INDT_PUBKEY_ADDRESS, hashAddress, 2, 1, TxHash(2), 0, true), -3 * COIN),
+    };
+
+    CAddressBalanceValue value;
+    BOOST_CHECK(db.WriteInsightIndexes(vReceive, {}, {}, false));
+    BOOST_CHECK(db.WriteInsightIndexes(vSpend, {}, {}, false));
+    BOOST_CHECK(db.ReadAddressBalance(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, value));
+    BOOST_CHECK_EQUAL(value.balance, 2 * COIN);
+    BOOST_CHECK_EQUAL(value.received, 5 * COIN);
+    BOOST_CHECK_EQUAL(value.txCount, 2);
+
+    // indexing a block again, as after a crash, leaves the totals alone
+    BOOST_CHECK(db.WriteInsightIndexes(vSpend, {}, {}, false));
+    BOOST_CHECK(db.ReadAddressBalance(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, value));
+    BOOST_CHECK_EQUAL(value.balance, 2 * COIN);
+    BOOST_CHECK_EQUAL(value.txCount, 2);
+
+    // disconnecting the spend restores the totals before it, twice or not
+    BOOST_CHECK(db.WriteInsightIndexes(vSpend, {}, {}, true));
+    BOOST_CHECK(db.WriteInsightIndexes(vSpend, {}, {}, true));
+    BOOST_CHECK(db.ReadAddressBalance(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, value));
+    BOOST_CHECK_EQUAL(value.balance, 5 * COIN);
+    BOOST_CHECK_EQUAL(value.received, 5 * COIN);
+    BOOST_CHECK_EQUAL(value.txCount, 1);
+
+    // and disconnecting the rest removes the record
+    BOOST_CHECK(db.WriteInsightIndexes(vReceive, {}, {}, true));
+    BOOST_CHECK(db.ReadAddressBalance(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, value));
+    BOOST_CHECK(value.IsNull());
+    BOOST_CHECK_EQUAL(value.balance, 0);
+    BOOST_CHECK_EQUAL(value.received, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,126 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addressindex.h>
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <insightindexer.h>
+#include <keystore.h>
+#include <script/standard.h>
+#include <txdb.h>
+#include <utiltime.h>
+#include <validation.h>
+#include <validationinterface.h>
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(insightindexer_tests, TestChain100Setup)
+
+static bool WaitForIndexer(const CInsightIndexer& indexer)
+{
+    for (int i = 0; i < 1000; i++) {
+        {
+            LOCK(cs_main);
+            if (indexer.GetBestBlock() == chainActive.Tip())
+                return true;
+        }
+        MilliSleep(10);
+    }
+    return false;
+}
+
+static std::set<int> GetIndexedHeights(const uint256& hashAddress)
+{
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    BOOST_CHECK(pblocktree->ReadAddressIndex(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, addressIndex));
+    std::set<int> setHeights;
+    for (const auto& entry : addressIndex)
+        setHeights.insert(entry.first.blockHeight);
+    return setHeights;
+}
+
+BOOST_AUTO_TEST_CASE(insightindexer_reorg_restart)
+{
+    fAddressIndex = true;
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CKeyID keyID = key.GetPubKey().GetID();
+    const uint256 hashAddress(keyID.begin(), keyID.size());
+    const CScript scriptAddress = GetScriptForDestination(keyID);
+    const CScript scriptOther = GetScriptForRawPubKey(coinbaseKey.GetPubKey());
+
+    CreateAndProcessBlock({}, scriptAddress);
+    CreateAndProcessBlock({}, scriptAddress);
+
+    // index the whole chain
+    BOOST_CHECK(pblocktree->WriteInsightIndexBest(CBlockLocator()));
+    CInsightIndexer indexer;
+    BOOST_CHECK(indexer.Start());
+    boost::thread thread(&CInsightIndexer::Thread, &indexer);
+    BOOST_CHECK(WaitForIndexer(indexer));
+    BOOST_CHECK_EQUAL(indexer.GetBestHeight(), chainActive.Height());
+    BOOST_CHECK(GetIndexedHeights(hashAddress) == std::set<int>({101, 102}));
+
+    // an invalidated tip is removed from the indexes without a block replacing it
+    {
+        CValidationState state;
+        {
+            LOCK(cs_main);
+            InvalidateBlock(state, Params(), chainActive.Tip());
+        }
+        BOOST_CHECK(ActivateBestChain(state, Params()));
+    }
+    BOOST_CHECK_EQUAL(chainActive.Height(), 101);
+    BOOST_CHECK(WaitForIndexer(indexer));
+    BOOST_CHECK_EQUAL(indexer.GetBestHeight(), 101);
+    BOOST_CHECK(GetIndexedHeights(hashAddress) == std::set<int>({101}));
+
+    // move the chain on along a branch without the invalidated block
+    CreateAndProcessBlock({}, scriptOther);
+    CreateAndProcessBlock({}, scriptOther);
+    BOOST_CHECK_EQUAL(chainActive.Height(), 103);
+    BOOST_CHECK(WaitForIndexer(indexer));
+    BOOST_CHECK(GetIndexedHeights(hashAddress) == std::set<int>({101}));
+
+    CAddressBalanceValue balance;
+    BOOST_CHECK(pblocktree->ReadAddressBalance(hashAddress, ADDR_INDT_PUBKEY_ADDRESS, balance));
+    BOOST_CHECK_EQUAL(balance.txCount, 1);
+
+    // the flush records the block the indexes are synced to
+    FlushStateToDisk();
+    SyncWithValidationInterfaceQueue();
+    thread.interrupt();
+    thread.join();
+    UnregisterValidationInterface(&indexer);
+
+    {
+        CInsightIndexer indexerRestarted;
+        BOOST_CHECK(indexerRestarted.Start());
+        UnregisterValidationInterface(&indexerRestarted);
+        BOOST_CHECK(indexerRestarted.GetBestBlock() == chainActive.Tip());
+    }
+
+    // a locator naming a block that did not reach the disk resumes from the next one known
+    {
+        CBlockLocator locator;
+        {
+            LOCK(cs_main);
+            locator = chainActive.GetLocator();
+        }
+        locator.vHave.insert(locator.vHave.begin(), InsecureRand256());
+        BOOST_CHECK(pblocktree->WriteInsightIndexBest(locator));
+
+        CInsightIndexer indexerRestarted;
+        BOOST_CHECK(indexerRestarted.Start());
+        UnregisterValidationInterface(&indexerRestarted);
+        BOOST_CHECK(indexerRestarted.GetBestBlock() == chainActive.Tip());
+    }
+
+    fAddressIndex = false;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
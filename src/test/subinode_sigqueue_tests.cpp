@@ -0,0 +1,79 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <key.h>
+#include <net.h>
+#include <subinode/darksend.h>
+#include <subinode/subinode-sigqueue.h>
+#include <utiltime.h>
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(subinode_sigqueue_tests, BasicTestingSetup)
+
+static std::vector<CSubinodeSigQueue::sig_t> SignMessage(const std::string& strMessage)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(darkSendSigner.SignMessage(strMessage, vchSig, key));
+    return {CSubinodeSigQueue::sig_t(key.GetPubKey(), strMessage, vchSig)};
+}
+
+BOOST_AUTO_TEST_CASE(sigqueue_no_workers)
+{
+    CSubinodeSigQueue queue;
+    CNode node(0, NODE_NETWORK, 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", true);
+
+    // without workers the signatures are left to the processing, which runs right away
+    std::vector<std::string> vProcessed;
+    queue.Push(&node, GetRandHash(), SignMessage("a"), [&](CNode*) { vProcessed.push_back("a"); });
+    BOOST_CHECK(vProcessed == std::vector<std::string>({"a"}));
+    queue.ProcessReady(&node);
+    BOOST_CHECK_EQUAL(vProcessed.size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(sigqueue_order)
+{
+    CSubinodeSigQueue queue;
+    CNode node1(0, NODE_NETWORK, 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", true);
+    CNode node2(1, NODE_NETWORK, 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", true);
+
+    boost::thread_group workers;
+    workers.create_thread(boost::bind(&CSubinodeSigQueue::Thread, &queue));
+    // give the worker time to register, without one Push processes messages right away
+    MilliSleep(100);
+
+    std::vector<std::string> vProcessed1, vProcessed2;
+    const uint256 hashBroadcast = GetRandHash();
+    const uint256 hashPing = GetRandHash();
+    queue.Push(&node1, hashBroadcast, SignMessage("broadcast"), [&](CNode*) { vProcessed1.push_back("broadcast"); });
+    queue.Push(&node1, hashPing, SignMessage("ping"), [&](CNode*) { vProcessed1.push_back("ping"); });
+    // the same broadcast from another peer waits for the queued one
+    queue.Push(&node2, hashBroadcast, SignMessage("broadcast"), [&](CNode*) { vProcessed2.push_back("broadcast"); });
+
+    for (int i = 0; i < 1000 && (vProcessed1.size() < 2 || vProcessed2.size() < 1); i++) {
+        queue.ProcessReady(&node1);
+        queue.ProcessReady(&node2);
+        MilliSleep(10);
+    }
+
+    // each peer's messages are processed once, in the order it sent them
+    BOOST_CHECK(vProcessed1 == std::vector<std::string>({"broadcast", "ping"}));
+    BOOST_CHECK(vProcessed2 == std::vector<std::string>({"broadcast"}));
+
+    // a dropped peer's messages are never processed
+    queue.Push(&node1, GetRandHash(), SignMessage("vote"), [&](CNode*) { vProcessed1.push_back("vote"); });
+    queue.ForgetNode(node1.GetId());
+    MilliSleep(100);
+    queue.ProcessReady(&node1);
+    BOOST_CHECK_EQUAL(vProcessed1.size(), 2U);
+
+    workers.interrupt_all();
+    workers.join_all();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,7 +7,9 @@
 #include <chainparams.h>
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <crypto/neoscrypt.h>
 #include <crypto/sha256.h>
+#include <crypto/x16r/x16r.h>
 #include <validation.h>
 #include <miner.h>
 #include <net_processing.h>
@@ -40,6 +42,8 @@ extern void noui_connect();
 BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
 {
         SHA256AutoDetect();
+        X16RAutoDetect();
+        neoscrypt_batch_autodetect();
         RandomInit();
         ECC_Start();
         SetupEnvironment();
@@ -0,0 +1,50 @@
+// Copyright (c) 2018-2019 The Subi Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <txdb.h>
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(zerocoindata_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(zerocoin_data_copy_on_write)
+{
+    CBlockTreeDB db(1 << 20, true);
+    const uint256 hashBlock = InsecureRand256();
+    CBlockIndex index;
+    index.phashBlock = &hashBlock;
+    index.nHeight = 1;
+
+    // a block without zerocoin activity has no data
+    std::shared_ptr<const CBlockZerocoinData> empty = db.ReadZerocoinData(&index);
+    BOOST_CHECK(empty->spentSerials.empty());
+    BOOST_CHECK(!(index.nStatus & BLOCK_HAVE_ZEROCOIN));
+
+    db.ModifyZerocoinData(&index, [](CBlockZerocoinData& data) { data.spentSerials.insert(CBigNum(1)); });
+    BOOST_CHECK(index.nStatus & BLOCK_HAVE_ZEROCOIN);
+    std::shared_ptr<const CBlockZerocoinData> first = db.ReadZerocoinData(&index);
+    BOOST_CHECK_EQUAL(first->spentSerials.size(), 1U);
+
+    // readers keep the version they hold, and see the change only once it is complete
+    db.ModifyZerocoinData(&index, [&first](CBlockZerocoinData& data) {
+        data.spentSerials.insert(CBigNum(2));
+        BOOST_CHECK_EQUAL(first->spentSerials.size(), 1U);
+        data.spentSerials.insert(CBigNum(3));
+    });
+    BOOST_CHECK_EQUAL(first->spentSerials.size(), 1U);
+    BOOST_CHECK(empty->spentSerials.empty());
+    std::shared_ptr<const CBlockZerocoinData> second = db.ReadZerocoinData(&index);
+    BOOST_CHECK_EQUAL(second->spentSerials.size(), 3U);
+
+    // dirty data survives until it is written, then reads back from the database
+    BOOST_CHECK(db.WriteBatchSync({}, 0, {}));
+    db.ClearZerocoinCache();
+    std::shared_ptr<const CBlockZerocoinData> written = db.ReadZerocoinData(&index);
+    BOOST_CHECK(written != second);
+    BOOST_CHECK(written->spentSerials == second->spentSerials);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
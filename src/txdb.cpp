@@ -15,8 +15,11 @@
 #include <init.h>
 #include <pos/miner.h>
 #include "validation.h"
+#include "zerocoin/zerocoin.h"
 
+#include <set>
 #include <stdint.h>
+#include <tuple>
 
 #include <boost/thread.hpp>
 
@@ -25,12 +28,17 @@ static const char DB_COINS = 'c';
 static const char DB_BLOCK_FILES = 'f';
 static const char DB_TXINDEX = 't';
 static const char DB_BLOCK_INDEX = 'b';
+static const char DB_BLOCK_POWHASH = 'W';
+static const char DB_ZEROCOIN_DATA = 'Z';
+static const char DB_ZEROCOIN_STATE = 'X';
 
 static const char DB_ADDRESSINDEX = 'a';
+static const char DB_ADDRESSBALANCE = 'A';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCKHASHINDEX = 'z';
+static const char DB_INSIGHT_BEST_BLOCK = 'I';
 
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_HEAD_BLOCKS = 'H';
@@ -156,6 +164,7 @@ size_t CCoinsViewDB::EstimateSize() const
 }
 
 CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe) {
+    nZerocoinCacheSize = std::max<int64_t>(gArgs.GetArg("-zerocoindatacache", DEFAULT_ZEROCOIN_DATA_CACHE), 1);
 }
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
@@ -241,7 +250,98 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     for (std::vector<const CBlockIndex*>::const_iterator it=blockinfo.begin(); it != blockinfo.end(); it++) {
         batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), CDiskBlockIndex(*it));
     }
-    return WriteBatch(batch, true);
+
+    std::vector<const CBlockIndex*> vZerocoinWritten;
+    {
+        LOCK(cs_zerocoin);
+        for (auto& entry : mapZerocoinCache) {
+            if (entry.second.fDirty) {
+                batch.Write(std::make_pair(DB_ZEROCOIN_DATA, std::make_pair(entry.first->nHeight, entry.first->GetBlockHash())), *entry.second.data);
+                vZerocoinWritten.push_back(entry.first);
+            }
+        }
+    }
+    if (!WriteBatch(batch, true))
+        return false;
+
+    LOCK(cs_zerocoin);
+    for (const CBlockIndex* pindex : vZerocoinWritten) {
+        auto it = mapZerocoinCache.find(pindex);
+        if (it != mapZerocoinCache.end())
+            it->second.fDirty = false;
+    }
+    TrimZerocoinCache();
+    return true;
+}
+
+void CBlockTreeDB::TrimZerocoinCache()
+{
+    AssertLockHeld(cs_zerocoin);
+    auto it = lruZerocoin.end();
+    while (mapZerocoinCache.size() > nZerocoinCacheSize && it != lruZerocoin.begin()) {
+        --it;
+        auto itEntry = mapZerocoinCache.find(*it);
+        if (itEntry->second.fDirty)
+            continue;
+        mapZerocoinCache.erase(itEntry);
+        it = lruZerocoin.erase(it);
+    }
+}
+
+std::shared_ptr<const CBlockZerocoinData> CBlockTreeDB::ReadZerocoinData(const CBlockIndex* pindex)
+{
+    static const std::shared_ptr<const CBlockZerocoinData> empty = std::make_shared<const CBlockZerocoinData>();
+    if (!(pindex->nStatus & BLOCK_HAVE_ZEROCOIN))
+        return empty;
+
+    LOCK(cs_zerocoin);
+    auto it = mapZerocoinCache.find(pindex);
+    if (it != mapZerocoinCache.end()) {
+        lruZerocoin.splice(lruZerocoin.begin(), lruZerocoin, it->second.itLRU);
+        return it->second.data;
+    }
+
+    // The flag and the data are written in the same batch, so missing data means a corrupt database
+    std::shared_ptr<CBlockZerocoinData> data = std::make_shared<CBlockZerocoinData>();
+    if (!Read(std::make_pair(DB_ZEROCOIN_DATA, std::make_pair(pindex->nHeight, pindex->GetBlockHash())), *data))
+        throw dbwrapper_error(strprintf("Failed to read zerocoin data of block %s", pindex->GetBlockHash().ToString()));
+
+    lruZerocoin.push_front(pindex);
+    mapZerocoinCache[pindex] = ZerocoinCacheEntry{data, lruZerocoin.begin(), false};
+    TrimZerocoinCache();
+    return data;
+}
+
+void CBlockTreeDB::ModifyZerocoinData(CBlockIndex* pindex, const std::function<void(CBlockZerocoinData&)>& modify)
+{
+    LOCK(cs_zerocoin);
+    // Copy on write: readers keep the version they hold and only ever see a complete new one
+    std::shared_ptr<CBlockZerocoinData> data = std::make_shared<CBlockZerocoinData>(*ReadZerocoinData(pindex));
+    modify(*data);
+
+    auto it = mapZerocoinCache.find(pindex);
+    if (it == mapZerocoinCache.end()) {
+        lruZerocoin.push_front(pindex);
+        it = mapZerocoinCache.emplace(pindex, ZerocoinCacheEntry{nullptr, lruZerocoin.begin(), false}).first;
+    }
+    it->second.data = data;
+    it->second.fDirty = true;
+    pindex->nStatus |= BLOCK_HAVE_ZEROCOIN;
+}
+
+void CBlockTreeDB::ClearZerocoinCache()
+{
+    LOCK(cs_zerocoin);
+    mapZerocoinCache.clear();
+    lruZerocoin.clear();
+}
+
+bool CBlockTreeDB::WriteZerocoinState(const CZerocoinStateSnapshot &snapshot) {
+    return Write(DB_ZEROCOIN_STATE, snapshot, true);
+}
+
+bool CBlockTreeDB::ReadZerocoinState(CZerocoinStateSnapshot &snapshot) {
+    return Read(DB_ZEROCOIN_STATE, snapshot);
 }
 
 bool CBlockTreeDB::ReadTxIndex(const uint256 &txid, CDiskTxPos &pos) {
@@ -259,44 +359,63 @@ bool CBlockTreeDB::ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
     return Read(make_pair(DB_SPENTINDEX, key), value);
 }
 
-bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CSpentIndexKey,CSpentIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
-        if (it->second.IsNull()) {
-            batch.Erase(make_pair(DB_SPENTINDEX, it->first));
-        } else {
-            batch.Write(make_pair(DB_SPENTINDEX, it->first), it->second);
-        }
-    }
-    return WriteBatch(batch);
-}
+bool CBlockTreeDB::ReadAddressUnspentIndex(uint256 addressHash, int type,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
 
-bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
-        if (it->second.IsNull()) {
-            batch.Erase(make_pair(DB_ADDRESSUNSPENTINDEX, it->first));
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressUnspentKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
+            CAddressUnspentValue nValue;
+            if (pcursor->GetValue(nValue)) {
+                unspentOutputs.push_back(make_pair(key.second, nValue));
+                pcursor->Next();
+            } else {
+                return error("failed to get address unspent value");
+            }
         } else {
-            batch.Write(make_pair(DB_ADDRESSUNSPENTINDEX, it->first), it->second);
+            break;
         }
     }
-    return WriteBatch(batch);
+
+    return true;
 }
 
-bool CBlockTreeDB::ReadAddressUnspentIndex(uint256 addressHash, int type,
-                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
+/**
+ * Read up to nLimit unspent outputs of an address in key order, from keyStart on if given.
+ * If there are more, sets fMore and keyNext to the key the next page starts at.
+ */
+bool CBlockTreeDB::ReadAddressUnspentIndexPage(uint256 addressHash, int type, const CAddressUnspentKey *pkeyStart, size_t nLimit,
+                                               std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                                               bool &fMore, CAddressUnspentKey &keyNext) {
 
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
 
-    pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    if (pkeyStart) {
+        pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, *pkeyStart));
+    } else {
+        pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
 
+    fMore = false;
+    size_t nRead = 0;
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressUnspentKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash && (int)key.second.type == type) {
+            if (nRead >= nLimit) {
+                fMore = true;
+                keyNext = key.second;
+                break;
+            }
             CAddressUnspentValue nValue;
             if (pcursor->GetValue(nValue)) {
                 unspentOutputs.push_back(make_pair(key.second, nValue));
+                nRead++;
                 pcursor->Next();
             } else {
                 return error("failed to get address unspent value");
@@ -309,18 +428,37 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint256 addressHash, int type,
     return true;
 }
 
-bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-    batch.Write(make_pair(DB_ADDRESSINDEX, it->first), it->second);
-    return WriteBatch(batch);
-}
+void CBlockTreeDB::UpdateAddressBalances(CDBBatch &batch, const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect, bool fErase) {
+    // Totals of the entries by address, counting each transaction once. Entries already
+    // written, or already erased, were counted before, e.g. when a block is indexed again
+    std::map<std::pair<unsigned int, uint256>, CAddressBalanceValue> mapDeltas;
+    std::set<std::tuple<unsigned int, uint256, uint256> > setTxs;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        if (Exists(make_pair(DB_ADDRESSINDEX, it->first)) != fErase)
+            continue;
+        CAddressBalanceValue &delta = mapDeltas[std::make_pair(it->first.type, it->first.hashBytes)];
+        delta.balance += it->second;
+        if (it->second > 0)
+            delta.received += it->second;
+        if (setTxs.insert(std::make_tuple(it->first.type, it->first.hashBytes, it->first.txhash)).second)
+            delta.txCount++;
+    }
 
-bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-    batch.Erase(make_pair(DB_ADDRESSINDEX, it->first));
-    return WriteBatch(batch);
+    for (const auto &item : mapDeltas) {
+        CAddressIndexIteratorKey key(item.first.first, item.first.second);
+        CAddressBalanceValue value;
+        Read(make_pair(DB_ADDRESSBALANCE, key), value);
+
+        int sign = fErase ? -1 : 1;
+        value.balance += sign * item.second.balance;
+        value.received += sign * item.second.received;
+        value.txCount += sign * item.second.txCount;
+
+        if (value.IsNull())
+            batch.Erase(make_pair(DB_ADDRESSBALANCE, key));
+        else
+            batch.Write(make_pair(DB_ADDRESSBALANCE, key), value);
+    }
 }
 
 bool CBlockTreeDB::ReadAddressIndex(uint256 addressHash, int type,
@@ -357,6 +495,152 @@ bool CBlockTreeDB::ReadAddressIndex(uint256 addressHash, int type,
     return true;
 }
 
+/**
+ * Read the index entries of up to nLimit transactions of an address in key order, from keyStart on if given.
+ * A page never ends within the entries of a transaction.
+ * If there are more, sets fMore and keyNext to the key the next page starts at.
+ */
+bool CBlockTreeDB::ReadAddressIndexPage(uint256 addressHash, int type, const CAddressIndexKey *pkeyStart, size_t nLimit,
+                                        std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                                        bool &fMore, CAddressIndexKey &keyNext, int start, int end) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    if (pkeyStart) {
+        pcursor->Seek(make_pair(DB_ADDRESSINDEX, *pkeyStart));
+    } else if (start > 0 && end > 0) {
+        pcursor->Seek(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
+    } else {
+        pcursor->Seek(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
+
+    fMore = false;
+    size_t nRead = 0;
+    uint256 txhashLast;
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash && (int)key.second.type == type) {
+            if (end > 0 && key.second.blockHeight > end) {
+                break;
+            }
+            if (key.second.txhash != txhashLast) {
+                if (nRead >= nLimit) {
+                    fMore = true;
+                    keyNext = key.second;
+                    break;
+                }
+                nRead++;
+            }
+            CAmount nValue;
+            if (pcursor->GetValue(nValue)) {
+                addressIndex.push_back(make_pair(key.second, nValue));
+                txhashLast = key.second.txhash;
+                pcursor->Next();
+            } else {
+                return error("failed to get address index value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Apply the address and spent index changes of a block, writing the address index entries
+ * or erasing them if fErase.
+ */
+bool CBlockTreeDB::WriteInsightIndexes(const std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                                       const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &addressUnspentIndex,
+                                       const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > &spentIndex,
+                                       bool fErase) {
+    CDBBatch batch(*this);
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
+        if (fErase) {
+            batch.Erase(make_pair(DB_ADDRESSINDEX, it->first));
+        } else {
+            batch.Write(make_pair(DB_ADDRESSINDEX, it->first), it->second);
+        }
+    }
+    UpdateAddressBalances(batch, addressIndex, fErase);
+    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=addressUnspentIndex.begin(); it!=addressUnspentIndex.end(); it++) {
+        if (it->second.IsNull()) {
+            batch.Erase(make_pair(DB_ADDRESSUNSPENTINDEX, it->first));
+        } else {
+            batch.Write(make_pair(DB_ADDRESSUNSPENTINDEX, it->first), it->second);
+        }
+    }
+    for (std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >::const_iterator it=spentIndex.begin(); it!=spentIndex.end(); it++) {
+        if (it->second.IsNull()) {
+            batch.Erase(make_pair(DB_SPENTINDEX, it->first));
+        } else {
+            batch.Write(make_pair(DB_SPENTINDEX, it->first), it->second);
+        }
+    }
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::WriteInsightIndexBest(const CBlockLocator &locator) {
+    return Write(DB_INSIGHT_BEST_BLOCK, locator);
+}
+
+bool CBlockTreeDB::ReadInsightIndexBest(CBlockLocator &locator) {
+    return Read(DB_INSIGHT_BEST_BLOCK, locator);
+}
+
+bool CBlockTreeDB::ReadAddressBalance(uint256 addressHash, int type, CAddressBalanceValue &value) {
+    value.SetNull();
+    if (!Exists(make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(type, addressHash))))
+        return true;
+    return Read(make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(type, addressHash)), value);
+}
+
+bool CBlockTreeDB::BuildAddressBalances() {
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(DB_ADDRESSINDEX);
+
+    // Entries are sorted by address, then height and transaction, so each address is summed in one go
+    CDBBatch batch(*this);
+    CAddressIndexIteratorKey keyCurrent;
+    CAddressBalanceValue value;
+    uint256 txhashLast;
+    while (true) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressIndexKey> key;
+        bool fValid = pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX;
+
+        if (!fValid || key.second.type != keyCurrent.type || key.second.hashBytes != keyCurrent.hashBytes) {
+            if (!value.IsNull())
+                batch.Write(make_pair(DB_ADDRESSBALANCE, keyCurrent), value);
+            if (batch.SizeEstimate() > (size_t)nDefaultDbBatchSize) {
+                if (!WriteBatch(batch))
+                    return false;
+                batch.Clear();
+            }
+            if (!fValid)
+                break;
+            keyCurrent = CAddressIndexIteratorKey(key.second.type, key.second.hashBytes);
+            value.SetNull();
+            txhashLast.SetNull();
+        }
+
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue))
+            return error("failed to get address index value");
+        value.balance += nValue;
+        if (nValue > 0)
+            value.received += nValue;
+        if (key.second.txhash != txhashLast) {
+            value.txCount++;
+            txhashLast = key.second.txhash;
+        }
+        pcursor->Next();
+    }
+
+    return WriteBatch(batch, true);
+}
 
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
     CDBBatch batch(*this);
@@ -419,6 +703,14 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
 
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
+    // PoW block headers whose hash has no usable entry in the PoW hash cache
+    std::vector<CBlockIndex*> vPoWToVerify;
+    const bool fUsePoWCache = gArgs.GetBoolArg("-powhashcache", DEFAULT_POWHASH_CACHE);
+
+    // Entries whose zerocoin data is moved out of the block index record
+    CDBBatch batchZerocoin(*this);
+    std::vector<const CBlockIndex*> vZerocoinMoved;
+
     // Load mapBlockIndex
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
@@ -441,10 +733,13 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->nStatus        = diskindex.nStatus;
                 pindexNew->nTx            = diskindex.nTx;
 
-                //zerocoin
-                pindexNew->accumulatorChanges = diskindex.accumulatorChanges;
-                pindexNew->mintedPubCoins     = diskindex.mintedPubCoins;
-                pindexNew->spentSerials       = diskindex.spentSerials;
+                //zerocoin: records written before the data moved to its own
+                //keyspace still carry it inline, move it over
+                if (!diskindex.legacyZerocoin.IsNull()) {
+                    pindexNew->nStatus |= BLOCK_HAVE_ZEROCOIN;
+                    batchZerocoin.Write(std::make_pair(DB_ZEROCOIN_DATA, std::make_pair(pindexNew->nHeight, key.second)), diskindex.legacyZerocoin);
+                    vZerocoinMoved.push_back(pindexNew);
+                }
 
                 //PoS
                 if(diskindex.IsProofOfStake() || diskindex.nHeight >= Params().GetConsensus().nPosHeightActivate){
@@ -453,11 +748,15 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                     pindexNew->prevoutStake             = diskindex.prevoutStake;
                     pindexNew->nMoneySupply             = diskindex.nMoneySupply;
                 }
-                //Check POW limits before PoS onchain
+                //Check POW limits before PoS onchain. The expensive PoW hash is
+                //taken from the cache when present, otherwise it is computed
+                //below once the whole index is loaded.
                 else
                 {
-                    if (!CheckProofOfWork(pindexNew->GetBlockPoWHash(), pindexNew->nBits, consensusParams))
-                        return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+                    uint256 hashPoW;
+                    if (!fUsePoWCache || !Read(std::make_pair(DB_BLOCK_POWHASH, key.second), hashPoW) ||
+                            !CheckProofOfWork(hashPoW, pindexNew->nBits, consensusParams))
+                        vPoWToVerify.push_back(pindexNew);
                 }
 
                 pcursor->Next();
@@ -469,6 +768,47 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
         }
     }
 
+    if (!vZerocoinMoved.empty()) {
+        for (const CBlockIndex* pindex : vZerocoinMoved)
+            batchZerocoin.Write(std::make_pair(DB_BLOCK_INDEX, pindex->GetBlockHash()), CDiskBlockIndex(pindex));
+        if (!WriteBatch(batchZerocoin, true))
+            return error("%s: failed to move zerocoin data out of the block index", __func__);
+        LogPrintf("%s: moved zerocoin data of %u blocks out of the block index\n", __func__, vZerocoinMoved.size());
+    }
+
+    if (vPoWToVerify.empty())
+        return true;
+
+    // All pprev pointers are in place now, so the headers can be rebuilt and
+    // hashed independently of each other.
+    int nThreads = std::max(GetNumCores(), 1);
+    LogPrintf("%s: verifying proof of work of %u block headers using %d threads\n", __func__, vPoWToVerify.size(), nThreads);
+    int64_t nStart = GetTimeMillis();
+    std::vector<uint256> vHashPoW;
+    ComputePoWHashesParallel(vPoWToVerify.size(), [&vPoWToVerify](size_t nBegin, size_t nEnd, uint256* pHashes) {
+        std::vector<CBlockHeader> vHeaders;
+        std::vector<int> vHeights;
+        for (size_t i = nBegin; i < nEnd; i++) {
+            vHeaders.push_back(vPoWToVerify[i]->GetBlockHeader());
+            vHeights.push_back(vPoWToVerify[i]->nHeight);
+        }
+        GetBlockPoWHashes(vHeaders.data(), vHeights.data(), vHeaders.size(), pHashes);
+    }, vHashPoW, nThreads);
+    boost::this_thread::interruption_point();
+
+    CDBBatch batch(*this);
+    for (size_t i = 0; i < vPoWToVerify.size(); i++) {
+        const CBlockIndex* pindex = vPoWToVerify[i];
+        if (!CheckProofOfWork(vHashPoW[i], pindex->nBits, consensusParams))
+            return error("%s: CheckProofOfWork failed: %s", __func__, pindex->ToString());
+        if (fUsePoWCache)
+            batch.Write(std::make_pair(DB_BLOCK_POWHASH, pindex->GetBlockHash()), vHashPoW[i]);
+    }
+    LogPrintf("%s: proof of work verified in %dms\n", __func__, GetTimeMillis() - nStart);
+
+    if (fUsePoWCache && !WriteBatch(batch))
+        LogPrintf("%s: failed to write PoW hash cache\n", __func__);
+
     return true;
 }
 
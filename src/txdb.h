@@ -9,8 +9,12 @@
 #include <coins.h>
 #include <dbwrapper.h>
 #include <chain.h>
+#include <sync.h>
 
+#include <functional>
+#include <list>
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -19,6 +23,7 @@
 
 class CBlockIndex;
 class CCoinsViewDBCursor;
+class CZerocoinStateSnapshot;
 class uint256;
 
 //! No need to periodic flush if at least this much space still available.
@@ -39,6 +44,10 @@ static const int64_t nMaxBlockDBCache = 2;
 static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! -powhashcache default
+static const bool DEFAULT_POWHASH_CACHE = true;
+//! -zerocoindatacache default (number of blocks)
+static const unsigned int DEFAULT_ZEROCOIN_DATA_CACHE = 5000;
 
 struct CDiskTxPos : public CDiskBlockPos
 {
@@ -110,6 +119,24 @@ private:
 /** Access to the block database (blocks/index/) */
 class CBlockTreeDB : public CDBWrapper
 {
+private:
+    struct ZerocoinCacheEntry
+    {
+        std::shared_ptr<CBlockZerocoinData> data;
+        std::list<const CBlockIndex*>::iterator itLRU;
+        bool fDirty;
+    };
+
+    //! Cache of per-block zerocoin data, most recently used at the front of lruZerocoin.
+    //! Dirty entries are never evicted.
+    mutable CCriticalSection cs_zerocoin;
+    std::map<const CBlockIndex*, ZerocoinCacheEntry> mapZerocoinCache;
+    std::list<const CBlockIndex*> lruZerocoin;
+    size_t nZerocoinCacheSize;
+
+    void TrimZerocoinCache();
+    void UpdateAddressBalances(CDBBatch &batch, const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect, bool fErase);
+
 public:
     explicit CBlockTreeDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
 
@@ -124,15 +151,25 @@ public:
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &vect);
     bool ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
-    bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect);
-    bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
     bool ReadAddressUnspentIndex(uint256 addressHash, int type,
                                  std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
-    bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
-    bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
+    bool ReadAddressUnspentIndexPage(uint256 addressHash, int type, const CAddressUnspentKey *pkeyStart, size_t nLimit,
+                                     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect,
+                                     bool &fMore, CAddressUnspentKey &keyNext);
     bool ReadAddressIndex(uint256 addressHash, int type,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                           int start = 0, int end = 0);
+    bool ReadAddressIndexPage(uint256 addressHash, int type, const CAddressIndexKey *pkeyStart, size_t nLimit,
+                              std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                              bool &fMore, CAddressIndexKey &keyNext, int start = 0, int end = 0);
+    bool ReadAddressBalance(uint256 addressHash, int type, CAddressBalanceValue &value);
+    bool BuildAddressBalances();
+    bool WriteInsightIndexes(const std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                             const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &addressUnspentIndex,
+                             const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > &spentIndex,
+                             bool fErase);
+    bool WriteInsightIndexBest(const CBlockLocator &locator);
+    bool ReadInsightIndexBest(CBlockLocator &locator);
 
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
@@ -142,6 +179,22 @@ public:
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+
+    /**
+     * Zerocoin data of a block; empty unless it is flagged BLOCK_HAVE_ZEROCOIN.
+     * Throws dbwrapper_error if the data of a flagged block cannot be read.
+     */
+    std::shared_ptr<const CBlockZerocoinData> ReadZerocoinData(const CBlockIndex* pindex);
+    /**
+     * Apply modify to a copy of the zerocoin data of a block and publish the copy.
+     * Flags the block BLOCK_HAVE_ZEROCOIN; the data is written by the next WriteBatchSync.
+     */
+    void ModifyZerocoinData(CBlockIndex* pindex, const std::function<void(CBlockZerocoinData&)>& modify);
+    //! Drop all cached zerocoin data, including unwritten changes
+    void ClearZerocoinCache();
+
+    bool WriteZerocoinState(const CZerocoinStateSnapshot &snapshot);
+    bool ReadZerocoinState(CZerocoinStateSnapshot &snapshot);
 };
 
 #endif // BITCOIN_TXDB_H
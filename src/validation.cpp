@@ -270,7 +270,7 @@ public:
 
     bool ActivateBestChain(CValidationState &state, const CChainParams& chainparams, std::shared_ptr<const CBlock> pblock);
 
-    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex);
+    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, const uint256* phashPoW = nullptr);
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock);
 
     // Block (dis)connection on a given view:
@@ -341,6 +341,7 @@ uint64_t nPruneTarget = 0;
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
 bool fEnableReplacement = DEFAULT_ENABLE_REPLACEMENT;
 bool fAddressIndex = false;
+bool fAddressIndexKeys = false;
 bool fSpentIndex = false;
 bool fTimestampIndex = false;
 
@@ -1235,6 +1236,30 @@ bool GetAddressIndex(uint256 addressHash, int type,
     return true;
 }
 
+bool GetAddressIndexPage(uint256 addressHash, int type, const CAddressIndexKey *pkeyStart, size_t nLimit,
+                         std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                         bool &fMore, CAddressIndexKey &keyNext, int start, int end)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressIndexPage(addressHash, type, pkeyStart, nLimit, addressIndex, fMore, keyNext, start, end))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool GetAddressBalance(uint256 addressHash, int type, CAddressBalanceValue &value)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressBalance(addressHash, type, value))
+        return error("unable to get balance for address");
+
+    return true;
+}
+
 bool GetAddressUnspent(uint256 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
 {
@@ -1247,6 +1272,19 @@ bool GetAddressUnspent(uint256 addressHash, int type,
     return true;
 }
 
+bool GetAddressUnspentPage(uint256 addressHash, int type, const CAddressUnspentKey *pkeyStart, size_t nLimit,
+                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                           bool &fMore, CAddressUnspentKey &keyNext)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressUnspentIndexPage(addressHash, type, pkeyStart, nLimit, unspentOutputs, fMore, keyNext))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
 /**
  * Return transaction in txOut, and if it was found inside a block, its hash is placed in hashBlock.
  * If blockIndex is provided, the transaction is fetched from the corresponding block.
@@ -1388,7 +1426,7 @@ static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMes
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, const Consensus::Params& consensusParams)
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, const Consensus::Params& consensusParams, bool fCheckPoW)
 {
     block.SetNull();
 
@@ -1406,7 +1444,7 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, con
     }
 
     // Check the header only for PoW blocks
-    if (!block.IsProofOfStake()){
+    if (fCheckPoW && !block.IsProofOfStake()){
         // Check the header
         if (!CheckProofOfWork(block.GetPoWHash(nHeight), block.nBits, consensusParams))
             return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
@@ -1418,12 +1456,19 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, con
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
     CDiskBlockPos blockPos;
+    bool fHeaderValid;
     {
         LOCK(cs_main);
         blockPos = pindex->GetBlockPos();
+        // Headers only enter the index after CheckBlockHeader verified their PoW.
+        // At startup LoadBlockIndexGuts trusts the PoW hashes cached in the block
+        // tree DB, which were only written after that hash met the target, and
+        // recomputes the rest. Comparing the block hash with the index entry below
+        // then ties the data on disk to that header.
+        fHeaderValid = pindex->IsValid(BLOCK_VALID_TREE);
     }
 
-    if (!ReadBlockFromDisk(block, blockPos, pindex->nHeight, consensusParams))
+    if (!ReadBlockFromDisk(block, blockPos, pindex->nHeight, consensusParams, !fHeaderValid))
         return false;
     if (block.GetHash() != pindex->GetBlockHash())
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
@@ -1792,6 +1837,18 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
     return true;
 }
 
+/** Abort with a message */
+bool AbortNode(const std::string& strMessage, const std::string& userMessage)
+{
+    SetMiscWarning(strMessage);
+    LogPrintf("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(
+        userMessage.empty() ? _("Error: A fatal internal error occurred, see debug.log for details") : userMessage,
+        "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+    return false;
+}
+
 namespace {
 
 bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint256& hashBlock, const CMessageHeader::MessageStartChars& messageStart)
@@ -1821,7 +1878,15 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
-static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
+bool AbortNode(CValidationState& state, const std::string& strMessage, const std::string& userMessage="")
+{
+    ::AbortNode(strMessage, userMessage);
+    return state.Error(strMessage);
+}
+
+} // namespace
+
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
 {
     CDiskBlockPos pos = pindex->GetUndoPos();
     if (pos.IsNull()) {
@@ -1852,26 +1917,6 @@ static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
     return true;
 }
 
-/** Abort with a message */
-bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
-{
-    SetMiscWarning(strMessage);
-    LogPrintf("*** %s\n", strMessage);
-    uiInterface.ThreadSafeMessageBox(
-        userMessage.empty() ? _("Error: A fatal internal error occurred, see debug.log for details") : userMessage,
-        "", CClientUIInterface::MSG_ERROR);
-    StartShutdown();
-    return false;
-}
-
-bool AbortNode(CValidationState& state, const std::string& strMessage, const std::string& userMessage="")
-{
-    AbortNode(strMessage, userMessage);
-    return state.Error(strMessage);
-}
-
-} // namespace
-
 /**
  * Restore the UTXO in a Coin at a given COutPoint
  * @param undo The Coin to be restored.
@@ -1952,28 +1997,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
             }
         }
 
-        if (fAddressIndex) {
-            for (unsigned int k = tx.vout.size(); k-- > 0;) {
-                const CTxOut &out = tx.vout[k];
-
-                std::vector<uint8_t> hashBytes;
-                int scriptType = 0;
-                const Coin &coin = view.AccessCoin(tx.vin[k].prevout);
-                const CScript *pScript = &coin.out.scriptPubKey;
-                if (!ExtractIndexInfo(pScript, scriptType, hashBytes)
-                        || scriptType == 0)
-                    continue;
-
-                // undo receiving activity
-                view.addressIndex.push_back(make_pair(CAddressIndexKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), pindex->nHeight, i, hash, k, false), out.nValue));
-
-                // undo unspent index
-                view.addressUnspentIndex.push_back(make_pair(CAddressUnspentKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), hash, k), CAddressUnspentValue()));
-
-            }
-
-        }
-
         // restore inputs
         if (!tx.IsCoinBase() && !tx.IsZerocoinSpend()) { // not coinbases
             CTxUndo &txundo = blockUndo.vtxundo[block.IsProofOfStake() ? i: i-1];
@@ -1986,29 +2009,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
                 int res = ApplyTxInUndo(std::move(txundo.vprevout[j]), view, out);
                 if (res == DISCONNECT_FAILED) return DISCONNECT_FAILED;
                 fClean = fClean && res != DISCONNECT_UNCLEAN;
-                const CTxIn input = tx.vin[j];
-
-                if (fSpentIndex) // undo and delete the spent index
-                    view.spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue()));
-
-                if (fAddressIndex)
-                {
-                    const Coin &coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CScript *pScript = &coin.out.scriptPubKey;
-
-                    CAmount nValue = coin.out.nValue;
-                    std::vector<uint8_t> hashBytes;
-                    int scriptType = 0;
-                    if (!ExtractIndexInfo(pScript, scriptType, hashBytes)
-                            || scriptType == 0)
-                        continue;
-
-                    // undo spending activity
-                    view.addressIndex.push_back(std::make_pair(CAddressIndexKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), pindex->nHeight, i, hash, j, true), nValue * -1));
-                    // restore unspent index
-                    view.addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), input.prevout.hash, input.prevout.n), CAddressUnspentValue(nValue, *pScript, coin.nHeight)));
-                }
-
             }
             // At this point, all of txundo.vprevout should have been moved out.
         }
@@ -2091,6 +2091,13 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+static CCheckQueue<CZerocoinSpendCheck> zerocoinspendcheckqueue(1);
+
+void ThreadZerocoinSpendCheck() {
+    RenameThread("subi-zcspendch");
+    zerocoinspendcheckqueue.Thread();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2493,46 +2500,8 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                 return state.DoS(100, error("%s: contains a non-BIP68-final transaction", __func__),
                                  REJECT_INVALID, "bad-txns-nonfinal");
             }
-
-            // Update spent inputs for insight
-            for (size_t j = 0; j < tx.vin.size(); j++)
-            {
-                const CTxIn input = tx.vin[j];
-
-                const Coin &coin = view.AccessCoin(input.prevout);
-                const CScript *pScript = &coin.out.scriptPubKey;
-
-                CAmount nValue = coin.out.nValue;
-                std::vector<uint8_t> hashBytes;
-                int scriptType = 0;
-
-                if (!ExtractIndexInfo(pScript, scriptType, hashBytes)
-                        || scriptType == 0)
-                    continue;
-
-                uint256 hashAddress;
-                if (scriptType > 0)
-                    hashAddress = uint256(hashBytes.data(), hashBytes.size());
-
-                if (fAddressIndex && scriptType > 0)
-                {
-                    // record spending activity
-                    view.addressIndex.push_back(std::make_pair(CAddressIndexKey(scriptType, hashAddress, pindex->nHeight, i, txHash, j, true), nValue * -1));
-                    // remove address from unspent index
-                    view.addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(scriptType, hashAddress, input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
-                };
-
-                if (fSpentIndex)
-                {
-                    CAmount nValue = coin.out.nValue;
-                    // add the spent index to determine the txid and input that spent an output
-                    // and to find the amount and address from an input
-                    view.spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(txHash, j, pindex->nHeight, nValue, scriptType, hashAddress)));
-                }
-            }
         }
 
-
         // GetTransactionSigOpCost counts 3 types of sigops:
         // * legacy (always)
         // * p2sh (when P2SH enabled in flags and excludes coinbase)
@@ -2564,33 +2533,6 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         }
         if(tx.IsCoinBase())
             UpdateCoins(tx, view, undoDummy , pindex->nHeight);
-
-
-
-        if (fAddressIndex)
-        {
-            // Update outputs for insight
-            for (unsigned int k = 0; k < tx.vout.size(); k++)
-            {
-                const CTxOut *out = &tx.vout[k];
-
-                CAmount nValue;
-                std::vector<uint8_t> hashBytes;
-                int scriptType = 0;
-                const Coin &coin = view.AccessCoin(tx.vin[k].prevout);
-                const CScript *pScript = &coin.out.scriptPubKey;
-                if (!ExtractIndexInfo(out, scriptType, hashBytes, nValue, pScript)
-                        || scriptType == 0)
-                    continue;
-
-                // record receiving activity
-                view.addressIndex.push_back(std::make_pair(CAddressIndexKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), pindex->nHeight, i, txHash, k, false), nValue));
-                // record unspent output
-                view.addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), txHash, k), CAddressUnspentValue(nValue, *pScript, pindex->nHeight)));
-            }
-        }
-
-
     }
 
     int64_t nTime3 = GetTimeMicros(); nTimeConnect += nTime3 - nTime2;
@@ -2768,17 +2710,6 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         return false;
 
 
-    if (fTimestampIndex)
-    {
-
-        if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
-            return AbortNode(state, "Failed to write timestamp index");
-
-        if (!pblocktree->WriteTimestampBlockIndex(CTimestampBlockIndexKey(pindex->GetBlockHash()), CTimestampBlockIndexValue(pindex->nTime)))
-            return AbortNode(state, "Failed to write blockhash index");
-    }
-
-
     assert(pindex->phashBlock);
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
@@ -2932,6 +2863,9 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
             // overwrite one. Still, use a conservative safety factor of 2.
             if (!CheckDiskSpace(48 * 2 * 2 * pcoinsTip->GetCacheSize()))
                 return state.Error("out of disk space");
+            // Store the zerocoin state so the next start only replays the blocks after it.
+            if (!ZerocoinWriteStateSnapshot(pcoinsTip->GetBestBlock()))
+                return AbortNode(state, "Failed to write zerocoin state");
             // Flush the chainstate (which may refer to block index entries).
             if (!pcoinsTip->Flush())
                 return AbortNode(state, "Failed to write to coin database");
@@ -2972,40 +2906,6 @@ static void DoWarning(const std::string& strWarning)
     }
 }
 
-bool FlushView(CCoinsViewCache *view, CValidationState& state, bool fDisconnecting)
-{
-    if (!view->Flush())
-        return false;
-
-    if (fAddressIndex)
-    {
-        if (fDisconnecting)
-        {
-            if (!pblocktree->EraseAddressIndex(view->addressIndex))
-                return AbortNode(state, "Failed to delete address index");
-        } else
-        {
-            if (!pblocktree->WriteAddressIndex(view->addressIndex))
-                return AbortNode(state, "Failed to write address index");
-        };
-
-        if (!pblocktree->UpdateAddressUnspentIndex(view->addressUnspentIndex))
-            return AbortNode(state, "Failed to write address unspent index");
-    };
-
-    if (fSpentIndex)
-    {
-        if (!pblocktree->UpdateSpentIndex(view->spentIndex))
-            return AbortNode(state, "Failed to write transaction index");
-    };
-
-    view->addressIndex.clear();
-    view->addressUnspentIndex.clear();
-    view->spentIndex.clear();
-
-    return true;
-};
-
 /** Check warning conditions and do some notifications on new chain tip set. */
 void static UpdateTip(const CBlockIndex *pindexNew, const CChainParams& chainParams) {
 
@@ -3092,7 +2992,7 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
         assert(view.GetBestBlock() == pindexDelete->GetBlockHash());
         if (DisconnectBlock(block, pindexDelete, view) != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
-        bool flushed = FlushView(&view, state, true);
+        bool flushed = view.Flush();
         assert(flushed);
     }
 
@@ -3248,7 +3148,7 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         }
         nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTime2;
         LogPrint(BCLog::BENCH, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime3 - nTime2) * MILLI, nTimeConnectTotal * MICRO, nTimeConnectTotal * MILLI / nBlocksTotal);
-        bool flushed = FlushView(&view, state, false);
+        bool flushed = view.Flush();
         assert(flushed);
     }
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
@@ -3847,7 +3747,11 @@ static bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos,
     return true;
 }
 
-static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true)
+/**
+ * phashPoW optionally carries the PoW hash of the header, computed ahead of time
+ * for the height this function derives from mapBlockIndex.
+ */
+static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, const uint256* phashPoW = nullptr)
 {
 
     // Get prev block index
@@ -3862,7 +3766,7 @@ static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state,
 
     // Check proof of work matches claimed amount
     if(nHeight < consensusParams.nPosHeightActivate){
-        if (fCheckPOW && !CheckProofOfWork(block.GetPoWHash(nHeight), block.nBits, consensusParams))
+        if (fCheckPOW && !CheckProofOfWork(phashPoW ? *phashPoW : block.GetPoWHash(nHeight), block.nBits, consensusParams))
             return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
     }
     else{
@@ -4040,15 +3944,29 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
     //Ignore checks on startup sync
     if(IsInitialBlockDownload())
         nHeight == INT_MAX - 1;
+    // Spend proofs are collected and verified together on the zerocoin check threads
+    block.zerocoinTxInfo->spendChecks.clear();
+    block.zerocoinTxInfo->fDeferSpendChecks = nScriptCheckThreads > 0;
     // Check transactions
     for (const auto& tx : block.vtx){
         if (!CheckTransaction(*tx, state, tx->GetHash(), isVerifyDB, true, nHeight, false, block.zerocoinTxInfo.get())){
+            block.zerocoinTxInfo->fDeferSpendChecks = false;
+            block.zerocoinTxInfo->spendChecks.clear();
             return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(),
                                  strprintf("Transaction check failed (tx hash %s) %s", tx->GetHash().ToString(), state.GetDebugMessage()));
         }
         if(tx->IsZerocoinMint())
             blockHasMint = true;
     }
+    block.zerocoinTxInfo->fDeferSpendChecks = false;
+
+    if (!block.zerocoinTxInfo->spendChecks.empty()) {
+        CCheckQueueControl<CZerocoinSpendCheck> control(&zerocoinspendcheckqueue);
+        control.Add(block.zerocoinTxInfo->spendChecks);
+        block.zerocoinTxInfo->spendChecks.clear();
+        if (!control.Wait())
+            return state.Invalid(false, REJECT_INVALID, "bad-zerocoin-spend", "zerocoin spend proof verification failed");
+    }
 
     block.zerocoinTxInfo->Complete();
 
@@ -4301,7 +4219,7 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     return true;
 }
 
-bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, const uint256* phashPoW)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -4320,7 +4238,7 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), true, phashPoW))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -4360,15 +4278,68 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
     return true;
 }
 
+/**
+ * Compute the PoW hashes of a batch of headers on the -par worker threads, outside
+ * cs_main. Returns one entry per header; entries are null for headers that are
+ * already known, are not PoW checked, or do not extend the previous header.
+ */
+static std::vector<uint256> ComputeHeaderPoWHashes(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams)
+{
+    std::vector<uint256> vHashPoW(headers.size());
+    if (headers.size() < 2)
+        return vHashPoW;
+
+    // Heights must match those CheckBlockHeader derives once the preceding
+    // headers of the batch are in mapBlockIndex.
+    std::vector<int> vHeight(headers.size(), -1);
+    std::vector<size_t> vToHash;
+    {
+        LOCK(cs_main);
+        uint256 hashPrev;
+        for (size_t i = 0; i < headers.size(); i++) {
+            uint256 hash = headers[i].GetHash();
+            if (i == 0) {
+                BlockMap::iterator mi = mapBlockIndex.find(headers[i].hashPrevBlock);
+                if (mi != mapBlockIndex.end())
+                    vHeight[i] = mi->second->nHeight + 1;
+            } else if (vHeight[i - 1] >= 0 && headers[i].hashPrevBlock == hashPrev) {
+                vHeight[i] = vHeight[i - 1] + 1;
+            }
+            hashPrev = hash;
+            if (vHeight[i] >= 0 && vHeight[i] < consensusParams.nPosHeightActivate && !mapBlockIndex.count(hash))
+                vToHash.push_back(i);
+        }
+    }
+
+    if (vToHash.size() < 2)
+        return vHashPoW;
+
+    std::vector<uint256> vHashed;
+    ComputePoWHashesParallel(vToHash.size(), [&](size_t nBegin, size_t nEnd, uint256* pHashes) {
+        std::vector<CBlockHeader> vHeaders;
+        std::vector<int> vHeights;
+        for (size_t i = nBegin; i < nEnd; i++) {
+            vHeaders.push_back(headers[vToHash[i]]);
+            vHeights.push_back(vHeight[vToHash[i]]);
+        }
+        GetBlockPoWHashes(vHeaders.data(), vHeights.data(), vHeaders.size(), pHashes);
+    }, vHashed, std::max(nScriptCheckThreads, 1));
+    for (size_t i = 0; i < vToHash.size(); i++)
+        vHashPoW[vToHash[i]] = vHashed[i];
+    return vHashPoW;
+}
+
 // Exposed wrapper for AcceptBlockHeader
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+    const std::vector<uint256> vHashPoW = ComputeHeaderPoWHashes(headers, chainparams.GetConsensus());
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); i++) {
+            const CBlockHeader& header = headers[i];
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex, vHashPoW[i].IsNull() ? nullptr : &vHashPoW[i])) {
                 if (first_invalid) *first_invalid = header;
                 return false;
             }
@@ -4905,6 +4876,20 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     pblocktree->ReadFlag("addressindex", fAddressIndex);
     LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
 
+    // Address indexes from before all the key forms were indexed hold P2PKH and P2SH outputs only
+    pblocktree->ReadFlag("addressindexkeys", fAddressIndexKeys);
+
+    // Address indexes from before the per-address balances were kept need them built once
+    if (fAddressIndex) {
+        bool fAddressBalance = false;
+        pblocktree->ReadFlag("addressbalance", fAddressBalance);
+        if (!fAddressBalance) {
+            LogPrintf("%s: building address balances from the address index...\n", __func__);
+            if (!pblocktree->BuildAddressBalances() || !pblocktree->WriteFlag("addressbalance", true))
+                return error("%s: failed to build address balances", __func__);
+        }
+    }
+
     // Check whether we have a timestamp index
     pblocktree->ReadFlag("timestampindex", fTimestampIndex);
     LogPrintf("%s: timestamp index %s\n", __func__, fTimestampIndex ? "enabled" : "disabled");
@@ -5291,6 +5276,8 @@ void UnloadBlockIndex()
     }
     mapBlockIndex.clear();
     fHavePruned = false;
+    if (pblocktree)
+        pblocktree->ClearZerocoinCache();
 
     g_chainstate.UnloadBlockIndex();
 }
@@ -5321,6 +5308,9 @@ bool LoadBlockIndex(const CChainParams& chainparams)
         // Use the provided setting for -addressindex in the new database
         fAddressIndex = gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
         pblocktree->WriteFlag("addressindex", fAddressIndex);
+        pblocktree->WriteFlag("addressbalance", fAddressIndex);
+        fAddressIndexKeys = fAddressIndex;
+        pblocktree->WriteFlag("addressindexkeys", fAddressIndexKeys);
         LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
 
         // Use the provided setting for -timestampindex in the new database
@@ -5332,6 +5322,9 @@ bool LoadBlockIndex(const CChainParams& chainparams)
         fSpentIndex = gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
         pblocktree->WriteFlag("spentindex", fSpentIndex);
         LogPrintf("%s: spent index %s\n", __func__, fSpentIndex ? "enabled" : "disabled");
+
+        // The address, timestamp and spent indexes of the new database are written by the insight indexer
+        pblocktree->WriteFlag("insightindexer", true);
     }
     return true;
 }
@@ -35,6 +35,7 @@
 
 class CBlockIndex;
 class CBlockTreeDB;
+class CBlockUndo;
 class CChainParams;
 class CCoinsViewDB;
 class CInv;
@@ -209,6 +210,8 @@ extern std::atomic_bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
 extern bool fAddressIndex;
+/** Whether the address index holds every output script form ExtractIndexInfo indexes */
+extern bool fAddressIndexKeys;
 extern bool fSpentIndex;
 extern bool fTimestampIndex;
 extern bool fIsBareMultisigStd;
@@ -320,6 +323,8 @@ bool LoadChainTip(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the zerocoin spend proof checking thread */
+void ThreadZerocoinSpendCheck();
 /** Return the average number of blocks that other nodes claim to have */
 int GetNumBlocksOfPeers();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
@@ -347,6 +352,9 @@ void PruneOneBlockFile(const int fileNumber);
  */
 void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune);
 
+/** Set a warning, tell the user about a fatal error and shut the node down. Always returns false. */
+bool AbortNode(const std::string& strMessage, const std::string& userMessage = "");
+
 /** Flush all state, indexes and buffers to disk. */
 void FlushStateToDisk();
 /** Prune block files and flush state to disk. */
@@ -451,10 +459,24 @@ bool GetAddressIndex(uint256 addressHash, int type,
                      int start = 0, int end = 0);
 bool GetAddressUnspent(uint256 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
+bool GetAddressIndexPage(uint256 addressHash, int type, const CAddressIndexKey *pkeyStart, size_t nLimit,
+                         std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                         bool &fMore, CAddressIndexKey &keyNext, int start = 0, int end = 0);
+bool GetAddressUnspentPage(uint256 addressHash, int type, const CAddressUnspentKey *pkeyStart, size_t nLimit,
+                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                           bool &fMore, CAddressUnspentKey &keyNext);
+bool GetAddressBalance(uint256 addressHash, int type, CAddressBalanceValue &value);
 
 /** Functions for disk access for blocks */
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, const Consensus::Params& consensusParams);
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, const Consensus::Params& consensusParams, bool fCheckPoW = true);
+/**
+ * Read the block an index entry points to. The PoW hash is not recomputed when the
+ * index entry's header was already validated; the block hash comparison against
+ * the index then guarantees the data on disk belongs to that header.
+ */
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+/** Read the undo data of a block, the coins it spent */
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -9,7 +9,7 @@
  * network protocol versioning
  */
 
-static const int PROTOCOL_VERSION = 70021;
+static const int PROTOCOL_VERSION = 70022;
 
 //! minimum DPoS protocol version
 static const int MIN_PEER_DPOS_PROTO_VERSION = 70021;
@@ -48,4 +48,7 @@ static const int SHORT_IDS_BLOCKS_VERSION = 70014;
 //! not banning for invalid compact blocks starts with this version
 static const int INVALID_CB_NO_BAN_VERSION = 70015;
 
+//! "mnlget" and "mnlist" subinode list sync starts with this version
+static const int MNLIST_VERSION = 70022;
+
 #endif // BITCOIN_VERSION_H
@@ -93,6 +93,14 @@ bool GetWalletAddressesForKey(CWallet * const pwallet, const CKeyID &keyid, std:
 }
 
 
+/** Rescan for newly imported scripts, through the address index if possible */
+static void RescanForScripts(CWallet* const pwallet, const std::vector<CScript>& vScripts, const WalletRescanReserver& reserver)
+{
+    if (!pwallet->RescanFromAddressIndex(vScripts, reserver, true /* update */)) {
+        pwallet->RescanFromTime(TIMESTAMP_MIN, reserver, true /* update */);
+    }
+}
+
 UniValue importprivkey(const JSONRPCRequest& request)
 {
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
@@ -110,6 +118,9 @@ UniValue importprivkey(const JSONRPCRequest& request)
             "3. rescan               (boolean, optional, default=true) Rescan the wallet for transactions\n"
             "\nNote: This call can take minutes to complete if rescan is true, during that time, other rpc calls\n"
             "may report that the imported key exists but related transactions are still missing, leading to temporarily incorrect/bogus balances and unspent outputs until rescan completes.\n"
+            "With -addressindex the rescan reads only the blocks the address index lists for the import. Address indexes\n"
+            "built before they covered pay to pubkey, witness, timelocked and cold stake outputs need -reindex for this,\n"
+            "until then every block is scanned.\n"
             "\nExamples:\n"
             "\nDump a private key\n"
             + HelpExampleCli("dumpprivkey", "\"myaddress\"") +
@@ -126,6 +137,7 @@ UniValue importprivkey(const JSONRPCRequest& request)
 
     WalletRescanReserver reserver(pwallet);
     bool fRescan = true;
+    std::vector<CScript> vScripts;
     {
         LOCK2(cs_main, pwallet->cs_wallet);
 
@@ -163,7 +175,9 @@ UniValue importprivkey(const JSONRPCRequest& request)
             // We don't know which corresponding address will be used; label them all
             for (const auto& dest : GetAllDestinationsForKey(pubkey)) {
                 pwallet->SetAddressBook(dest, strLabel, "receive");
+                vScripts.push_back(GetScriptForDestination(dest));
             }
+            vScripts.push_back(GetScriptForRawPubKey(pubkey));
 
             // Don't throw error in case a key is already there
             if (pwallet->HaveKey(vchAddress)) {
@@ -181,7 +195,7 @@ UniValue importprivkey(const JSONRPCRequest& request)
         }
     }
     if (fRescan) {
-        pwallet->RescanFromTime(TIMESTAMP_MIN, reserver, true /* update */);
+        RescanForScripts(pwallet, vScripts, reserver);
     }
 
     return NullUniValue;
@@ -266,6 +280,9 @@ UniValue importaddress(const JSONRPCRequest& request)
             "4. p2sh                 (boolean, optional, default=false) Add the P2SH version of the script as well\n"
             "\nNote: This call can take minutes to complete if rescan is true, during that time, other rpc calls\n"
             "may report that the imported address exists but related transactions are still missing, leading to temporarily incorrect/bogus balances and unspent outputs until rescan completes.\n"
+            "With -addressindex the rescan reads only the blocks the address index lists for the import. Address indexes\n"
+            "built before they covered pay to pubkey, witness, timelocked and cold stake outputs need -reindex for this,\n"
+            "until then every block is scanned.\n"
             "If you have the full public key, you should call importpubkey instead of this.\n"
             "\nNote: If you import a non-standard raw script in hex form, outputs sending to it will be treated\n"
             "as change, and not show up in many RPCs.\n"
@@ -301,6 +318,7 @@ UniValue importaddress(const JSONRPCRequest& request)
     if (!request.params[3].isNull())
         fP2SH = request.params[3].get_bool();
 
+    std::vector<CScript> vScripts;
     {
         LOCK2(cs_main, pwallet->cs_wallet);
 
@@ -310,16 +328,21 @@ UniValue importaddress(const JSONRPCRequest& request)
                 throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Cannot use the p2sh flag with an address - use a script instead");
             }
             ImportAddress(pwallet, dest, strLabel);
+            vScripts.push_back(GetScriptForDestination(dest));
         } else if (IsHex(request.params[0].get_str())) {
             std::vector<unsigned char> data(ParseHex(request.params[0].get_str()));
-            ImportScript(pwallet, CScript(data.begin(), data.end()), strLabel, fP2SH);
+            CScript script(data.begin(), data.end());
+            ImportScript(pwallet, script, strLabel, fP2SH);
+            vScripts.push_back(script);
+            if (fP2SH)
+                vScripts.push_back(GetScriptForDestination(CScriptID(script)));
         } else {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid SUBI address or script");
         }
     }
     if (fRescan)
     {
-        pwallet->RescanFromTime(TIMESTAMP_MIN, reserver, true /* update */);
+        RescanForScripts(pwallet, vScripts, reserver);
         pwallet->ReacceptWalletTransactions();
     }
 
@@ -442,6 +465,9 @@ UniValue importpubkey(const JSONRPCRequest& request)
             "3. rescan               (boolean, optional, default=true) Rescan the wallet for transactions\n"
             "\nNote: This call can take minutes to complete if rescan is true, during that time, other rpc calls\n"
             "may report that the imported pubkey exists but related transactions are still missing, leading to temporarily incorrect/bogus balances and unspent outputs until rescan completes.\n"
+            "With -addressindex the rescan reads only the blocks the address index lists for the import. Address indexes\n"
+            "built before they covered pay to pubkey, witness, timelocked and cold stake outputs need -reindex for this,\n"
+            "until then every block is scanned.\n"
             "\nExamples:\n"
             "\nImport a public key with rescan\n"
             + HelpExampleCli("importpubkey", "\"mypubkey\"") +
@@ -476,18 +502,21 @@ UniValue importpubkey(const JSONRPCRequest& request)
     if (!pubKey.IsFullyValid())
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Pubkey is not a valid public key");
 
+    std::vector<CScript> vScripts;
     {
         LOCK2(cs_main, pwallet->cs_wallet);
 
         for (const auto& dest : GetAllDestinationsForKey(pubKey)) {
             ImportAddress(pwallet, dest, strLabel);
+            vScripts.push_back(GetScriptForDestination(dest));
         }
         ImportScript(pwallet, GetScriptForRawPubKey(pubKey), strLabel, false);
+        vScripts.push_back(GetScriptForRawPubKey(pubKey));
         pwallet->LearnAllRelatedScripts(pubKey);
     }
     if (fRescan)
     {
-        pwallet->RescanFromTime(TIMESTAMP_MIN, reserver, true /* update */);
+        RescanForScripts(pwallet, vScripts, reserver);
         pwallet->ReacceptWalletTransactions();
     }
 
@@ -796,7 +825,7 @@ UniValue dumpwallet(const JSONRPCRequest& request)
 }
 
 
-UniValue ProcessImport(CWallet * const pwallet, const UniValue& data, const int64_t timestamp)
+UniValue ProcessImport(CWallet * const pwallet, const UniValue& data, const int64_t timestamp, std::vector<CScript>& vScriptsImported)
 {
     try {
         bool success = false;
@@ -824,6 +853,8 @@ UniValue ProcessImport(CWallet * const pwallet, const UniValue& data, const int6
         // Parse the output.
         CScript script;
         CTxDestination dest;
+        // scripts the wallet matches outputs of after this import
+        std::vector<CScript> vScripts;
 
         if (!isScript) {
             dest = DecodeDestination(output);
@@ -883,6 +914,7 @@ UniValue ProcessImport(CWallet * const pwallet, const UniValue& data, const int6
             if (!pwallet->AddWatchOnly(redeemScript, timestamp)) {
                 throw JSONRPCError(RPC_WALLET_ERROR, "Error adding address to wallet");
             }
+            vScripts.push_back(redeemScript);
 
             if (!pwallet->HaveCScript(redeemScript) && !pwallet->AddCScript(redeemScript)) {
                 throw JSONRPCError(RPC_WALLET_ERROR, "Error adding p2sh redeemScript to wallet");
@@ -940,6 +972,8 @@ UniValue ProcessImport(CWallet * const pwallet, const UniValue& data, const int6
                     if (!pwallet->AddKeyPubKey(key, pubkey)) {
                         throw JSONRPCError(RPC_WALLET_ERROR, "Error adding key to wallet");
                     }
+                    vScripts.push_back(GetScriptForDestination(vchAddress));
+                    vScripts.push_back(GetScriptForRawPubKey(pubkey));
 
                     pwallet->UpdateTimeFirstKey(timestamp);
                 }
@@ -991,6 +1025,7 @@ UniValue ProcessImport(CWallet * const pwallet, const UniValue& data, const int6
                 if (!pwallet->AddWatchOnly(pubKeyScript, timestamp)) {
                     throw JSONRPCError(RPC_WALLET_ERROR, "Error adding address to wallet");
                 }
+                vScripts.push_back(pubKeyScript);
 
                 // add to address book or update label
                 if (IsValidDestination(pubkey_dest)) {
@@ -1009,6 +1044,7 @@ UniValue ProcessImport(CWallet * const pwallet, const UniValue& data, const int6
                 if (!pwallet->AddWatchOnly(scriptRawPubKey, timestamp)) {
                     throw JSONRPCError(RPC_WALLET_ERROR, "Error adding address to wallet");
                 }
+                vScripts.push_back(scriptRawPubKey);
 
                 success = true;
             }
@@ -1064,6 +1100,8 @@ UniValue ProcessImport(CWallet * const pwallet, const UniValue& data, const int6
                 if (!pwallet->AddKeyPubKey(key, pubKey)) {
                     throw JSONRPCError(RPC_WALLET_ERROR, "Error adding key to wallet");
                 }
+                vScripts.push_back(GetScriptForDestination(vchAddress));
+                vScripts.push_back(GetScriptForRawPubKey(pubKey));
 
                 pwallet->UpdateTimeFirstKey(timestamp);
 
@@ -1093,6 +1131,11 @@ UniValue ProcessImport(CWallet * const pwallet, const UniValue& data, const int6
             }
         }
 
+        if (success) {
+            vScriptsImported.push_back(script);
+            vScriptsImported.insert(vScriptsImported.end(), vScripts.begin(), vScripts.end());
+        }
+
         UniValue result = UniValue(UniValue::VOBJ);
         result.pushKV("success", UniValue(success));
         return result;
@@ -1161,6 +1204,9 @@ UniValue importmulti(const JSONRPCRequest& mainRequest)
             "  }\n"
             "\nNote: This call can take minutes to complete if rescan is true, during that time, other rpc calls\n"
             "may report that the imported keys, addresses or scripts exists but related transactions are still missing.\n"
+            "With -addressindex the rescan reads only the blocks the address index lists for the import. Address indexes\n"
+            "built before they covered pay to pubkey, witness, timelocked and cold stake outputs need -reindex for this,\n"
+            "until then every block is scanned.\n"
             "\nExamples:\n" +
             HelpExampleCli("importmulti", "'[{ \"scriptPubKey\": { \"address\": \"<my address>\" }, \"timestamp\":1455191478 }, "
                                           "{ \"scriptPubKey\": { \"address\": \"<my 2nd address>\" }, \"label\": \"example 2\", \"timestamp\": 1455191480 }]'") +
@@ -1194,6 +1240,7 @@ UniValue importmulti(const JSONRPCRequest& mainRequest)
     int64_t now = 0;
     bool fRunScan = false;
     int64_t nLowestTimestamp = 0;
+    std::vector<CScript> vScripts;
     UniValue response(UniValue::VARR);
     {
         LOCK2(cs_main, pwallet->cs_wallet);
@@ -1215,7 +1262,7 @@ UniValue importmulti(const JSONRPCRequest& mainRequest)
 
         for (const UniValue& data : requests.getValues()) {
             const int64_t timestamp = std::max(GetImportTimestamp(data, now), minimumTimestamp);
-            const UniValue result = ProcessImport(pwallet, data, timestamp);
+            const UniValue result = ProcessImport(pwallet, data, timestamp, vScripts);
             response.push_back(result);
 
             if (!fRescan) {
@@ -1234,7 +1281,10 @@ UniValue importmulti(const JSONRPCRequest& mainRequest)
         }
     }
     if (fRescan && fRunScan && requests.size()) {
-        int64_t scannedTime = pwallet->RescanFromTime(nLowestTimestamp, reserver, true /* update */);
+        int64_t scannedTime = nLowestTimestamp;
+        if (!pwallet->RescanFromAddressIndex(vScripts, reserver, true /* update */)) {
+            scannedTime = pwallet->RescanFromTime(nLowestTimestamp, reserver, true /* update */);
+        }
         pwallet->ReacceptWalletTransactions();
 
         if (scannedTime > nLowestTimestamp) {
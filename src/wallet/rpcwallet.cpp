@@ -21,6 +21,7 @@
 #include <rpc/util.h>
 #include <script/sign.h>
 #include <timedata.h>
+#include <txdb.h>
 #include <util.h>
 #include <utilmoneystr.h>
 #include <wallet/coincontrol.h>
@@ -4732,6 +4733,78 @@ UniValue getstakinginfo(const JSONRPCRequest &request)
     return obj;
 }
 
+UniValue getstakingstats(const JSONRPCRequest &request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "getstakingstats ( reset )\n"
+            "Returns counters and latencies of the staking threads of this node.\n"
+            "\nArguments:\n"
+            "1. reset                          (boolean, optional, default=false) start counting again after returning the current values\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"uptime\": n,                  (numeric) seconds since counting started\n"
+            "  \"rounds\": n,                  (numeric) number of staking rounds (SignBlock calls)\n"
+            "  \"kernelshashed\": n,           (numeric) number of kernel hashes computed\n"
+            "  \"hashespersec\": n,            (numeric) kernel hashes per second while searching\n"
+            "  \"kernelspersec\": n,           (numeric) kernel hashes per second since counting started\n"
+            "  \"stakesfound\": n,             (numeric) number of kernels found and signed\n"
+            "  \"stakesaccepted\": n,          (numeric) number of found stakes accepted as a new tip\n"
+            "  \"stakesrejected\": n,          (numeric) number of found stakes not accepted, e.g. stale\n"
+            "  \"stakesorphaned\": n,          (numeric) number of recent accepted stakes no longer in the active chain\n"
+            "  \"phases\": {                   (object) latencies of the phases of the stake loop\n"
+            "    \"name\": {                   (string) lockwait, createblock, selectcoins, kernelsearch or signblock\n"
+            "      \"count\": n,               (numeric) number of times the phase ran\n"
+            "      \"totalms\": x.xxx,         (numeric) total time in milliseconds\n"
+            "      \"avgms\": x.xxx,           (numeric) average time in milliseconds\n"
+            "      \"maxms\": x.xxx,           (numeric) longest time in milliseconds\n"
+            "      \"histogram\": [n,...]      (array) counts of times below 1ms, 2ms, 4ms, ... the last one all longer ones\n"
+            "    }, ...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getstakingstats", "")
+            + HelpExampleCli("getstakingstats", "true")
+            + HelpExampleRpc("getstakingstats", ""));
+
+    StakingStats stats = stakingTelemetry.GetStats();
+    if (!request.params[0].isNull() && request.params[0].get_bool())
+        stakingTelemetry.Reset();
+
+    int64_t nUptime = stats.nTimeStarted ? GetTime() - stats.nTimeStarted : 0;
+    const StakePhaseStats &search = stats.vPhases[STAKE_PHASE_KERNEL_SEARCH];
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("uptime", nUptime);
+    obj.pushKV("rounds", stats.vPhases[STAKE_PHASE_SIGN_BLOCK].nCount);
+    obj.pushKV("kernelshashed", stats.nKernelsHashed);
+    obj.pushKV("hashespersec", search.nTotalMicros > 0 ? stats.nKernelsHashed * 1000000.0 / search.nTotalMicros : 0.0);
+    obj.pushKV("kernelspersec", nUptime > 0 ? (double)stats.nKernelsHashed / nUptime : 0.0);
+    obj.pushKV("stakesfound", stats.nStakesFound);
+    obj.pushKV("stakesaccepted", stats.nStakesAccepted);
+    obj.pushKV("stakesrejected", stats.nStakesRejected);
+    obj.pushKV("stakesorphaned", stats.nStakesOrphaned);
+
+    UniValue phases(UniValue::VOBJ);
+    for (int i = 0; i < STAKE_PHASE_COUNT; i++)
+    {
+        const StakePhaseStats &phase = stats.vPhases[i];
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("count", phase.nCount);
+        entry.pushKV("totalms", phase.nTotalMicros * 0.001);
+        entry.pushKV("avgms", phase.nCount ? phase.nTotalMicros * 0.001 / phase.nCount : 0.0);
+        entry.pushKV("maxms", phase.nMaxMicros * 0.001);
+        UniValue histogram(UniValue::VARR);
+        for (int k = 0; k < STAKE_LATENCY_BUCKETS; k++)
+            histogram.push_back(phase.vBuckets[k]);
+        entry.pushKV("histogram", histogram);
+        phases.pushKV(GetStakePhaseName((StakePhase)i), entry);
+    };
+    obj.pushKV("phases", phases);
+
+    return obj;
+}
+
 UniValue getcoldstakinginfo(const JSONRPCRequest &request)
 {
     CWallet *pwallet = GetWalletForJSONRPCRequest(request);
@@ -5173,7 +5246,8 @@ UniValue listallserials(const JSONRPCRequest& request)
     UniValue results(UniValue::VARR);
     if(request.params.size() > 0){
         CBlockIndex *temp = chainActive[request.params[0].get_int()];
-        for(auto it = temp->spentSerials.begin(); it != temp->spentSerials.end(); it++){
+        std::shared_ptr<const CBlockZerocoinData> zcData = pblocktree->ReadZerocoinData(temp);
+        for(auto it = zcData->spentSerials.begin(); it != zcData->spentSerials.end(); it++){
             results.push_back(it->ToString());
         }
         return results;
@@ -5182,7 +5256,8 @@ UniValue listallserials(const JSONRPCRequest& request)
 
     for(auto it = 53000; it <= chainActive.Tip()->nHeight; it++){
         CBlockIndex *temp = chainActive[it];
-        for(auto it = temp->spentSerials.begin(); it != temp->spentSerials.end(); it++){
+        std::shared_ptr<const CBlockZerocoinData> zcData = pblocktree->ReadZerocoinData(temp);
+        for(auto it = zcData->spentSerials.begin(); it != zcData->spentSerials.end(); it++){
             results.push_back(it->ToString());
         }
     }
@@ -5402,6 +5477,7 @@ static const CRPCCommand commands[] =
 
     // SUBI Staking functions
     { "wallet",             "getstakinginfo",                   &getstakinginfo,                {} },
+    { "mining",             "getstakingstats",                  &getstakingstats,               {"reset"} },
     { "wallet",             "getcoldstakinginfo",               &getcoldstakinginfo,            {} },
     { "wallet",             "reservebalance",                   &reservebalance,                {"enabled","amount"} },
     { "wallet",             "getalladdresses",                  &getalladdresses,               {} },
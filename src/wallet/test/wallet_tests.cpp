@@ -602,6 +602,65 @@ BOOST_AUTO_TEST_CASE(LoadReceiveRequests)
     BOOST_CHECK_EQUAL(values[1], "val_rr1");
 }
 
+// Verify a rescan finds transactions paying to keys a keypool top-up during the
+// rescan adds, also when they are in the batch of blocks already being filtered.
+BOOST_FIXTURE_TEST_CASE(rescan_keypool_topup, TestChain100Setup)
+{
+    gArgs.ForceSetArg("-keypool", "1");
+    ::bitdb.MakeMock();
+    g_address_type = OUTPUT_TYPE_DEFAULT;
+    g_change_type = OUTPUT_TYPE_DEFAULT;
+
+    // two wallets with the same HD master key
+    CKey masterKey;
+    masterKey.MakeNewKey(true);
+    auto MakeHDWallet = [&masterKey](const std::string& strFile) {
+        std::unique_ptr<CWallet> wallet(new CWallet(std::unique_ptr<CWalletDBWrapper>(new CWalletDBWrapper(&bitdb, strFile))));
+        bool firstRun;
+        wallet->LoadWallet(firstRun);
+        AddKey(*wallet, masterKey);
+        wallet->SetHDMasterKey(masterKey.GetPubKey());
+        LOCK(wallet->cs_wallet);
+        wallet->TopUpKeyPool();
+        return wallet;
+    };
+
+    // blocks paying the first four keys of the chain, one after the other
+    {
+        std::unique_ptr<CWallet> wallet = MakeHDWallet("wallet_keys.dat");
+        for (int i = 0; i < 4; i++) {
+            CPubKey pubkey;
+            {
+                LOCK(wallet->cs_wallet);
+                BOOST_CHECK(wallet->GetKeyFromPool(pubkey));
+            }
+            CreateAndProcessBlock({}, GetScriptForDestination(pubkey.GetID()));
+        }
+    }
+
+    // a restored wallet starts with only the first key in its keypool
+    std::unique_ptr<CWallet> wallet = MakeHDWallet("wallet_restored.dat");
+    {
+        WalletRescanReserver reserver(wallet.get());
+        reserver.reserve();
+        CBlockIndex* pindexStart;
+        {
+            LOCK(cs_main);
+            pindexStart = chainActive[chainActive.Height() - 3];
+        }
+        BOOST_CHECK(wallet->ScanForWalletTransactions(pindexStart, nullptr, reserver) == nullptr);
+    }
+    {
+        LOCK(wallet->cs_wallet);
+        BOOST_CHECK_EQUAL(wallet->mapWallet.size(), 4U);
+    }
+
+    wallet.reset();
+    ::bitdb.Flush(true);
+    ::bitdb.Reset();
+    gArgs.ForceSetArg("-keypool", std::to_string(DEFAULT_KEYPOOL_SIZE));
+}
+
 class ListCoinsTestingSetup : public TestChain100Setup
 {
 public:
@@ -5,6 +5,7 @@
 
 #include <wallet/wallet.h>
 
+#include <addressindex.h>
 #include <base58.h>
 #include <checkpoints.h>
 #include <chain.h>
@@ -12,6 +13,7 @@
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
 #include <fs.h>
+#include <insightindexer.h>
 #include <wallet/init.h>
 #include <key.h>
 #include <keystore.h>
@@ -31,7 +33,10 @@
 #include <wallet/fees.h>
 #include <utilstrencodings.h>
 #include <assert.h>
+#include <condition_variable>
 #include <future>
+#include <mutex>
+#include <thread>
 #include <rpc/protocol.h>
 #include "subinode/activesubinode.h"
 #include "subinode/darksend.h"
@@ -426,6 +431,11 @@ bool CWallet::AddCScript(const CScript& redeemScript)
 {
     if (!CCryptoKeyStore::AddCScript(redeemScript))
         return false;
+    {
+        // outputs paying to the script may be stakeable now
+        LOCK(cs_wallet);
+        fStakeableOutputsIndexed = false;
+    }
     return CWalletDB(*dbw).WriteCScript(Hash160(redeemScript), redeemScript);
 }
 
@@ -1077,6 +1087,9 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
     // Break debit/credit balance caches:
     wtx.MarkDirty();
 
+    if (fInsertedNew && fStakeableOutputsIndexed)
+        IndexStakeableOutputs(wtx);
+
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
 
@@ -1230,6 +1243,8 @@ bool CWallet::AddToWalletIfInvolvingMe(const CTransactionRef& ptx, const CBlockI
                 wtx.SetMerkleBranch(pIndex, posInBlock);
 
             bool rv = AddToWallet(wtx, false);
+            if (fStakeableOutputsIndexed)
+                UpdateStakeableOutputs(tx, pIndex);
             WakeThreadStakeMiner(this); // wallet balance may have changed
 
             return rv;
@@ -1454,11 +1469,17 @@ void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const
     }
 
     m_last_block_processed = pindex;
+    pindexStakeableTip = pindex;
 }
 
 void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) {
     LOCK2(cs_main, cs_wallet);
 
+    // transactions of the block are no longer as deep as staking needs
+    BlockMap::const_iterator mi = mapBlockIndex.find(pblock->GetHash());
+    if (mi != mapBlockIndex.end())
+        pindexStakeableTip = mi->second->pprev;
+
     for (const CTransactionRef& ptx : pblock->vtx) {
         SyncTransaction(ptx);
     }
@@ -1873,6 +1894,118 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
     return startTime;
 }
 
+/**
+ * Scan only the transactions the address index lists for vScripts after
+ * importing them, in the active chain and the mempool, instead of every
+ * block. vScripts must hold every script the wallet matches outputs of
+ * because of the import.
+ *
+ * A key's P2PKH address also lists the pay to pubkey, witness keyhash,
+ * timelocked and cold stake outputs the wallet matches for it, but only
+ * in address indexes written with the "addressindexkeys" flag.
+ *
+ * @return false if the index was written before that flag, any of the
+ * scripts is not covered by the address index (e.g. bare multisig), the
+ * index is not synced to the chain tip or a block could not be read, in
+ * which case the caller should fall back to RescanFromTime.
+ */
+bool CWallet::RescanFromAddressIndex(const std::vector<CScript>& vScripts, const WalletRescanReserver& reserver, bool fUpdate)
+{
+    assert(reserver.isReserved());
+    if (!fAddressIndex || !fAddressIndexKeys || vScripts.empty())
+        return false;
+
+    std::vector<std::pair<uint256, int> > addresses;
+    for (const CScript& script : vScripts) {
+        std::vector<uint8_t> hashBytes;
+        int scriptType = 0;
+        if (!ExtractIndexInfo(&script, scriptType, hashBytes) || scriptType == 0)
+            return false;
+        addresses.push_back(std::make_pair(uint256(hashBytes.data(), hashBytes.size()), scriptType));
+    }
+
+    {
+        // blocks connected after the import are scanned by BlockConnected,
+        // the ones before it must all be in the index
+        LOCK(cs_main);
+        if (insightIndexer.GetBestBlock() != chainActive.Tip())
+            return false;
+    }
+
+    int64_t nTimeStart = GetTimeMillis();
+
+    // Transactions to scan by the height of the block they are in
+    std::map<int, std::set<uint256> > mapHits;
+    for (const auto& address : addresses) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+        if (!GetAddressIndex(address.first, address.second, addressIndex))
+            return false;
+        for (const auto& entry : addressIndex)
+            mapHits[entry.first.blockHeight].insert(entry.first.txhash);
+    }
+
+    fAbortRescan = false;
+    size_t nTxMatched = 0;
+    for (const auto& hits : mapHits) {
+        if (fAbortRescan) {
+            LogPrintf("Rescan aborted at block %d\n", hits.first);
+            return true;
+        }
+
+        CBlockIndex* pindex;
+        {
+            LOCK(cs_main);
+            pindex = chainActive[hits.first];
+        }
+        CBlock block;
+        if (!pindex || !ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
+            return false;
+
+        LOCK2(cs_main, cs_wallet);
+        if (!chainActive.Contains(pindex))
+            return false;
+        for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
+            if (hits.second.count(block.vtx[posInBlock]->GetHash())) {
+                nTxMatched++;
+                AddToWalletIfInvolvingMe(block.vtx[posInBlock], pindex, posInBlock, fUpdate);
+            }
+        }
+    }
+
+    std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > mempoolIndex;
+    if (mempool.getAddressIndex(addresses, mempoolIndex)) {
+        LOCK2(cs_main, cs_wallet);
+        for (const auto& entry : mempoolIndex) {
+            CTransactionRef ptx = mempool.get(entry.first.txhash);
+            if (ptx) {
+                nTxMatched++;
+                AddToWalletIfInvolvingMe(ptx, nullptr, 0, fUpdate);
+            }
+        }
+    }
+
+    LogPrintf("Rescanned %u blocks from the address index in %dms, %u txs matched\n", mapHits.size(), GetTimeMillis() - nTimeStart, nTxMatched);
+    return true;
+}
+
+//! Number of blocks a rescan reads and filters ahead of adding their transactions to the wallet
+static const size_t RESCAN_BATCH_SIZE = 256;
+//! Maximum number of threads reading and filtering blocks for a rescan
+static const int MAX_RESCAN_THREADS = 8;
+
+/** A block of a rescan, read and filtered by a worker thread */
+struct CRescanBlock
+{
+    CBlockIndex* pindex;
+    CBlock block;
+    bool fRead;
+    //! per transaction, whether any of its outputs is ours
+    std::vector<bool> vMine;
+    bool fDone;
+
+    explicit CRescanBlock(CBlockIndex* pindexIn) : pindex(pindexIn), fRead(false), fDone(false) {}
+};
+
 /**
  * Scan the block chain (starting in pindexStart) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -1888,6 +2021,13 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
  * Caller needs to make sure pindexStop (and the optional pindexStart) are on
  * the main chain after to the addition of any new keys you want to detect
  * transactions for.
+ *
+ * Worker threads read the blocks of a batch ahead and check which of their
+ * transactions pay to us, without holding any locks. This thread then goes
+ * through the batch in order and only passes the transactions that pay to us,
+ * spend or conflict with wallet transactions or may be zerocoin mints of ours
+ * on to AddToWalletIfInvolvingMe. Once that tops up the keypool, this thread
+ * checks the rest of the batch again with the new keys.
  */
 CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlockIndex* pindexStop, const WalletRescanReserver &reserver, bool fUpdate)
 {
@@ -1899,6 +2039,18 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
         assert(pindexStop->nHeight >= pindexStart->nHeight);
     }
 
+    // Transactions none of whose outputs are ours still matter to AddToWalletIfInvolvingMe if they
+    // are wallet transactions already, spend or conflict with wallet transactions or may be our mints
+    auto fMayInvolveMe = [this](const CTransaction& tx) {
+        AssertLockHeld(cs_wallet);
+        if (tx.IsZerocoinMint() || mapWallet.count(tx.GetHash()))
+            return true;
+        for (const CTxIn& txin : tx.vin)
+            if (mapWallet.count(txin.prevout.hash) || mapTxSpends.count(txin.prevout))
+                return true;
+        return false;
+    };
+
     CBlockIndex* pindex = pindexStart;
     CBlockIndex* ret = nullptr;
     {
@@ -1913,38 +2065,119 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
             dProgressStart = GuessVerificationProgress(chainParams.TxData(), pindex);
             dProgressTip = GuessVerificationProgress(chainParams.TxData(), tip);
         }
-        while (pindex && !fAbortRescan)
+
+        int nThreads = std::max(1, std::min(GetNumCores() - 1, MAX_RESCAN_THREADS));
+        int64_t nTimeStart = GetTimeMillis();
+        uint64_t nBlocksScanned = 0;
+        uint64_t nTxScanned = 0;
+        uint64_t nTxMatched = 0;
+        bool fStop = false;
+
+        while (pindex && !fAbortRescan && !fStop)
         {
-            if (pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0) {
-                double gvp = 0;
-                {
-                    LOCK(cs_main);
-                    gvp = GuessVerificationProgress(chainParams.TxData(), pindex);
+            std::vector<CRescanBlock> vBatch;
+            {
+                LOCK(cs_main);
+                for (CBlockIndex* pindexNext = pindex; pindexNext && vBatch.size() < RESCAN_BATCH_SIZE; pindexNext = chainActive.Next(pindexNext)) {
+                    vBatch.emplace_back(pindexNext);
+                    if (pindexNext == pindexStop)
+                        break;
                 }
-                ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((gvp - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
             }
-            if (GetTime() >= nNow + 60) {
-                nNow = GetTime();
-                LOCK(cs_main);
-                LogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight, GuessVerificationProgress(chainParams.TxData(), pindex));
+
+            // keys the workers filter with, adding a transaction to the wallet may top up the keypool
+            int64_t nKeyPoolIndexFiltered;
+            {
+                LOCK(cs_wallet);
+                nKeyPoolIndexFiltered = m_max_keypool_index;
             }
 
-            CBlock block;
-            if (ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
-                LOCK2(cs_main, cs_wallet);
-                if (pindex && !chainActive.Contains(pindex)) {
-                    // Abort scan if current block is no longer active, to prevent
-                    // marking transactions as coming from the wrong block.
+            std::mutex mutexBatch;
+            std::condition_variable condBatch;
+            std::atomic<size_t> nNext(0);
+            std::atomic<bool> fInterrupt(false);
+            auto worker = [&]() {
+                for (size_t i = nNext++; i < vBatch.size() && !fInterrupt; i = nNext++) {
+                    CRescanBlock& item = vBatch[i];
+                    if (ReadBlockFromDisk(item.block, item.pindex, chainParams.GetConsensus())) {
+                        item.fRead = true;
+                        item.vMine.resize(item.block.vtx.size());
+                        for (size_t posInBlock = 0; posInBlock < item.block.vtx.size(); ++posInBlock)
+                            item.vMine[posInBlock] = IsMine(*item.block.vtx[posInBlock]);
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(mutexBatch);
+                        item.fDone = true;
+                    }
+                    condBatch.notify_all();
+                }
+            };
+            std::vector<std::thread> threads;
+            for (int i = 0; i < nThreads; i++)
+                threads.emplace_back(worker);
+
+            for (CRescanBlock& item : vBatch)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutexBatch);
+                    condBatch.wait(lock, [&item] { return item.fDone; });
+                }
+                pindex = item.pindex;
+
+                if (pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0) {
+                    double gvp = 0;
+                    {
+                        LOCK(cs_main);
+                        gvp = GuessVerificationProgress(chainParams.TxData(), pindex);
+                    }
+                    ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((gvp - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
+                }
+                if (GetTime() >= nNow + 60) {
+                    nNow = GetTime();
+                    double dElapsed = std::max<int64_t>(1, GetTimeMillis() - nTimeStart) / 1000.0;
+                    LOCK(cs_main);
+                    LogPrintf("Still rescanning. At block %d. Progress=%f (%.1f blocks/s, %.1f txs/s, %u txs matched)\n", pindex->nHeight, GuessVerificationProgress(chainParams.TxData(), pindex),
+                        nBlocksScanned / dElapsed, nTxScanned / dElapsed, nTxMatched);
+                }
+
+                if (item.fRead) {
+                    LOCK2(cs_main, cs_wallet);
+                    if (pindex && !chainActive.Contains(pindex)) {
+                        // Abort scan if current block is no longer active, to prevent
+                        // marking transactions as coming from the wrong block.
+                        ret = pindex;
+                        fStop = true;
+                        break;
+                    }
+                    for (size_t posInBlock = 0; posInBlock < item.block.vtx.size(); ++posInBlock) {
+                        // the rest of the batch was filtered without the keys added since
+                        if (m_max_keypool_index != nKeyPoolIndexFiltered)
+                            item.vMine[posInBlock] = IsMine(*item.block.vtx[posInBlock]);
+                        if (item.vMine[posInBlock] || fMayInvolveMe(*item.block.vtx[posInBlock])) {
+                            nTxMatched++;
+                            AddToWalletIfInvolvingMe(item.block.vtx[posInBlock], pindex, posInBlock, fUpdate);
+                        }
+                    }
+                    nBlocksScanned++;
+                    nTxScanned += item.block.vtx.size();
+                    item.block.SetNull();
+                } else {
                     ret = pindex;
+                }
+                if (pindex == pindexStop) {
+                    fStop = true;
                     break;
                 }
-                for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
-                    AddToWalletIfInvolvingMe(block.vtx[posInBlock], pindex, posInBlock, fUpdate);
+                if (fAbortRescan) {
+                    break;
                 }
-            } else {
-                ret = pindex;
             }
-            if (pindex == pindexStop) {
+
+            fInterrupt = true;
+            for (std::thread& thread : threads)
+                thread.join();
+
+            if (fStop || fAbortRescan) {
                 break;
             }
             {
@@ -1960,6 +2193,8 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
         if (pindex && fAbortRescan) {
             LogPrintf("Rescan aborted at block %d. Progress=%f\n", pindex->nHeight, GuessVerificationProgress(chainParams.TxData(), pindex));
         }
+        LogPrintf("Rescanned %u blocks, %u txs in %.1fs using %d threads, %u txs matched\n", nBlocksScanned, nTxScanned,
+            (GetTimeMillis() - nTimeStart) / 1000.0, nThreads, nTxMatched);
         ShowProgress(_("Rescanning..."), 100); // hide progress dialog in GUI
     }
     return ret;
@@ -8013,108 +8248,279 @@ uint64_t CWallet::GetStakeWeight() const
 
 bool SortWeight(const COutput &a, const COutput &b) { return (a.tx->tx->vout[a.i].nValue/a.tx->GetTxTime()) > (b.tx->tx->vout[b.i].nValue/b.tx->GetTxTime()); }
 
-void CWallet::AvailableCoinsForStaking(std::vector<COutput> &vCoins, int64_t nTime, int nHeight) const
+bool CWallet::IsStakeableScript(const CScript& scriptPubKey) const
 {
-    vCoins.clear();
+    AssertLockHeld(cs_wallet);
 
-    deepestTxnDepth = 0;
+    if(scriptPubKey.IsPayToScriptHash_CS()){
+        // Check if contract allows fee payouts
+        int64_t feeOut = 0;
+        if(GetCoinstakeScriptFee(scriptPubKey, feeOut)){
+            if(feeOut < nMinimumDelagatePercentage)
+                return false;
+        }
+        //If script does not include fee and percentage is set, skip
+        else if(nMinimumDelagatePercentage > 0)
+            return false;
+
+        CScript scriptOut;
+        if(GetCoinstakeScriptFeeRewardAddress(scriptPubKey, scriptOut)){
+            CScriptID delegateRewardID;
+            ExtractStakingKeyID(scriptOut, delegateRewardID);
+            if(nDelegateRewardToMe){
+                if(!HaveCScript(delegateRewardID))
+                    return false;
+            }
+            else if(!nDelegateRewardAddresses.empty()){
+                if(std::find(vDelegateRewardScriptIDs.begin(), vDelegateRewardScriptIDs.end(), delegateRewardID) == vDelegateRewardScriptIDs.end())
+                    return false;
+            }
+        }
+        //If script does not include reward addres and fields are set, skip
+        else if(nDelegateRewardToMe || !nDelegateRewardAddresses.empty())
+            return false;
+    }
 
+    CScriptID dest;
+    //Returns false if not coldstake or p2sh script
+    if (!ExtractStakingKeyID(scriptPubKey, dest))
+        return false;
+
+    // for staking we ONLY support P2SH Segwit
+    return HaveCScript(dest);
+}
+
+void CWallet::IndexStakeableOutputs(const CWalletTx& wtx) const
+{
+    AssertLockHeld(cs_wallet);
+
+    std::vector<unsigned int> vOutputs;
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); i++)
+        if (IsStakeableScript(wtx.tx->vout[i].scriptPubKey))
+            vOutputs.push_back(i);
+
+    if (vOutputs.empty())
     {
-        LOCK2(cs_main, cs_wallet);
+        SetStakeableHeight(wtx.GetHash(), -1);
+        mapStakeableOutputs.erase(wtx.GetHash());
+    } else
+        mapStakeableOutputs[wtx.GetHash()] = vOutputs;
+}
 
-        int nHeight = chainActive.Tip()->nHeight;
-        int coinbaseMaturity = nHeight >= Params().GetConsensus().nStartShadeFeeDistribution ? COINBASE_MATURITY_V2 : COINBASE_MATURITY;
+void CWallet::SetStakeableHeight(const uint256& hash, int nHeight) const
+{
+    AssertLockHeld(cs_wallet);
 
-        bool fTestNet = (Params().NetworkIDString() == CBaseChainParams::TESTNET);
-        if(fTestNet)
-            coinbaseMaturity = COINBASE_MATURITY_TESTNET;
+    std::map<uint256, int>::iterator mi = mapStakeableHeights.find(hash);
+    if (mi != mapStakeableHeights.end())
+    {
+        if (mi->second == nHeight)
+            return;
+        std::map<int, std::set<uint256> >::iterator bi = mapStakeableByHeight.find(mi->second);
+        bi->second.erase(hash);
+        if (bi->second.empty())
+            mapStakeableByHeight.erase(bi);
+        mapStakeableHeights.erase(mi);
+    }
 
-        int nRequiredDepth = coinbaseMaturity + 1;
+    if (nHeight < 0 || !mapStakeableOutputs.count(hash))
+        return;
+    mapStakeableHeights[hash] = nHeight;
+    mapStakeableByHeight[nHeight].insert(hash);
+}
+
+/** Height of the block of a wallet transaction if that block is an ancestor of pindexTip, otherwise -1 */
+static int GetHeightInChain(const CWalletTx& wtx, const CBlockIndex* pindexTip)
+{
+    AssertLockHeld(cs_main);
+
+    // conflicted transactions keep the hash of the conflicting block, but no position in it
+    if (wtx.hashUnset() || wtx.nIndex == -1 || !pindexTip)
+        return -1;
+    BlockMap::const_iterator mi = mapBlockIndex.find(wtx.hashBlock);
+    if (mi == mapBlockIndex.end() || pindexTip->GetAncestor(mi->second->nHeight) != mi->second)
+        return -1;
+    return mi->second->nHeight;
+}
+
+void CWallet::RebuildStakeableOutputs() const
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    mapStakeableOutputs.clear();
+    mapStakeableByHeight.clear();
+    mapStakeableHeights.clear();
+    pindexStakeableTip = m_last_block_processed;
+
+    for (MapWallet_t::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+    {
+        const CWalletTx& wtx = it->second;
+        IndexStakeableOutputs(wtx);
+
+        std::map<uint256, std::vector<unsigned int> >::iterator mi = mapStakeableOutputs.find(wtx.GetHash());
+        if (mi == mapStakeableOutputs.end())
+            continue;
 
-        for (MapWallet_t::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+        // leave out what the chain spent already
+        std::vector<unsigned int>& vOutputs = mi->second;
+        for (std::vector<unsigned int>::iterator oi = vOutputs.begin(); oi != vOutputs.end(); )
         {
-            const CWalletTx *pcoin = &it->second;
-            CTransactionRef tx = pcoin->tx;
+            bool fSpent = false;
+            std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range = mapTxSpends.equal_range(COutPoint(wtx.GetHash(), *oi));
+            for (TxSpends::const_iterator sit = range.first; sit != range.second && !fSpent; ++sit)
+            {
+                MapWallet_t::const_iterator mit = mapWallet.find(sit->second);
+                fSpent = mit != mapWallet.end() && GetHeightInChain(mit->second, pindexStakeableTip) >= 0;
+            }
+            oi = fSpent ? vOutputs.erase(oi) : oi + 1;
+        }
 
-            int nDepth = pcoin->GetDepthInMainChainCached();
+        if (vOutputs.empty())
+            mapStakeableOutputs.erase(mi);
+        else
+            SetStakeableHeight(wtx.GetHash(), GetHeightInChain(wtx, pindexStakeableTip));
+    }
 
-            if (nDepth > deepestTxnDepth)
-                deepestTxnDepth = nDepth;
+    fStakeableOutputsIndexed = true;
+}
 
-            if (nDepth < nRequiredDepth)
-                continue;
+void CWallet::UpdateStakeableOutputs(const CTransaction& tx, const CBlockIndex* pIndex) const
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
 
-            const uint256 &wtxid = it->first;
-            for (size_t i = 0; i < tx->vout.size(); ++i)
+    if (pIndex)
+    {
+        // an output spent in a block does not stake again unless that block is disconnected
+        for (const CTxIn& txin : tx.vin)
+        {
+            std::map<uint256, std::vector<unsigned int> >::iterator mi = mapStakeableOutputs.find(txin.prevout.hash);
+            if (mi == mapStakeableOutputs.end())
+                continue;
+            std::vector<unsigned int>& vOutputs = mi->second;
+            vOutputs.erase(std::remove(vOutputs.begin(), vOutputs.end(), txin.prevout.n), vOutputs.end());
+            if (vOutputs.empty())
             {
-                const auto &txout = tx->vout[i];
+                SetStakeableHeight(txin.prevout.hash, -1);
+                mapStakeableOutputs.erase(mi);
+            }
+        }
+        SetStakeableHeight(tx.GetHash(), pIndex->nHeight);
+        return;
+    }
 
-                COutPoint kernel(wtxid, i);
-                if (!CheckStakeUnused(kernel) ||
-                        IsSpent(wtxid, i)
-                        || IsLockedCoin(wtxid, i))
-                    continue;
+    // out of a block, or never in one: the outputs it spends are unspent as far as the chain goes
+    SetStakeableHeight(tx.GetHash(), -1);
+    for (const CTxIn& txin : tx.vin)
+    {
+        MapWallet_t::const_iterator mit = mapWallet.find(txin.prevout.hash);
+        if (mit == mapWallet.end())
+            continue;
+        const CWalletTx& wtxPrev = mit->second;
+        if (txin.prevout.n >= wtxPrev.tx->vout.size() || !IsStakeableScript(wtxPrev.tx->vout[txin.prevout.n].scriptPubKey))
+            continue;
 
-                const CScript pscriptPubKey = txout.scriptPubKey;
+        bool fIndexed = mapStakeableOutputs.count(txin.prevout.hash);
+        std::vector<unsigned int>& vOutputs = mapStakeableOutputs[txin.prevout.hash];
+        std::vector<unsigned int>::iterator oi = std::lower_bound(vOutputs.begin(), vOutputs.end(), txin.prevout.n);
+        if (oi == vOutputs.end() || *oi != txin.prevout.n)
+            vOutputs.insert(oi, txin.prevout.n);
+        if (!fIndexed)
+            SetStakeableHeight(txin.prevout.hash, GetHeightInChain(wtxPrev, pindexStakeableTip));
+    }
+}
 
-                if(pscriptPubKey.IsPayToScriptHash_CS()){
-                    // Check if contract allows fee payouts
-                    int64_t feeOut = 0;
-                    if(GetCoinstakeScriptFee(pscriptPubKey, feeOut)){
-                        if(feeOut < nMinimumDelagatePercentage)
-                            continue;
-                    }
-                    //If script does not include fee and percentage is set, skip
-                    else if(nMinimumDelagatePercentage > 0)
-                        continue;
+bool CWallet::IsSpentForStaking(const uint256& hash, unsigned int n) const
+{
+    AssertLockHeld(cs_wallet);
 
-                    CScript scriptOut;
-                    if(GetCoinstakeScriptFeeRewardAddress(pscriptPubKey, scriptOut)){
-                        if(nDelegateRewardToMe){
-                            CScriptID delegateRewardID;
-                            ExtractStakingKeyID(scriptOut, delegateRewardID);
-                            if(!HaveCScript(delegateRewardID))
-                                continue;
-                        }
-                        else if(!nDelegateRewardAddresses.empty()){
-                            bool found = false;
-                            for(std::string addressString: nDelegateRewardAddresses){
-                                CBitcoinAddress rewardAddress(addressString);
-                                if(!rewardAddress.IsValid() || !rewardAddress.IsScript())
-                                    continue;
+    const COutPoint outpoint(hash, n);
+    std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range;
+    range = mapTxSpends.equal_range(outpoint);
 
-                                CScriptID delegateRewardID;
-                                ExtractStakingKeyID(scriptOut, delegateRewardID);
+    for (TxSpends::const_iterator it = range.first; it != range.second; ++it)
+    {
+        std::map<uint256, CWalletTx>::const_iterator mit = mapWallet.find(it->second);
+        if (mit == mapWallet.end())
+            continue;
+        // like IsSpent, without the depth: conflicted spenders keep a block hash without a position in it
+        const CWalletTx& wtx = mit->second;
+        if (!wtx.isAbandoned() && (wtx.hashUnset() || wtx.nIndex != -1))
+            return true;
+    }
+    return false;
+}
 
-                                CTxDestination rewardDest = rewardAddress.Get();
-                                CScriptID rewardID = boost::get<CScriptID>(rewardDest);
+void CWallet::AvailableCoinsForStaking(std::vector<COutput> &vCoins, int64_t nTime, int nHeight) const
+{
+    vCoins.clear();
 
-                                if(rewardID == delegateRewardID)
-                                    found = true;
-                            }
-                            if(!found)
-                                continue;
+    deepestTxnDepth = 0;
 
-                        }
+    bool fIndexed;
+    {
+        LOCK(cs_wallet);
+        fIndexed = fStakeableOutputsIndexed;
+    }
+    if (!fIndexed)
+    {
+        // only building the index needs cs_main, for the heights of the transactions
+        LOCK2(cs_main, cs_wallet);
+        if (!fStakeableOutputsIndexed)
+            RebuildStakeableOutputs();
+    }
 
-                    }
-                    //If script does not include reward addres and fields are set, skip
-                    else if(nDelegateRewardToMe || !nDelegateRewardAddresses.empty())
-                        continue;
-                }
+    {
+        LOCK(cs_wallet);
+
+        // scripts or staking settings changed since, the next round rebuilds the index
+        if (!fStakeableOutputsIndexed || !pindexStakeableTip)
+            return;
+
+        int nHeight = pindexStakeableTip->nHeight;
+        int coinbaseMaturity = nHeight >= Params().GetConsensus().nStartShadeFeeDistribution ? COINBASE_MATURITY_V2 : COINBASE_MATURITY;
+
+        bool fTestNet = (Params().NetworkIDString() == CBaseChainParams::TESTNET);
+        if(fTestNet)
+            coinbaseMaturity = COINBASE_MATURITY_TESTNET;
+
+        int nRequiredDepth = coinbaseMaturity + 1;
 
-                CScriptID dest;
-                //Returns false if not coldstake or p2sh script
-                if (!ExtractStakingKeyID(pscriptPubKey, dest))
+        if (!mapStakeableByHeight.empty())
+            deepestTxnDepth = std::max(0, nHeight - mapStakeableByHeight.begin()->first + 1);
+
+        // only the buckets of blocks at least nRequiredDepth deep hold mature outputs
+        std::vector<uint256> vZapped;
+        std::map<int, std::set<uint256> >::const_iterator itEnd = mapStakeableByHeight.upper_bound(nHeight - nRequiredDepth + 1);
+        for (std::map<int, std::set<uint256> >::const_iterator it = mapStakeableByHeight.begin(); it != itEnd; ++it)
+        {
+            int nDepth = nHeight - it->first + 1;
+            for (const uint256 &wtxid : it->second)
+            {
+                MapWallet_t::const_iterator mi = mapWallet.find(wtxid);
+                if (mi == mapWallet.end())
+                {
+                    vZapped.push_back(wtxid);
                     continue;
+                }
+                const CWalletTx *pcoin = &mi->second;
 
-                // for staking we ONLY support P2SH Segwit
-                const CScriptID& destScriptID = dest;
-                if (HaveCScript(destScriptID))
-                    vCoins.push_back(COutput(pcoin, i, nDepth, true, true, true));
+                for (unsigned int i : mapStakeableOutputs[wtxid])
+                {
+                    if (IsSpentForStaking(wtxid, i) || IsLockedCoin(wtxid, i))
+                        continue;
 
+                    vCoins.push_back(COutput(pcoin, i, nDepth, true, true, true));
+                }
             }
         }
+
+        for (const uint256 &wtxid : vZapped)
+        {
+            SetStakeableHeight(wtxid, -1);
+            mapStakeableOutputs.erase(wtxid);
+        }
     }
 
     //Sort staking list by (amount/height) instead of randomness
@@ -8179,7 +8585,10 @@ bool CWallet::CreateCoinStake(unsigned int nBits, int64_t nTime, int nBlockHeigh
     CAmount nValueIn = 0;
 
     // Select coins with suitable depth
-    if (!SelectCoinsForStaking(nBalance - nReserveBalance, nTime, nBlockHeight, setCoins, nValueIn))
+    int64_t nTimeSelect = GetTimeMicros();
+    bool fSelected = SelectCoinsForStaking(nBalance - nReserveBalance, nTime, nBlockHeight, setCoins, nValueIn);
+    stakingTelemetry.AddPhase(STAKE_PHASE_SELECT_COINS, GetTimeMicros() - nTimeSelect);
+    if (!fSelected)
         return false;
 
     if (setCoins.empty())
@@ -8188,19 +8597,46 @@ bool CWallet::CreateCoinStake(unsigned int nBits, int64_t nTime, int nBlockHeigh
     CAmount nCredit = 0;
     CScript scriptPubKeyKernel;
 
-    std::set<std::pair<const CWalletTx*,unsigned int> >::iterator it = setCoins.begin();
+    // Snapshot the kernel inputs, then hash them all without holding any locks
+    std::vector<std::pair<const CWalletTx*,unsigned int> > vKernelCoins;
+    std::vector<CStakeCandidate> vCandidates;
+    {
+        int64_t nTimeLock = GetTimeMicros();
+        LOCK2(cs_main, cs_wallet);
+        stakingTelemetry.AddPhase(STAKE_PHASE_LOCK_WAIT, GetTimeMicros() - nTimeLock);
+        if (hashStakeCandidatesTip != pindexPrev->GetBlockHash())
+        {
+            mapStakeCandidates.clear();
+            hashStakeCandidatesTip = pindexPrev->GetBlockHash();
+        };
 
-    for (; it != setCoins.end(); ++it)
+        for (const auto &coin : setCoins)
+        {
+            COutPoint prevoutStake = COutPoint(coin.first->GetHash(), coin.second);
+            if (!CheckStakeUnused(prevoutStake))
+                continue;
+            std::map<COutPoint, CStakeCandidate>::const_iterator mi = mapStakeCandidates.find(prevoutStake);
+            if (mi == mapStakeCandidates.end())
+            {
+                CStakeCandidate candidate;
+                if (!GetStakeCandidate(pindexPrev, prevoutStake, candidate))
+                    continue;
+                mi = mapStakeCandidates.emplace(prevoutStake, candidate).first;
+            };
+            vKernelCoins.push_back(coin);
+            vCandidates.push_back(mi->second);
+        };
+    }
+
+    CKernelSearchTimer searchTimer;
+    for (size_t nKernel = searchTimer.Find(pindexPrev, nBits, nTime, vCandidates, 0);
+         nKernel < vCandidates.size();
+         nKernel = searchTimer.Find(pindexPrev, nBits, nTime, vCandidates, nKernel + 1))
     {
-        auto pcoin = *it;
+        auto pcoin = vKernelCoins[nKernel];
         if (ThreadStakeMinerStopped()) // interruption_point
             return false;
 
-        COutPoint prevoutStake = COutPoint(pcoin.first->GetHash(), pcoin.second);
-
-        int64_t nBlockTime;
-
-        if (CheckKernel(pindexPrev, nBits, nTime, prevoutStake, &nBlockTime))
         {
             LOCK(cs_wallet);
             // Found a kernel
@@ -8339,7 +8775,7 @@ bool CWallet::CreateCoinStake(unsigned int nBits, int64_t nTime, int nBlockHeigh
 
             LogPrintf("%s: Added kernel with value: %lf.\n", __func__, nCredit);
 
-            setCoins.erase(it);
+            setCoins.erase(pcoin);
             break;
         };
     };
@@ -8352,7 +8788,7 @@ bool CWallet::CreateCoinStake(unsigned int nBits, int64_t nTime, int nBlockHeigh
     // Attempt to add more inputs
     // Only advantage here is to setup the next stake using this output as a kernel to have a higher chance of staking
     size_t nStakesCombined = 0;
-    it = setCoins.begin();
+    std::set<std::pair<const CWalletTx*,unsigned int> >::iterator it = setCoins.begin();
     while (it != setCoins.end())
     {
         if (nStakesCombined >= nMaxStakeCombine)
@@ -8734,6 +9170,19 @@ bool CWallet::ProcessStakingSettings(std::string &sError)
     for(auto addr: nDelegateRewardAddresses)
         LogPrintf("\n%s", addr);
 
+    {
+        LOCK(cs_wallet);
+        vDelegateRewardScriptIDs.clear();
+        for (const std::string& addressString : nDelegateRewardAddresses) {
+            CBitcoinAddress rewardAddress(addressString);
+            if (!rewardAddress.IsValid() || !rewardAddress.IsScript())
+                continue;
+            vDelegateRewardScriptIDs.push_back(boost::get<CScriptID>(rewardAddress.Get()));
+        }
+        // staking settings decide which outputs are stakeable
+        fStakeableOutputsIndexed = false;
+    }
+
     if (nStakeCombineThreshold < 100 * COIN)
     {
         sError = "stakecombinethreshold must be >= 100 and <= 5000.";
@@ -36,6 +36,7 @@
 #include <crypto/hmac_sha256.h>
 #include <crypto/hmac_sha512.h>
 #include <miner.h>
+#include <pos/kernel.h>
 #include <univalue/include/univalue.h>
 
 typedef CWallet* CWalletRef;
@@ -1370,6 +1371,7 @@ public:
     void BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) override;
     bool AddToWalletIfInvolvingMe(const CTransactionRef& tx, const CBlockIndex* pIndex, int posInBlock, bool fUpdate);
     int64_t RescanFromTime(int64_t startTime, const WalletRescanReserver& reserver, bool update);
+    bool RescanFromAddressIndex(const std::vector<CScript>& vScripts, const WalletRescanReserver& reserver, bool fUpdate);
     CBlockIndex* ScanForWalletTransactions(CBlockIndex* pindexStart, CBlockIndex* pindexStop, const WalletRescanReserver& reserver, bool fUpdate = false);
     void TransactionRemovedFromMempool(const CTransactionRef &ptx) override;
     void ReacceptWalletTransactions();
@@ -1476,6 +1478,8 @@ public:
     uint64_t GetStakeWeight() const;
 
     bool SetReserveBalance(CAmount nNewReserveBalance);
+    /** Whether this wallet could stake an output paying to scriptPubKey under the current staking settings, regardless of its depth and spent state */
+    bool IsStakeableScript(const CScript& scriptPubKey) const;
     void AvailableCoinsForStaking(std::vector<COutput> &vCoins, int64_t nTime, int nHeight) const;
     bool SelectCoinsForStaking(int64_t nTargetValue, int64_t nTime, int nHeight, std::set<std::pair<const CWalletTx*,unsigned int> >& setCoinsRet, int64_t& nValueRet) const;
     bool CreateCoinStake(unsigned int nBits, int64_t nTime, int nBlockHeight, int64_t nFees, CMutableTransaction &txNew, CKey &key, CBlockTemplate* pblocktemplate, int64_t nShadeFees, std::vector<unsigned char> &commitment, uint256 witnessroot);
@@ -1492,6 +1496,32 @@ public:
 
     mutable int deepestTxnDepth = 0; // for stake mining
 
+    /** Stakeable outputs of wallet transactions by txid, so staking rounds skip all other transactions.
+     *  Built on first use, extended by AddToWallet and rebuilt when scripts or staking settings change.
+     *  Outputs spent by a transaction in a block are dropped, and put back if that block is disconnected. */
+    mutable std::map<uint256, std::vector<unsigned int> > mapStakeableOutputs;
+    /** Indexed transactions by the height of their block, as far as the wallet processed the chain,
+     *  so staking rounds find the mature ones without cs_main */
+    mutable std::map<int, std::set<uint256> > mapStakeableByHeight;
+    mutable std::map<uint256, int> mapStakeableHeights;
+    /** Last block the index was updated for, the tip staking rounds measure depth from */
+    mutable const CBlockIndex* pindexStakeableTip = nullptr;
+    mutable bool fStakeableOutputsIndexed = false;
+    void IndexStakeableOutputs(const CWalletTx& wtx) const;
+    /** Move an indexed transaction to the bucket of its block height, -1 if it is not in a block */
+    void SetStakeableHeight(const uint256& hash, int nHeight) const;
+    /** Index all wallet transactions, requires cs_main for their block heights */
+    void RebuildStakeableOutputs() const;
+    /** Follow a wallet transaction into or out of a block: drop the outputs it spends, or put them back */
+    void UpdateStakeableOutputs(const CTransaction& tx, const CBlockIndex* pIndex) const;
+    /** Whether an output is spent by a wallet transaction that is neither abandoned nor conflicted, needs no cs_main */
+    bool IsSpentForStaking(const uint256& hash, unsigned int n) const;
+
+    /** Kernel inputs of staking coins as of the chain tip hashStakeCandidatesTip, so staking rounds
+     *  at later timestamps on the same tip do not look them up in the UTXO set again */
+    std::map<COutPoint, CStakeCandidate> mapStakeCandidates;
+    uint256 hashStakeCandidatesTip;
+
     mutable int m_greatest_txn_depth = 0; // depth of most deep txn
     //mutable int m_least_txn_depth = 0; // depth of least deep txn
     mutable bool m_have_spendable_balance_cached = false;
@@ -1515,6 +1545,7 @@ public:
     CAmount nStakeSplitThreshold;
     CAmount nMinimumDelagatePercentage;
     std::vector<std::string> nDelegateRewardAddresses;
+    std::vector<CScriptID> vDelegateRewardScriptIDs; // valid script addresses of nDelegateRewardAddresses
     bool nDelegateRewardToMe;
     size_t nMaxStakeCombine = 3;
     CAmount nWalletDonationPercent;
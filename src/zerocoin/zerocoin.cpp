@@ -1,13 +1,21 @@
 #include "zerocoin.h"
 #include "timedata.h"
+#include "txdb.h"
 #include "util.h"
 #include "base58.h"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
+#include "arith_uint256.h"
+#include "crypto/common.h"
+#include "crypto/sha256.h"
+#include "cuckoocache.h"
+#include "random.h"
+#include "script/sigcache.h"
 #include <atomic>
 #include <sstream>
 #include <chrono>
 #include <boost/foreach.hpp>
+#include <boost/thread.hpp>
 #include "utilstrencodings.h"
 
 using namespace std;
@@ -25,6 +33,93 @@ static CZerocoinState zerocoinState;
 
 static map<uint256, int64_t> shadedCoins;
 
+namespace {
+/**
+ * Spend proofs that verified against an accumulator value, so a spend is
+ * checked once when accepted into the memory pool and not again when its
+ * block is connected.
+ */
+class CZerocoinSpendCache
+{
+private:
+    //! Entries are SHA256(nonce || hash of serialized spend || metadata || denomination || accumulator value)
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_spendcache;
+
+public:
+    CZerocoinSpendCache()
+    {
+        GetRandBytes(nonce.begin(), 32);
+        setValid.setup_bytes(DEFAULT_ZEROCOIN_SPEND_CACHE_SIZE << 20);
+    }
+
+    void ComputeEntry(uint256 &entry, const uint256 &spendHash, uint32_t pubcoinId, const uint256 &txHash, int denomination, const CBigNum &accumulatorValue)
+    {
+        std::vector<unsigned char> vchAccumulator = accumulatorValue.getvch();
+        unsigned char buf[8];
+        WriteLE32(buf, pubcoinId);
+        WriteLE32(buf + 4, denomination);
+        CSHA256().Write(nonce.begin(), 32)
+                .Write(spendHash.begin(), 32)
+                .Write(txHash.begin(), 32)
+                .Write(buf, sizeof(buf))
+                .Write(vchAccumulator.data(), vchAccumulator.size())
+                .Finalize(entry.begin());
+    }
+
+    bool Get(const uint256 &entry)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_spendcache);
+        return setValid.contains(entry, false);
+    }
+
+    void Set(uint256 &entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_spendcache);
+        setValid.insert(entry);
+    }
+};
+
+static CZerocoinSpendCache zerocoinSpendCache;
+} // namespace
+
+bool CZerocoinSpendCheck::operator()() {
+    libzerocoin::SpendMetaData metaData(pubcoinId, txHash);
+    for (const CBigNum &accumulatorValue : accumulatorValues) {
+        uint256 entry;
+        zerocoinSpendCache.ComputeEntry(entry, spendHash, pubcoinId, txHash, denomination, accumulatorValue);
+        if (zerocoinSpendCache.Get(entry))
+            return true;
+
+        libzerocoin::Accumulator accumulator(ZCParams, accumulatorValue, (libzerocoin::CoinDenomination)denomination);
+        LogPrintf("CheckSpendZerocoinTransaction: accumulator=%s\n", accumulator.getValue().ToString().substr(0,15));
+        if (spend->Verify(accumulator, metaData)) {
+            zerocoinSpendCache.Set(entry);
+            return true;
+        }
+    }
+    return false;
+}
+
+void CZerocoinSpendCheck::swap(CZerocoinSpendCheck &check) {
+    spend.swap(check.spend);
+    std::swap(spendHash, check.spendHash);
+    std::swap(pubcoinId, check.pubcoinId);
+    std::swap(txHash, check.txHash);
+    std::swap(denomination, check.denomination);
+    accumulatorValues.swap(check.accumulatorValues);
+}
+
+// Add the accumulator value of the coin group as of block index to values, if that block changed it
+static void GetAccumulatorChange(const CBlockIndex *index, const pair<int,int> &denominationAndId, vector<CBigNum> &values) {
+    std::shared_ptr<const CBlockZerocoinData> zcData = pblocktree->ReadZerocoinData(index);
+    auto itAccChange = zcData->accumulatorChanges.find(denominationAndId);
+    if (itAccChange != zcData->accumulatorChanges.end())
+        values.push_back(itAccChange->second.first);
+}
+
 static bool CheckZerocoinSpendSerial(CValidationState &state, CZerocoinTxInfo *zerocoinTxInfo, libzerocoin::CoinDenomination denomination, const CBigNum &serial, int nHeight, bool fConnectTip) {
     // check for zerocoin transaction in this block as well
     if (zerocoinTxInfo && !zerocoinTxInfo->fInfoIsComplete && zerocoinTxInfo->spentSerials.count(serial) > 0)
@@ -81,7 +176,8 @@ bool CheckSpendZerocoinTransaction(const CTransaction &tx,
     CDataStream serializedCoinSpend((const char *)&*(txin.scriptSig.begin() + 4),
                                     (const char *)&*txin.scriptSig.end(),
                                     SER_NETWORK, PROTOCOL_VERSION);
-    libzerocoin::CoinSpend newSpend(ZCParams, serializedCoinSpend);
+    std::shared_ptr<libzerocoin::CoinSpend> pSpend = std::make_shared<libzerocoin::CoinSpend>(ZCParams, serializedCoinSpend);
+    libzerocoin::CoinSpend &newSpend = *pSpend;
 
     int spendVersion = newSpend.getVersion();
     if (spendVersion != ZEROCOIN_VERSION_1) {
@@ -114,7 +210,6 @@ bool CheckSpendZerocoinTransaction(const CTransaction &tx,
     }
 
 
-    libzerocoin::SpendMetaData newMetadata(txin.nSequence, txHashForMetadata);
 
 
     CZerocoinState::CoinGroupInfo coinGroup;
@@ -124,38 +219,51 @@ bool CheckSpendZerocoinTransaction(const CTransaction &tx,
     bool passVerify = false;
     CBlockIndex *index = coinGroup.lastBlock;
     pair<int,int> denominationAndId = make_pair(targetDenomination, pubcoinId);
-
-
-    bool spendHasBlockHash;
+    // Accumulator values the spend may have been built on, latest first
+    vector<CBigNum> accumulatorValues;
 
     // Zerocoin  transaction can cointain block hash of the last mint tx seen at the moment of spend. It speeds
     // up verification
     if (spendVersion >= ZEROCOIN_VERSION_1 && !newSpend.getAccumulatorBlockHash().IsNull()) {
-        spendHasBlockHash = true;
-        uint256 accumulatorBlockHash = newSpend.getAccumulatorBlockHash();
-
-        // find index for block with hash of accumulatorBlockHash or set index to the coinGroup.firstBlock if not found
-        while (index != coinGroup.firstBlock && index->GetBlockHash() != accumulatorBlockHash)
-            index = index->pprev;
+        // Verify against the accumulator as of that block if it is part of the coin group, or as of
+        // coinGroup.firstBlock if not
+        index = coinGroup.firstBlock;
+        BlockMap::const_iterator mi = mapBlockIndex.find(newSpend.getAccumulatorBlockHash());
+        if (mi != mapBlockIndex.end() && mi->second->nHeight > coinGroup.firstBlock->nHeight &&
+                mi->second->nHeight <= coinGroup.lastBlock->nHeight &&
+                coinGroup.lastBlock->GetAncestor(mi->second->nHeight) == mi->second)
+            index = mi->second;
+
+        GetAccumulatorChange(index, denominationAndId, accumulatorValues);
     }
-
-    // Enumerate all the accumulator changes seen in the blockchain starting with the latest block
-    // In most cases the latest accumulator value will be used for verification
-    do {
-        if (index->accumulatorChanges.count(denominationAndId) > 0) {
-            libzerocoin::Accumulator accumulator(ZCParams,
-                                                 index->accumulatorChanges[denominationAndId].first,
-                                                 targetDenomination);
-            LogPrintf("CheckSpendZerocoinTransaction: accumulator=%s\n", accumulator.getValue().ToString().substr(0,15));
-            passVerify = newSpend.Verify(accumulator, newMetadata);
-
+    else if (nHeight == INT_MAX && !zerocoinTxInfo) {
+        // Without the block hash every accumulator of the coin group may have to be tried, do not
+        // let memory pool transactions make us do that
+        return state.DoS(0, false, REJECT_NONSTANDARD, "CheckSpendZerocoinTransaction: spend without accumulator block hash");
+    }
+    else {
+        // Enumerate all the accumulator changes seen in the blockchain starting with the latest block
+        // In most cases the latest accumulator value will be used for verification
+        for (;;) {
+            GetAccumulatorChange(index, denominationAndId, accumulatorValues);
+            if (index == coinGroup.firstBlock)
+                break;
+            index = index->pprev;
         }
+    }
 
-        if (index == coinGroup.firstBlock || spendHasBlockHash)
-            break;
-        else
-            index = index->pprev;
-    } while (!passVerify);
+    uint256 spendHash;
+    CSHA256().Write(txin.scriptSig.data() + 4, txin.scriptSig.size() - 4).Finalize(spendHash.begin());
+    CZerocoinSpendCheck check(pSpend, spendHash, pubcoinId, txHashForMetadata, targetDenomination, std::move(accumulatorValues));
+    if (zerocoinTxInfo && zerocoinTxInfo->fDeferSpendChecks) {
+        // Verified with the rest of the block's spends, see CheckBlock
+        zerocoinTxInfo->spendChecks.push_back(CZerocoinSpendCheck());
+        zerocoinTxInfo->spendChecks.back().swap(check);
+        passVerify = true;
+    }
+    else {
+        passVerify = check();
+    }
 
     if (passVerify) {
 
@@ -351,6 +459,12 @@ bool CheckZerocoinTransaction(const CTransaction &tx,
     return true;
 }
 
+// Whether zerocoinState covers chainActive. Until ZerocoinBuildStateFromIndex
+// runs on the loaded chain it does not, and must not be stored.
+static bool fZerocoinStateComplete = false;
+// Block of the zerocoin state stored in the block tree database, null if the stored state is stale
+static uint256 hashZerocoinStateSnapshot;
+
 void DisconnectTipShade(CBlock & /*block*/, CBlockIndex *pindexDelete) {
     zerocoinState.RemoveBlock(pindexDelete);
 }
@@ -362,28 +476,50 @@ void DisconnectTipShade(CBlock & /*block*/, CBlockIndex *pindexDelete) {
  */
 bool ConnectBlockShade(CValidationState &state, const CChainParams &chainparams, CBlockIndex *pindexNew, const CBlock *pblock) {
 
+    // TestBlockValidity connects a dummy index that is not in mapBlockIndex
+    // (no phashBlock). Check its spends but leave the zerocoin state and
+    // store alone, the state is persisted and must only reflect the chain.
+    const bool fJustCheck = pindexNew->phashBlock == NULL;
+
+    // A chain synced from genesis builds the state block by block
+    if (!fJustCheck && pindexNew->nHeight == 1)
+        fZerocoinStateComplete = true;
+
     // Add zerocoin transaction information to index
     if (pblock && pblock->zerocoinTxInfo) {
 
-        pindexNew->spentSerials.clear();
+        // Only touch the zerocoin store for blocks with zerocoin activity
+        const CZerocoinTxInfo &zcInfo = *pblock->zerocoinTxInfo;
+        bool fStore = !fJustCheck &&
+                (!zcInfo.spentSerials.empty() || !zcInfo.mints.empty() || (pindexNew->nStatus & BLOCK_HAVE_ZEROCOIN));
+        // Built on a copy, published to the store once complete
+        CBlockZerocoinData zcData;
+        if (fStore)
+            zcData = *pblocktree->ReadZerocoinData(pindexNew);
+
+        zcData.spentSerials.clear();
 
         BOOST_FOREACH(const PAIRTYPE(CBigNum,int) &serial, pblock->zerocoinTxInfo->spentSerials) {
-            pindexNew->spentSerials.insert(serial.first);
+            zcData.spentSerials.insert(serial.first);
             if (!CheckZerocoinSpendSerial(state, pblock->zerocoinTxInfo.get(), (libzerocoin::CoinDenomination)serial.second, serial.first, pindexNew->nHeight, true))
                 return false;
-            zerocoinState.AddSpend(serial.first);
+            if (!fJustCheck)
+                zerocoinState.AddSpend(serial.first);
         }
 
+        if (fJustCheck)
+            return true;
+
 
         // Update minted values and accumulators
         BOOST_FOREACH(const PAIRTYPE(int,CBigNum) &mint, pblock->zerocoinTxInfo->mints) {
             int denomination = mint.first;
             CBigNum oldAccValue = ZCParams->accumulatorParams.accumulatorBase;
-            int mintId = zerocoinState.AddMint(pindexNew, denomination, mint.second, oldAccValue);
+            int mintId = zerocoinState.AddMint(pindexNew, &zcData, denomination, mint.second, oldAccValue);
             LogPrintf("ConnectTipZC: mint added denomination=%d, id=%d\n", denomination, mintId);
             pair<int,int> denomAndId = make_pair(denomination, mintId);
 
-            pindexNew->mintedPubCoins[denomAndId].push_back(mint.second);
+            zcData.mintedPubCoins[denomAndId].push_back(mint.second);
 
             CZerocoinState::CoinGroupInfo coinGroupInfo;
             zerocoinState.GetCoinGroupInfo(denomination, mintId, coinGroupInfo);
@@ -394,17 +530,20 @@ bool ConnectBlockShade(CValidationState &state, const CChainParams &chainparams,
                                                  (libzerocoin::CoinDenomination)denomination);
             accumulator += pubCoin;
 
-            if (pindexNew->accumulatorChanges.count(denomAndId) > 0) {
-                pair<CBigNum,int> &accChange = pindexNew->accumulatorChanges[denomAndId];
+            if (zcData.accumulatorChanges.count(denomAndId) > 0) {
+                pair<CBigNum,int> &accChange = zcData.accumulatorChanges[denomAndId];
                 accChange.first = accumulator.getValue();
                 accChange.second++;
             }
             else {
-                pindexNew->accumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), 1);
+                zcData.accumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), 1);
             }
         }
+
+        if (fStore)
+            pblocktree->ModifyZerocoinData(pindexNew, [&zcData](CBlockZerocoinData& data) { data = std::move(zcData); });
     }
-    else {
+    else if (!fJustCheck) {
         zerocoinState.AddBlock(pindexNew);
     }
 
@@ -427,10 +566,34 @@ int ZerocoinGetNHeight(const CBlockHeader &block) {
 bool ZerocoinBuildStateFromIndex(CChain *chain, set<CBlockIndex *> &changes) {
 
     zerocoinState.Reset();
-    for (CBlockIndex *blockIndex = chain->Genesis(); blockIndex; blockIndex=chain->Next(blockIndex))
+    hashZerocoinStateSnapshot.SetNull();
+    // While the block index is loaded chainActive is still empty
+    fZerocoinStateComplete = chain->Tip() != NULL;
+
+    // Resume from the stored state if it is on the chain, otherwise rebuild it
+    CBlockIndex *pindexStart = chain->Genesis();
+    if (chain->Tip() && !gArgs.GetBoolArg("-zerocoinrebuild", DEFAULT_ZEROCOIN_REBUILD)) {
+        CZerocoinStateSnapshot snapshot(&zerocoinState);
+        BlockMap::iterator mi;
+        if (pblocktree->ReadZerocoinState(snapshot) &&
+                (mi = mapBlockIndex.find(snapshot.hashBlock)) != mapBlockIndex.end() &&
+                chain->Contains(mi->second)) {
+            LogPrintf("ZerocoinState: loaded state at height %d, replaying %d blocks\n",
+                      mi->second->nHeight, chain->Height() - mi->second->nHeight);
+            pindexStart = chain->Next(mi->second);
+            hashZerocoinStateSnapshot = snapshot.hashBlock;
+        }
+        else {
+            zerocoinState.Reset();
+        }
+    }
+
+    for (CBlockIndex *blockIndex = pindexStart; blockIndex; blockIndex=chain->Next(blockIndex))
         zerocoinState.AddBlock(blockIndex);
 
-    changes = zerocoinState.RecalculateAccumulators(chain);
+    // The stored state was built from recalculated accumulators already
+    if (pindexStart == chain->Genesis())
+        changes = zerocoinState.RecalculateAccumulators(chain);
     // DEBUG
     LogPrintf("Latest IDs are %d, %d, %d, %d, %d, %d, %d, %d\n",
             zerocoinState.latestCoinIds[1],
@@ -444,6 +607,18 @@ bool ZerocoinBuildStateFromIndex(CChain *chain, set<CBlockIndex *> &changes) {
     return true;
 }
 
+bool ZerocoinWriteStateSnapshot(const uint256 &hashBlock) {
+    if (!fZerocoinStateComplete || hashBlock == hashZerocoinStateSnapshot)
+        return true;
+
+    CZerocoinStateSnapshot snapshot(&zerocoinState);
+    snapshot.hashBlock = hashBlock;
+    if (!pblocktree->WriteZerocoinState(snapshot))
+        return false;
+    hashZerocoinStateSnapshot = hashBlock;
+    return true;
+}
+
 // CZerocoinTxInfo
 
 void CZerocoinTxInfo::Complete() {
@@ -478,7 +653,7 @@ std::size_t CZerocoinState::CBigNumHash::operator ()(const CBigNum &bn) const no
 CZerocoinState::CZerocoinState() {
 }
 
-int CZerocoinState::AddMint(CBlockIndex *index, int denomination, const CBigNum &pubCoin, CBigNum &previousAccValue) {
+int CZerocoinState::AddMint(CBlockIndex *index, const CBlockZerocoinData *indexData, int denomination, const CBigNum &pubCoin, CBigNum &previousAccValue) {
 
     int mintId = 1;
 
@@ -497,7 +672,13 @@ int CZerocoinState::AddMint(CBlockIndex *index, int denomination, const CBigNum
             coinGroup.firstBlock = coinGroup.lastBlock = index;
         }
         else {
-            previousAccValue = coinGroup.lastBlock->accumulatorChanges[make_pair(denomination,mintId)].first;
+            // the previous mint may be in the block being added, whose data is not stored yet
+            std::shared_ptr<const CBlockZerocoinData> lastData;
+            if (coinGroup.lastBlock != index)
+                lastData = pblocktree->ReadZerocoinData(coinGroup.lastBlock);
+            const CBlockZerocoinData &lastBlockData = lastData ? *lastData : *indexData;
+            auto itAccChange = lastBlockData.accumulatorChanges.find(make_pair(denomination,mintId));
+            previousAccValue = itAccChange != lastBlockData.accumulatorChanges.end() ? itAccChange->second.first : CBigNum(0);
             coinGroup.lastBlock = index;
         }
     }
@@ -522,7 +703,9 @@ void CZerocoinState::AddSpend(const CBigNum &serial) {
 }
 
 void CZerocoinState::AddBlock(CBlockIndex *index) {
-    for(const pair<pair<int,int>, pair<CBigNum,int>> &accUpdate: index->accumulatorChanges)
+    std::shared_ptr<const CBlockZerocoinData> zcData = pblocktree->ReadZerocoinData(index);
+
+    for(const pair<pair<int,int>, pair<CBigNum,int>> &accUpdate: zcData->accumulatorChanges)
     {
         CoinGroupInfo   &coinGroup = coinGroups[accUpdate.first];
 
@@ -532,7 +715,7 @@ void CZerocoinState::AddBlock(CBlockIndex *index) {
         coinGroup.nCoins += accUpdate.second.second;
     }
 
-    for(const pair<pair<int,int>,vector<CBigNum>> &pubCoins: index->mintedPubCoins) {
+    for(const pair<pair<int,int>,vector<CBigNum>> &pubCoins: zcData->mintedPubCoins) {
         latestCoinIds[pubCoins.first.first] = pubCoins.first.second;
         BOOST_FOREACH(const CBigNum &coin, pubCoins.second) {
             CMintedCoinInfo coinInfo;
@@ -542,15 +725,17 @@ void CZerocoinState::AddBlock(CBlockIndex *index) {
             mintedPubCoins.insert(pair<CBigNum,CMintedCoinInfo>(coin, coinInfo));
         }
     }
-    BOOST_FOREACH(const CBigNum &serial, index->spentSerials) {
+    BOOST_FOREACH(const CBigNum &serial, zcData->spentSerials) {
         usedCoinSerials.insert(serial);
     }
 
 }
 
 void CZerocoinState::RemoveBlock(CBlockIndex *index) {
+    std::shared_ptr<const CBlockZerocoinData> zcData = pblocktree->ReadZerocoinData(index);
+
     // roll back accumulator updates
-    for(const pair<pair<int,int>, pair<CBigNum,int>> &accUpdate: index->accumulatorChanges)
+    for(const pair<pair<int,int>, pair<CBigNum,int>> &accUpdate: zcData->accumulatorChanges)
     {
         CoinGroupInfo   &coinGroup = coinGroups[accUpdate.first];
         int  nMintsToForget = accUpdate.second.second;
@@ -568,12 +753,12 @@ void CZerocoinState::RemoveBlock(CBlockIndex *index) {
             do {
                 assert(coinGroup.lastBlock != coinGroup.firstBlock);
                 coinGroup.lastBlock = coinGroup.lastBlock->pprev;
-            } while (coinGroup.lastBlock->accumulatorChanges.count(accUpdate.first) == 0);
+            } while (pblocktree->ReadZerocoinData(coinGroup.lastBlock)->accumulatorChanges.count(accUpdate.first) == 0);
         }
     }
 
     // roll back mints
-    for(const pair<pair<int,int>,vector<CBigNum>> &pubCoins: index->mintedPubCoins) {
+    for(const pair<pair<int,int>,vector<CBigNum>> &pubCoins: zcData->mintedPubCoins) {
         BOOST_FOREACH(const CBigNum &coin, pubCoins.second) {
             auto coins = mintedPubCoins.equal_range(coin);
             auto coinIt = find_if(coins.first, coins.second, [=](const decltype(mintedPubCoins)::value_type &v) {
@@ -586,7 +771,7 @@ void CZerocoinState::RemoveBlock(CBlockIndex *index) {
     }
 
     // roll back spends
-    BOOST_FOREACH(const CBigNum &serial, index->spentSerials) {
+    BOOST_FOREACH(const CBigNum &serial, zcData->spentSerials) {
         usedCoinSerials.erase(serial);
     }
 }
@@ -617,25 +802,22 @@ int CZerocoinState::GetAccumulatorValueForSpend(CChain *chain, int maxHeight, in
     CoinGroupInfo coinGroup = coinGroups[denomAndId];
     CBlockIndex *lastBlock = coinGroup.lastBlock;
 
-    assert(lastBlock->accumulatorChanges.count(denomAndId) > 0);
-    assert(coinGroup.firstBlock->accumulatorChanges.count(denomAndId) > 0);
-
-    // field in the block index structure for accesing accumulator changes
-    decltype(&CBlockIndex::accumulatorChanges) accChangeField;
-    accChangeField = &CBlockIndex::accumulatorChanges;
+    assert(pblocktree->ReadZerocoinData(lastBlock)->accumulatorChanges.count(denomAndId) > 0);
+    assert(pblocktree->ReadZerocoinData(coinGroup.firstBlock)->accumulatorChanges.count(denomAndId) > 0);
 
     int numberOfCoins = 0;
     for (;;) {
-        map<pair<int,int>, pair<CBigNum,int>> &accumulatorChanges = lastBlock->*accChangeField;
-        if (accumulatorChanges.count(denomAndId) > 0) {
+        std::shared_ptr<const CBlockZerocoinData> zcData = pblocktree->ReadZerocoinData(lastBlock);
+        auto itAccChange = zcData->accumulatorChanges.find(denomAndId);
+        if (itAccChange != zcData->accumulatorChanges.end()) {
             if (lastBlock->nHeight <= maxHeight) {
                 if (numberOfCoins == 0) {
                     // latest block satisfying given conditions
                     // remember accumulator value and block hash
-                    accumulator = accumulatorChanges[denomAndId].first;
+                    accumulator = itAccChange->second.first;
                     blockHash = lastBlock->GetBlockHash();
                 }
-                numberOfCoins += accumulatorChanges[denomAndId].second;
+                numberOfCoins += itAccChange->second.second;
             }
         }
         if (lastBlock == coinGroup.firstBlock)
@@ -665,17 +847,20 @@ libzerocoin::AccumulatorWitness CZerocoinState::GetWitnessForSpend(CChain *chain
     CBlockIndex *block = mintBlock;
     libzerocoin::Accumulator accumulator(ZCParams, d);
     if (block != coinGroup.firstBlock) {
+        std::shared_ptr<const CBlockZerocoinData> zcData;
         do {
             block = block->pprev;
-        } while (block->accumulatorChanges.count(denomAndId) == 0);
-        accumulator = libzerocoin::Accumulator(ZCParams, block->accumulatorChanges[denomAndId].first, d);
+            zcData = pblocktree->ReadZerocoinData(block);
+        } while (zcData->accumulatorChanges.count(denomAndId) == 0);
+        accumulator = libzerocoin::Accumulator(ZCParams, zcData->accumulatorChanges.at(denomAndId).first, d);
     }
 
     // Now add to the accumulator every coin minted since that moment except pubCoin
     block = coinGroup.lastBlock;
     while(true) {
-        if (block->nHeight <= maxHeight && block->mintedPubCoins.count(denomAndId) > 0) {
-            vector<CBigNum> &pubCoins = block->mintedPubCoins[denomAndId];
+        std::shared_ptr<const CBlockZerocoinData> zcData = pblocktree->ReadZerocoinData(block);
+        if (block->nHeight <= maxHeight && zcData->mintedPubCoins.count(denomAndId) > 0) {
+            const vector<CBigNum> &pubCoins = zcData->mintedPubCoins.at(denomAndId);
             for (const CBigNum &coin: pubCoins) {
                 if (block != mintBlock || coin != pubCoin)
                     accumulator += libzerocoin::PublicCoin(ZCParams, coin, d);
@@ -760,22 +945,23 @@ bool CZerocoinState::TestValidity(CChain *chain) {
 
         CBlockIndex *block = coinGroup.second.firstBlock;
         for (;;) {
-            if (block->accumulatorChanges.count(coinGroup.first) > 0) {
-                if (block->mintedPubCoins.count(coinGroup.first) == 0) {
+            std::shared_ptr<const CBlockZerocoinData> zcData = pblocktree->ReadZerocoinData(block);
+            if (zcData->accumulatorChanges.count(coinGroup.first) > 0) {
+                if (zcData->mintedPubCoins.count(coinGroup.first) == 0) {
                     fprintf(stderr, "  no minted coins\n");
                     return false;
                 }
 
-                BOOST_FOREACH(const CBigNum &pubCoin, block->mintedPubCoins[coinGroup.first]) {
+                BOOST_FOREACH(const CBigNum &pubCoin, zcData->mintedPubCoins.at(coinGroup.first)) {
                     acc += libzerocoin::PublicCoin(zcParams, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first);
                 }
 
-                if (acc.getValue() != block->accumulatorChanges[coinGroup.first].first) {
+                if (acc.getValue() != zcData->accumulatorChanges.at(coinGroup.first).first) {
                     fprintf (stderr, "  accumulator value mismatch at height %d\n", block->nHeight);
                     return false;
                 }
 
-                if (block->accumulatorChanges[coinGroup.first].second != (int)block->mintedPubCoins[coinGroup.first].size()) {
+                if (zcData->accumulatorChanges.at(coinGroup.first).second != (int)zcData->mintedPubCoins.at(coinGroup.first).size()) {
                     fprintf(stderr, "  number of minted coins mismatch at height %d\n", block->nHeight);
                     return false;
                 }
@@ -803,14 +989,18 @@ set<CBlockIndex *> CZerocoinState::RecalculateAccumulators(CChain *chain) {
         // Try to calculate accumulator for the first batch of mints. If it doesn't match we need to recalculate the rest of it
         CBlockIndex *block = coinGroup.second.firstBlock;
         for (;;) {
-            if (block->accumulatorChanges.count(coinGroup.first) > 0) {
-                BOOST_FOREACH(const CBigNum &pubCoin, block->mintedPubCoins[coinGroup.first]) {
+            std::shared_ptr<const CBlockZerocoinData> zcData = pblocktree->ReadZerocoinData(block);
+            if (zcData->accumulatorChanges.count(coinGroup.first) > 0) {
+                static const vector<CBigNum> noCoins;
+                auto itMints = zcData->mintedPubCoins.find(coinGroup.first);
+                const vector<CBigNum> &pubCoins = itMints != zcData->mintedPubCoins.end() ? itMints->second : noCoins;
+                BOOST_FOREACH(const CBigNum &pubCoin, pubCoins) {
                     acc += libzerocoin::PublicCoin(ZCParams, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first);
                 }
 
                 // First block case is special: do the check
                 if (block == coinGroup.second.firstBlock) {
-                    if (acc.getValue() != block->accumulatorChanges[coinGroup.first].first)
+                    if (acc.getValue() != zcData->accumulatorChanges.at(coinGroup.first).first)
                         // recalculation is needed
                         LogPrintf("ZerocoinState: accumulator recalculation for denomination=%d, id=%d\n", coinGroup.first.first, coinGroup.first.second);
                     else
@@ -818,7 +1008,8 @@ set<CBlockIndex *> CZerocoinState::RecalculateAccumulators(CChain *chain) {
                         break;
                 }
 
-                block->accumulatorChanges[coinGroup.first] = make_pair(acc.getValue(), (int)block->mintedPubCoins[coinGroup.first].size());
+                std::pair<CBigNum,int> accChange = make_pair(acc.getValue(), (int)pubCoins.size());
+                pblocktree->ModifyZerocoinData(block, [&](CBlockZerocoinData& data) { data.accumulatorChanges[coinGroup.first] = accChange; });
                 changes.insert(block);
             }
 
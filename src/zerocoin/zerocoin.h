@@ -8,18 +8,52 @@
 #include "chain.h"
 #include "chainparams.h"
 #include "libzerocoin/Zerocoin.h"
+#include "serialize.h"
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 
 #define ZEROCOIN_MODULUS   "C7970CEEDCC3B0754490201A7AA613CD73911081C790F5F1A8726F463550BB5B7FF0DB8E1EA1189EC72F93D1650011BD721AEEACC2ACDE32A04107F0648C2813A31F5B0B7765FF8B44B4B6FFC93384B646EB09C7CF5E8592D40EA33C80039F35B4F14A04B51F7BFD781BE4D1673164BA8EB991C2C4D730BBBE35F592BDEF524AF7E8DAEFD26C66FC02C479AF89D64D373F442709439DE66CEB955F3EA37D5159F6135809F85334B5CB1813ADDC80CD05609F10AC6A95AD65872C909525BDAD32BC729592642920F24C61DC5B3C3B7923E56B16A4D9D373D8721F24A3FC0F1B3131F55615172866BCCC30F95054C824E733A5EB6817F7BC16399D48C6361CC7E5"
 #define ZEROCOIN_SEED   "25195908475657893494027183240048398571429282126204032027777137836043662020707595556264018525880784406918290641249515082189298559149176184502808489120072844992687392807287776735971418347270261896375014971824691165077613379859095700097330459748808428401797429100642458691817195118746121515172654632282216869987549182422433637259085141865462043576798423387184774447920739934236584823824281198163815010674810451660377306056201619676256133844143603833904414952634432190114657544454178424020924616515723350778707749817125772467962926386356373289912154831438167899885040445364023527381951378636564391212010397122822120720357"
 
+// -zerocoinrebuild default: rebuild the zerocoin state from the whole chain at startup
+static const bool DEFAULT_ZEROCOIN_REBUILD = false;
+// Memory for verified zerocoin spend proofs, in MiB
+static const unsigned int DEFAULT_ZEROCOIN_SPEND_CACHE_SIZE = 1;
+
 // Zerocoin transaction info, added to the CBlock to ensure zerocoin mint/spend transactions got their info stored into
 // index
 // zerocoin parameters
 extern libzerocoin::Params *ZCParams;
 
+/*
+ * Verification of a zerocoin spend proof against the accumulator values it may
+ * have been built on, tried in order. Run through CCheckQueue for block spends
+ */
+class CZerocoinSpendCheck {
+private:
+    std::shared_ptr<const libzerocoin::CoinSpend> spend;
+    // hash of the serialized spend, for the verified spend cache
+    uint256 spendHash;
+    // spend metadata
+    uint32_t pubcoinId;
+    uint256 txHash;
+    int denomination;
+    vector<CBigNum> accumulatorValues;
+
+public:
+    CZerocoinSpendCheck() : pubcoinId(0), denomination(0) {}
+    CZerocoinSpendCheck(std::shared_ptr<const libzerocoin::CoinSpend> spendIn, const uint256 &spendHashIn, uint32_t pubcoinIdIn,
+                        const uint256 &txHashIn, int denominationIn, vector<CBigNum> &&accumulatorValuesIn) :
+        spend(std::move(spendIn)), spendHash(spendHashIn), pubcoinId(pubcoinIdIn), txHash(txHashIn),
+        denomination(denominationIn), accumulatorValues(std::move(accumulatorValuesIn)) {}
+
+    bool operator()();
+
+    void swap(CZerocoinSpendCheck &check);
+};
+
 class CZerocoinTxInfo {
 public:
     // all the zerocoin transactions encountered so far
@@ -30,8 +64,11 @@ public:
     map<CBigNum, int> spentSerials;
     // information about transactions in the block is complete
     bool fInfoIsComplete;
+    // queue spend proofs in spendChecks instead of verifying them right away
+    bool fDeferSpendChecks;
+    vector<CZerocoinSpendCheck> spendChecks;
 
-    CZerocoinTxInfo(): fInfoIsComplete(false) {}
+    CZerocoinTxInfo(): fInfoIsComplete(false), fDeferSpendChecks(false) {}
     // finalize everything
     void Complete();
 };
@@ -51,6 +88,8 @@ bool ConnectBlockShade(CValidationState &state, const CChainParams &chainparams,
 int ZerocoinGetNHeight(const CBlockHeader &block);
 
 bool ZerocoinBuildStateFromIndex(CChain *chain, set<CBlockIndex *> &changes);
+// Store the zerocoin state as of block hashBlock unless it is already stored
+bool ZerocoinWriteStateSnapshot(const uint256 &hashBlock);
 
 CBigNum ZerocoinGetSpendSerialNumber(const CTransaction &tx, int i);
 
@@ -101,8 +140,9 @@ public:
     // serials of mints currently in the mempool mapped to tx hashes
     unordered_map<CBigNum,uint256,CBigNumHash> mempoolCoinMints;
 
-    // Add mint, automatically assigning id to it. Returns id and previous accumulator value (if any)
-    int AddMint(CBlockIndex *index, int denomination, const CBigNum &pubCoin, CBigNum &previousAccValue);
+    // Add mint, automatically assigning id to it. Returns id and previous accumulator value (if any).
+    // indexData is the zerocoin data of index being built, it is not in the block tree store yet
+    int AddMint(CBlockIndex *index, const CBlockZerocoinData *indexData, int denomination, const CBigNum &pubCoin, CBigNum &previousAccValue);
     // Add serial to the list of used ones
     void AddSpend(const CBigNum &serial);
 
@@ -169,6 +209,74 @@ public:
     // Remove mint from the mempool (usually as the result of adding tx to the block)
     void RemoveMintFromMempool(const CBigNum &coinMint);
 
+    // Chain state only, mempool entries are not serialized. Blocks are stored by hash
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        WriteCompactSize(s, coinGroups.size());
+        for (const auto &coinGroup : coinGroups)
+            s << coinGroup.first << coinGroup.second.firstBlock->GetBlockHash() << coinGroup.second.lastBlock->GetBlockHash() << coinGroup.second.nCoins;
+        WriteCompactSize(s, mintedPubCoins.size());
+        for (const auto &coin : mintedPubCoins)
+            s << coin.first << coin.second.denomination << coin.second.id << coin.second.nHeight;
+        WriteCompactSize(s, usedCoinSerials.size());
+        for (const CBigNum &serial : usedCoinSerials)
+            s << serial;
+        s << latestCoinIds;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s) {
+        Reset();
+        for (uint64_t n = ReadCompactSize(s); n > 0; n--) {
+            pair<int,int> denomAndId;
+            uint256 hashFirst, hashLast;
+            s >> denomAndId;
+            CoinGroupInfo &coinGroup = coinGroups[denomAndId];
+            s >> hashFirst >> hashLast >> coinGroup.nCoins;
+            BlockMap::const_iterator itFirst = mapBlockIndex.find(hashFirst), itLast = mapBlockIndex.find(hashLast);
+            if (itFirst == mapBlockIndex.end() || itLast == mapBlockIndex.end())
+                throw std::ios_base::failure("CZerocoinState: unknown block in coin group");
+            coinGroup.firstBlock = itFirst->second;
+            coinGroup.lastBlock = itLast->second;
+        }
+        for (uint64_t n = ReadCompactSize(s); n > 0; n--) {
+            CBigNum pubCoin;
+            CMintedCoinInfo coinInfo;
+            s >> pubCoin >> coinInfo.denomination >> coinInfo.id >> coinInfo.nHeight;
+            mintedPubCoins.insert(make_pair(pubCoin, coinInfo));
+        }
+        for (uint64_t n = ReadCompactSize(s); n > 0; n--) {
+            CBigNum serial;
+            s >> serial;
+            usedCoinSerials.insert(serial);
+        }
+        s >> latestCoinIds;
+    }
+};
+
+/*
+ * CZerocoinState as of block hashBlock, as stored in the block tree database
+ */
+class CZerocoinStateSnapshot {
+public:
+    static const int CURRENT_VERSION = 1;
+
+    int nVersion;
+    uint256 hashBlock;
+    CZerocoinState *state;
+
+    explicit CZerocoinStateSnapshot(CZerocoinState *stateIn) : nVersion(CURRENT_VERSION), state(stateIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(nVersion);
+        if (ser_action.ForRead() && nVersion != CURRENT_VERSION)
+            throw std::ios_base::failure("CZerocoinStateSnapshot: unknown version");
+        READWRITE(hashBlock);
+        READWRITE(*state);
+    }
 };
 
 uint64_t TotalShaded();